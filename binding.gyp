@@ -2,14 +2,15 @@
   "targets": [
     {
       "target_name": "swarmmind_engine",
-      "sources": ["src/engine.cpp"],
+      "sources": ["src/engine.cpp", "src/lz.cpp", "src/broadcast.cpp", "src/netserver.cpp", "src/spectator.cpp", "src/recorder.cpp", "src/replay.cpp", "src/reference_engine.cpp", "src/differential.cpp", "src/handoff.cpp", "src/hibernate.cpp", "src/arena.cpp"],
       "cflags!": ["-fno-exceptions"],
       "cflags_cc!": ["-fno-exceptions"],
       "cflags_cc": ["-std=c++17", "-O3"],
       "defines": ["NAPI_DISABLE_CPP_EXCEPTIONS", "NAPI_VERSION=8"],
       "conditions": [
         ["OS=='linux'", {
-          "cflags_cc": ["-std=c++17", "-O3"]
+          "cflags_cc": ["-std=c++17", "-O3"],
+          "ldflags": ["-Wl,-Bsymbolic-functions"]
         }],
         ["OS=='mac'", {
           "xcode_settings": {
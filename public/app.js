@@ -10,11 +10,14 @@
     let mapWidth = 4000;
     let mapHeight = 4000;
     let tickRate = 20;
+    let payloadCompressed = false;
 
     let prevState = null;
     let currState = null;
+    let minimapGrid = null;
     let lastStateTime = 0;
     let interpFactor = 0;
+    let latencyMs = 0;
 
     let mouseWorldX = 0;
     let mouseWorldY = 0;
@@ -481,13 +484,22 @@
         const readF32 = () => { const v = view.getFloat32(offset, true); offset += 4; return v; };
         const readU8  = () => { const v = view.getUint8(offset); offset += 1; return v; };
         const readI8  = () => { const v = view.getInt8(offset); offset += 1; return v; };
+        // Zigzag LEB128 delta against the previous id in the same section
+        const readId = (prev) => {
+            let v = 0, shift = 0, b;
+            do { b = view.getUint8(offset++); v += (b & 0x7f) * 2 ** shift; shift += 7; } while (b & 0x80);
+            const delta = (v % 2) ? -(v + 1) / 2 : v / 2;
+            return (prev + delta) >>> 0;
+        };
 
         const mw = readU16();
         const mh = readU16();
         const numPlayers = readU16();
-        const numBoids = readU16();
+        const numSwarms = readU16();
         const numResources = readU16();
         const numPickups = readU16();
+        const numImpostors = readU16();
+        const tick = readU32();
 
         const players = [];
         for (let i = 0; i < numPlayers; i++) {
@@ -496,30 +508,171 @@
                 boosting: readU8() === 1, boostFuel: readF32(),
                 speed: readF32(), cohesion: readF32(),
                 aggression: readF32(), collectRange: readF32(),
-                shieldTicks: readU8(), speedBurstTicks: readU8(), slowTicks: readU8()
+                shieldTicks: readU8(), speedBurstTicks: readU8(), slowTicks: readU8(),
+                ackSeq: readU16(), ackTime: readU32()
             });
         }
 
         const boids = [];
-        for (let i = 0; i < numBoids; i++) {
-            boids.push({
-                playerId: readU32(),
-                x: readU16(), y: readU16(),
-                vx: readI8() / 10.0, vy: readI8() / 10.0
-            });
+        for (let s = 0; s < numSwarms; s++) {
+            const playerId = readU32();
+            const count = readU16();
+            let id = 0;
+            for (let i = 0; i < count; i++) {
+                id = readId(id);
+                boids.push({
+                    id, playerId,
+                    x: readU16(), y: readU16(),
+                    vx: readI8() / 10.0, vy: readI8() / 10.0
+                });
+            }
         }
 
         const resources = [];
+        let resId = 0;
         for (let i = 0; i < numResources; i++) {
-            resources.push({ x: readU16(), y: readU16(), type: readU8() });
+            resId = readId(resId);
+            resources.push({ id: resId, x: readU16(), y: readU16(), type: readU8() });
         }
 
         const pickups = [];
+        let pickupId = 0;
         for (let i = 0; i < numPickups; i++) {
-            pickups.push({ x: readU16(), y: readU16(), type: readU8() });
+            pickupId = readId(pickupId);
+            pickups.push({ id: pickupId, x: readU16(), y: readU16(), type: readU8() });
+        }
+
+        const impostors = [];
+        for (let i = 0; i < numImpostors; i++) {
+            const imp = {
+                playerId: readU32(), count: readU16(),
+                x: readU16(), y: readU16(),
+                vx: readI8() / 10.0, vy: readI8() / 10.0,
+                sdx: readU16(), sdy: readU16(), corr: readI8() / 127.0,
+                clusters: []
+            };
+            const numClusters = readU8();
+            for (let c = 0; c < numClusters; c++) {
+                imp.clusters.push({ x: readU16(), y: readU16(), share: readU8() / 255.0 });
+            }
+            impostors.push(imp);
+            expandImpostor(imp, boids);
+        }
+
+        const boidById = new Map();
+        for (const b of boids) boidById.set(b.id, b);
+
+        return { tick, players, boids, boidById, resources, pickups, impostors };
+    }
+
+    // ── Payload Decoding ────────────────────────────────────
+    // Compressed payloads: [u32 rawSize] + LZ block (mirror of src/lz.cpp)
+
+    function lzDecompress(src, rawSize) {
+        const out = new Uint8Array(rawSize);
+        let ip = 0, op = 0;
+        const readLength = (len) => {
+            if (len !== 15) return len;
+            let b;
+            do { b = src[ip++]; len += b; } while (b === 255);
+            return len;
+        };
+        while (ip < src.length) {
+            const token = src[ip++];
+            const litLen = readLength(token >> 4);
+            out.set(src.subarray(ip, ip + litLen), op);
+            ip += litLen;
+            op += litLen;
+            if (ip >= src.length) break;
+            const offset = src[ip] | (src[ip + 1] << 8);
+            ip += 2;
+            const matchLen = readLength(token & 15) + 4;
+            let ref = op - offset;
+            for (let i = 0; i < matchLen; i++) out[op++] = out[ref++];
+        }
+        return out.buffer;
+    }
+
+    function decodePayload(data) {
+        let buffer;
+        if (data instanceof ArrayBuffer) {
+            buffer = data;
+        } else if (data && data.buffer) {
+            buffer = data.buffer.slice(data.byteOffset, data.byteOffset + data.byteLength);
+        } else {
+            return null;
+        }
+        if (!payloadCompressed) return buffer;
+        const rawSize = new DataView(buffer).getUint32(0, true);
+        return lzDecompress(new Uint8Array(buffer, 4), rawSize);
+    }
+
+    // ── Minimap Grid Parsing ────────────────────────────────
+
+    function parseMinimap(buffer) {
+        const view = new DataView(buffer);
+        let offset = 0;
+        const gw = view.getUint8(offset++);
+        const gh = view.getUint8(offset++);
+        const numOwners = view.getUint8(offset++);
+        const palette = [0];
+        for (let i = 0; i < numOwners; i++) {
+            palette.push(view.getUint32(offset, true));
+            offset += 4;
         }
+        const numRuns = view.getUint16(offset, true);
+        offset += 2;
+
+        const owners = new Uint32Array(gw * gh);
+        const density = new Uint8Array(gw * gh);
+        let cell = 0;
+        for (let r = 0; r < numRuns; r++) {
+            const len = view.getUint8(offset++);
+            const owner = palette[view.getUint8(offset++)] || 0;
+            const d = view.getUint8(offset++);
+            owners.fill(owner, cell, cell + len);
+            density.fill(d, cell, cell + len);
+            cell += len;
+        }
+        return { width: gw, height: gh, owners, density };
+    }
 
-        return { players, boids, resources, pickups };
+    // ── Impostor Expansion ──────────────────────────────────
+    // Far swarms arrive as a summary; synthesize stable pseudo-boids around
+    // the cluster centres so rendering, minimap and leaderboard still work.
+    // Pseudo-boids get negative ids so they never collide with real ones.
+
+    function hashUnit(a, b) {
+        let h = Math.imul(a ^ 0x9e3779b9, 0x85ebca6b) ^ Math.imul(b + 0x632be5ab, 0xc2b2ae35);
+        h ^= h >>> 16;
+        h = Math.imul(h, 0x7feb352d);
+        h ^= h >>> 15;
+        return (h >>> 0) / 4294967296;
+    }
+
+    function expandImpostor(imp, boids) {
+        const spreadX = imp.sdx * 0.6;
+        const spreadY = imp.sdy * 0.6;
+        let cluster = 0;
+        let clusterEnd = imp.clusters.length ? imp.clusters[0].share * imp.count : imp.count;
+        for (let i = 0; i < imp.count; i++) {
+            while (i >= clusterEnd && cluster < imp.clusters.length - 1) {
+                cluster++;
+                clusterEnd += imp.clusters[cluster].share * imp.count;
+            }
+            const c = imp.clusters[cluster] || imp;
+            // Triangular noise in [-1, 1], stable per (player, index)
+            const u = hashUnit(imp.playerId, i * 2) + hashUnit(imp.playerId, i * 2 + 1) - 1;
+            const v = hashUnit(imp.playerId + 7919, i * 2) + hashUnit(imp.playerId + 7919, i * 2 + 1) - 1;
+            boids.push({
+                id: -(imp.playerId * 65536 + i),
+                playerId: imp.playerId,
+                x: c.x + u * spreadX,
+                y: c.y + (v + u * imp.corr) * spreadY,
+                vx: imp.vx, vy: imp.vy,
+                impostor: true
+            });
+        }
     }
 
     // ── Event Detection (between ticks) ─────────────────────
@@ -547,31 +700,24 @@
             audio.playCombat();
         }
 
-        // Death explosions for ALL players that lost boids
-        for (const pid in prevByPlayer) {
-            const prevCount = prevByPlayer[pid].length;
-            const currCount = (currByPlayer[pid] || []).length;
-            if (currCount < prevCount) {
-                // Spawn explosions at approximate positions of lost boids
-                const color = getPlayerColor(parseInt(pid));
-                const prevBoids = prevByPlayer[pid];
-                // Pick some from the tail of the prev array as likely lost ones
-                const lostCount = Math.min(prevCount - currCount, 5);
-                for (let i = 0; i < lostCount; i++) {
-                    const b = prevBoids[prevCount - 1 - i];
-                    if (b) spawnExplosion(b.x, b.y, color, 8);
-                }
-            }
+        // Death explosions at the exact positions of boids that vanished
+        const lostPerPlayer = {};
+        for (const b of prev.boids) {
+            if (b.id < 0 || curr.boidById.has(b.id)) continue;
+            const n = lostPerPlayer[b.playerId] || 0;
+            if (n >= 5) continue;
+            lostPerPlayer[b.playerId] = n + 1;
+            spawnExplosion(b.x, b.y, getPlayerColor(b.playerId), 8);
         }
 
         // Detect collected pickups
         const prevPickups = prev.pickups || [];
         const currPickups = curr.pickups || [];
-        if (prevPickups.length > currPickups.length) {
+        if (prevPickups.length > 0) {
             const currPSet = new Set();
-            for (const p of currPickups) currPSet.add(p.x + ',' + p.y);
+            for (const p of currPickups) currPSet.add(p.id);
             for (const p of prevPickups) {
-                if (!currPSet.has(p.x + ',' + p.y)) {
+                if (!currPSet.has(p.id)) {
                     const color = PICKUP_COLORS[p.type] || 0xffffff;
                     spawnExplosion(p.x, p.y, color, 12);
                     // Play pickup SFX if near our boids
@@ -590,12 +736,12 @@
         }
 
         // Detect collected resources
-        if (prev.resources.length > curr.resources.length) {
+        if (prev.resources.length > 0) {
             const currSet = new Set();
-            for (const r of curr.resources) currSet.add(r.x + ',' + r.y);
+            for (const r of curr.resources) currSet.add(r.id);
             let collected = 0;
             for (const r of prev.resources) {
-                if (!currSet.has(r.x + ',' + r.y) && collected < 4) {
+                if (!currSet.has(r.id) && collected < 4) {
                     spawnCollectEffect(r.x, r.y, RESOURCE_COLORS[r.type] || 0xffffff);
                     collected++;
                     // Only play sound if resource was near our boids
@@ -614,44 +760,136 @@
         }
     }
 
+    // ── Native WebSocket Transport ──────────────────────────
+    // Used when the server runs the engine's epoll front end (no socket.io).
+    // Mimics the small slice of the socket.io API the client relies on.
+
+    const NATIVE_CH_STATE = 1;
+    const NATIVE_CH_MINIMAP = 2;
+
+    // ?spectate joins the delayed spectator stream instead of playing
+    const SPECTATING = new URLSearchParams(location.search).has('spectate');
+
+    function createNativeSocket() {
+        const handlers = {};
+        let ws = null;
+
+        function open() {
+            fetch('/native').then(r => r.json()).then(cfg => {
+                if (!cfg.port) return;
+                const proto = location.protocol === 'https:' ? 'wss' : 'ws';
+                ws = new WebSocket(proto + '://' + location.hostname + ':' + cfg.port +
+                    (SPECTATING ? '/spectate' : '/'));
+                ws.binaryType = 'arraybuffer';
+                ws.onmessage = (m) => {
+                    if (typeof m.data === 'string') {
+                        const msg = JSON.parse(m.data);
+                        if (handlers[msg.type]) handlers[msg.type](msg);
+                        return;
+                    }
+                    const channel = new Uint8Array(m.data, 0, 1)[0];
+                    const ev = channel === NATIVE_CH_STATE ? 'state'
+                        : channel === NATIVE_CH_MINIMAP ? 'minimap' : null;
+                    if (ev && handlers[ev]) handlers[ev](m.data.slice(1));
+                };
+            });
+        }
+
+        function send(ev, data) {
+            if (!ws || ws.readyState !== WebSocket.OPEN) return;
+            if (ev === 'input') ws.send(data);
+        }
+
+        open();
+        return {
+            on(ev, fn) { handlers[ev] = fn; },
+            emit: send,
+            volatile: { emit: send },
+            connect: open,
+            disconnect() { if (ws) ws.close(); ws = null; }
+        };
+    }
+
     // ── Socket.io Connection ────────────────────────────────
 
-    const socket = io({ transports: ['websocket'] });
+    const socket = typeof io === 'function'
+        ? io({ transports: ['websocket'], query: SPECTATING ? { spectate: '1' } : {} })
+        : createNativeSocket();
 
     socket.on('init', (data) => {
         myPlayerId = data.playerId;
         mapWidth = data.mapWidth;
         mapHeight = data.mapHeight;
         tickRate = data.tickRate;
+        payloadCompressed = data.compressed === true;
+        // Reconnects carry the token so a server hot restart resumes this swarm
+        if (data.resumeToken && socket.io) socket.io.opts.query.resume = data.resumeToken;
+        showDeathScreen(false);
         drawGrid();
-        audio.playSpawn();
+        if (!data.resumed) audio.playSpawn();
+    });
+
+    // Capped room with no free slot: offer a retry instead of a swarm
+    socket.on('full', () => {
+        myPlayerId = null;
+        showDeathScreen(true);
     });
 
     socket.on('state', (data) => {
-        let buffer;
-        if (data instanceof ArrayBuffer) {
-            buffer = data;
-        } else if (data.buffer) {
-            buffer = data.buffer.slice(data.byteOffset, data.byteOffset + data.byteLength);
-        } else {
+        const buffer = decodePayload(data);
+        if (!buffer) return;
+
+        const state = parseState(buffer);
+        // Drop duplicates and reordered packets (a large jump back is a server restart)
+        if (currState && state.tick <= currState.tick && currState.tick - state.tick < tickRate * 10) {
             return;
         }
 
         const oldState = currState;
         prevState = currState;
-        currState = parseState(buffer);
+        currState = state;
         lastStateTime = performance.now();
 
+        // Input-to-effect latency from the echoed timestamp of our last applied input
+        const me = state.players.find(p => p.id === myPlayerId);
+        if (me && me.ackTime) {
+            const sample = ((Math.floor(performance.now()) >>> 0) - me.ackTime) >>> 0;
+            if (sample < 10000) latencyMs = latencyMs ? latencyMs * 0.9 + sample * 0.1 : sample;
+        }
+
         detectEvents(oldState, currState);
         updateHUD(currState);
         updateLeaderboard(currState);
     });
 
-    setInterval(() => {
-        if (myPlayerId) {
-            socket.volatile.emit('cursor', { x: mouseWorldX, y: mouseWorldY });
-        }
-    }, 50);
+    socket.on('minimap', (data) => {
+        const buffer = decodePayload(data);
+        if (buffer) minimapGrid = parseMinimap(buffer);
+    });
+
+    // ── Input Frames ────────────────────────────────────────
+    // Fixed 12-byte frame (see the format next to serializeState in
+    // src/engine.cpp): seq, quantized cursor, flags, client timestamp.
+
+    const INPUT_FLAG_BOOST = 0x01;
+    let inputSeq = 0;
+
+    function sendInput() {
+        if (!myPlayerId) return;
+        const view = new DataView(new ArrayBuffer(12));
+        const qx = Math.round(Math.max(0, Math.min(1, mouseWorldX / mapWidth)) * 65535);
+        const qy = Math.round(Math.max(0, Math.min(1, mouseWorldY / mapHeight)) * 65535);
+        inputSeq = (inputSeq + 1) & 0xffff;
+        view.setUint16(0, inputSeq, true);
+        view.setUint16(2, qx, true);
+        view.setUint16(4, qy, true);
+        view.setUint8(6, isBoosting ? INPUT_FLAG_BOOST : 0);
+        view.setUint8(7, 0);
+        view.setUint32(8, Math.floor(performance.now()) >>> 0, true);
+        socket.volatile.emit('input', view.buffer);
+    }
+
+    setInterval(sendInput, 50);
 
     // ── Mouse Tracking ──────────────────────────────────────
 
@@ -668,7 +906,7 @@
     function setBoost(active) {
         if (active === isBoosting) return;
         isBoosting = active;
-        socket.volatile.emit('boost', active);
+        sendInput();
         if (active) audio.playBoostStart();
     }
 
@@ -711,6 +949,7 @@
         if (!state) return;
 
         document.getElementById('player-count').textContent = 'Players: ' + state.players.length;
+        document.getElementById('ping').textContent = 'Ping: ' + Math.round(latencyMs) + 'ms';
         document.getElementById('bot-count').textContent = 'Bots: ' + state.boids.length;
 
         const me = state.players.find(p => p.id === myPlayerId);
@@ -739,6 +978,7 @@
             updateEffectIndicators(me);
 
             if (!me.alive) {
+                showDeathScreen(false);
                 const ds = document.getElementById('death-screen');
                 ds.classList.remove('hidden');
                 void ds.offsetWidth;
@@ -843,22 +1083,27 @@
             mmCtx.fillRect(p.x * sx - 1, p.y * sy - 1, 3, 3);
         }
 
-        // Boids (grouped by player)
-        const byPlayer = {};
-        for (const b of currState.boids) {
-            if (!byPlayer[b.playerId]) byPlayer[b.playerId] = [];
-            byPlayer[b.playerId].push(b);
+        // Swarm occupancy (server-side grid, owner + density per cell)
+        if (minimapGrid) {
+            const cw = MM_W / minimapGrid.width;
+            const ch = MM_H / minimapGrid.height;
+            for (let i = 0; i < minimapGrid.owners.length; i++) {
+                const owner = minimapGrid.owners[i];
+                if (!owner || owner === myPlayerId) continue;
+                mmCtx.fillStyle = hexToCSS(getPlayerColor(owner));
+                mmCtx.globalAlpha = 0.25 + 0.05 * minimapGrid.density[i];
+                const gx = i % minimapGrid.width;
+                const gy = (i - gx) / minimapGrid.width;
+                mmCtx.fillRect(gx * cw, gy * ch, cw, ch);
+            }
         }
 
-        for (const pid in byPlayer) {
-            const color = hexToCSS(getPlayerColor(parseInt(pid)));
-            const isMe = parseInt(pid) === myPlayerId;
-            mmCtx.fillStyle = color;
-            mmCtx.globalAlpha = isMe ? 0.9 : 0.5;
-            for (const b of byPlayer[pid]) {
-                const size = isMe ? 2 : 1;
-                mmCtx.fillRect(b.x * sx - size / 2, b.y * sy - size / 2, size, size);
-            }
+        // Own boids (always in full detail)
+        mmCtx.fillStyle = hexToCSS(getPlayerColor(myPlayerId));
+        mmCtx.globalAlpha = 0.9;
+        for (const b of currState.boids) {
+            if (b.playerId !== myPlayerId) continue;
+            mmCtx.fillRect(b.x * sx - 1, b.y * sy - 1, 2, 2);
         }
 
         // Viewport rectangle
@@ -874,10 +1119,32 @@
 
     // ── Respawn ─────────────────────────────────────────────
 
+    // The death screen doubles as the "room full" screen
+    const deathTexts = (() => {
+        const ds = document.getElementById('death-screen');
+        return {
+            title: ds.querySelector('h1').textContent,
+            text: ds.querySelector('p').textContent,
+            button: document.getElementById('respawn-btn').textContent
+        };
+    })();
+
+    function showDeathScreen(full) {
+        const ds = document.getElementById('death-screen');
+        ds.querySelector('h1').textContent = full ? 'ROOM FULL' : deathTexts.title;
+        ds.querySelector('p').textContent = full ? 'Every swarm slot is taken. Try again in a moment.' : deathTexts.text;
+        document.getElementById('respawn-btn').textContent = full ? 'RETRY' : deathTexts.button;
+        if (!full) return;
+        ds.classList.remove('hidden');
+        void ds.offsetWidth;
+        ds.classList.add('visible');
+    }
+
     document.getElementById('respawn-btn').addEventListener('click', () => {
         const ds = document.getElementById('death-screen');
         ds.classList.remove('visible');
         ds.classList.add('hidden');
+        if (socket.io) delete socket.io.opts.query.resume;
         socket.disconnect();
         socket.connect();
     });
@@ -1334,7 +1601,12 @@
         interpFactor = Math.min(elapsed / tickMs, 1.0);
 
         // ── Camera ──────────────────────────────────────────
-        const myBoids = currState.boids.filter(b => b.playerId === myPlayerId);
+        // Spectators follow the current leader
+        let followId = myPlayerId;
+        if (SPECTATING && currState.players.length > 0) {
+            followId = currState.players.reduce((a, b) => (b.score > a.score ? b : a)).id;
+        }
+        const myBoids = currState.boids.filter(b => b.playerId === followId);
         if (myBoids.length > 0) {
             let cx = 0, cy = 0;
             for (const b of myBoids) { cx += b.x; cy += b.y; }
@@ -1377,10 +1649,9 @@
             const boid = boids[i];
             let px = boid.x, py = boid.y;
 
-            // Interpolation
-            if (prevState && prevState.boids[i] &&
-                prevState.boids[i].playerId === boid.playerId) {
-                const prev = prevState.boids[i];
+            // Interpolation (matched by stable id, not array slot)
+            const prev = prevState && prevState.boidById.get(boid.id);
+            if (prev) {
                 px = prev.x + (boid.x - prev.x) * interpFactor;
                 py = prev.y + (boid.y - prev.y) * interpFactor;
             }
@@ -2,6 +2,9 @@ const express = require('express');
 const http = require('http');
 const { Server } = require('socket.io');
 const path = require('path');
+const fs = require('fs');
+const os = require('os');
+const crypto = require('crypto');
 
 // Load the native C++ engine
 const engine = require('./build/Release/swarmmind_engine.node');
@@ -9,12 +12,56 @@ const engine = require('./build/Release/swarmmind_engine.node');
 const PORT = process.env.PORT || 3001;
 const TICK_RATE = 20; // 20 TPS
 const TICK_INTERVAL = 1000 / TICK_RATE;
+const MINIMAP_INTERVAL = 5; // ticks between minimap grid broadcasts (4 Hz)
+const COMPRESS = process.env.COMPRESS === '1'; // LZ-compress payloads in the engine
+const SEED = process.env.SEED ? BigInt(process.env.SEED) : 0n; // 0 = random
+const RECORD = process.env.RECORD || ''; // replay archive path; replay/seek with tools/replay.js
+// State checksum every N ticks, embedded in recordings (verify with
+// tools/replay.js --verify). Defaults to every tick while recording.
+const CHECKSUM = parseInt(process.env.CHECKSUM || (RECORD ? '1' : '0'), 10);
+
+// Native mode: an epoll WebSocket server inside the engine handles players;
+// express only serves static files and tells clients where to connect.
+const NATIVE_PORT = parseInt(process.env.NATIVE_PORT || '0', 10);
+const SENDER_THREADS = parseInt(process.env.SENDER_THREADS || '2', 10);
+
+// Spectators get a delayed, 5 Hz, always-compressed stream encoded once per
+// frame by the engine. SPECTATOR_SINK also writes it to a file/FIFO for relays.
+const SPECTATE = process.env.SPECTATE !== '0';
+const SPECTATOR_SINK = process.env.SPECTATOR_SINK || '';
+const SPECTATOR_INTERVAL = 4; // ticks per spectator frame (matches the engine)
+
+// Hot restart: SIGUSR2 hands the room (world + resume tokens) to HANDOFF and
+// exits between two ticks; the next process started with the same HANDOFF
+// resumes at the following tick and players reconnect into their swarms.
+//   kill -USR2 <old pid> && node server.js
+const HANDOFF = process.env.HANDOFF ||
+    path.join(fs.existsSync('/dev/shm') ? '/dev/shm' : os.tmpdir(), `swarmmind-${PORT}.handoff`);
+const RESUME_GRACE_MS = 15000; // handed-over players not back by then leave
+
+// Hibernation: once nobody has been connected for HIBERNATE_IDLE seconds the
+// room is written to HIBERNATE_PATH and its engine freed; the next
+// connection wakes it. Keep the image on disk (not /dev/shm) so the memory
+// really goes back. Socket.io mode only.
+const HIBERNATE_IDLE = parseInt(process.env.HIBERNATE_IDLE || '60', 10); // 0 = never
+const HIBERNATE_PATH = process.env.HIBERNATE_PATH || path.join(os.tmpdir(), `swarmmind-${PORT}.room`);
+
+// Fixed-capacity rooms: MAX_PLAYERS > 0 reserves the whole room up front
+// (no container growth mid-game) and turns away joins beyond the cap.
+// HUGE_PAGES=1 asks for transparent huge pages on the large buffers.
+// MODE picks the game mode: classic, blitz (small map), mega (16k map) or
+// horde (1000-boid swarms). Woken and handed-off rooms keep their own mode.
+const ROOM_OPTIONS = {
+    maxPlayers: parseInt(process.env.MAX_PLAYERS || '0', 10),
+    hugePages: process.env.HUGE_PAGES === '1',
+    mode: process.env.MODE || 'classic'
+};
 
 // ── Express + Socket.io setup ──────────────────────────────
 
 const app = express();
 const server = http.createServer(app);
-const io = new Server(server, {
+const io = NATIVE_PORT ? null : new Server(server, {
     cors: { origin: '*' },
     transports: ['websocket'],
     perMessageDeflate: false
@@ -22,45 +69,223 @@ const io = new Server(server, {
 
 app.use(express.static(path.join(__dirname, 'public')));
 
+app.get('/native', (req, res) => {
+    res.json({ port: NATIVE_PORT || null });
+});
+
 // ── Initialize game engine ─────────────────────────────────
 
-engine.createEngine();
+function configureEngine() {
+    engine.setCompression(COMPRESS);
+    if (SPECTATE) engine.setSpectator({ enabled: true, sink: SPECTATOR_SINK });
+    engine.setChecksumInterval(CHECKSUM);
+}
+
+// A room continued from another process or image (suffix: the tick it
+// resumed at) starts a new archive instead of truncating the old one
+function startRecording(suffix) {
+    const recordPath = suffix === undefined ? RECORD : `${RECORD}.${suffix}`;
+    engine.startRecording(recordPath);
+    console.log(`[SwarmMind.io] Recording replay archive to ${recordPath}`);
+}
+
+engine.createEngine(SEED, ROOM_OPTIONS);
+configureEngine();
+
+let handoff = null;
+try {
+    handoff = engine.loadHandoff(HANDOFF);
+} catch (err) {
+    console.error(`[SwarmMind.io] Ignoring handoff: ${err.message}`);
+}
+
+if (RECORD) startRecording(handoff ? handoff.tick : undefined);
 const mapSize = engine.getMapSize();
 
-console.log(`[SwarmMind.io] Engine initialized. Map: ${mapSize.width}x${mapSize.height}`);
+console.log(`[SwarmMind.io] Engine initialized. Mode: ${engine.getStats().mode}, ` +
+    `map: ${mapSize.width}x${mapSize.height}, seed ${engine.getSeed()}`);
+
+if (NATIVE_PORT) {
+    engine.startNativeServer({ port: NATIVE_PORT, threads: SENDER_THREADS, tickRate: TICK_RATE });
+    console.log(`[SwarmMind.io] Native WebSocket server on port ${NATIVE_PORT} (${SENDER_THREADS} sender threads)`);
+}
 
 // ── Player tracking ────────────────────────────────────────
 
-const players = new Map(); // socketId -> { playerId }
+const players = new Map(); // socketId -> { playerId, socket, token }
+const held = new Map();    // resume token -> { playerId, timer } (handed over, not yet back)
+let spectatorCount = 0;
+
+function holdPlayer(token, playerId) {
+    const timer = setTimeout(() => {
+        held.delete(token);
+        engine.removePlayer(playerId);
+        console.log(`[-] Player ${playerId} did not come back after the restart`);
+        scheduleHibernate();
+    }, RESUME_GRACE_MS);
+    held.set(token, { playerId, timer });
+}
+
+// ── Hibernation ────────────────────────────────────────────
+
+let hibernated = false;
+let idleTimer = null;
+
+function roomIdle() {
+    return players.size === 0 && held.size === 0 && spectatorCount === 0;
+}
+
+function scheduleHibernate() {
+    if (NATIVE_PORT || HIBERNATE_IDLE <= 0 || hibernated || idleTimer || !roomIdle()) return;
+    idleTimer = setTimeout(hibernate, HIBERNATE_IDLE * 1000);
+}
+
+function hibernate() {
+    idleTimer = null;
+    if (!roomIdle()) return;
+    flushInputs();
+    let r;
+    try {
+        r = engine.hibernate(HIBERNATE_PATH);
+    } catch (err) {
+        console.error(`[SwarmMind.io] Hibernation failed, still running: ${err.message}`);
+        return;
+    }
+    clearInterval(loopTimer);
+    hibernated = true;
+    console.log(`[SwarmMind.io] Hibernated at tick ${r.tick}: ${r.rawBytes} -> ${r.bytes} bytes ` +
+                `in ${(r.stateMs + r.fileMs).toFixed(2)} ms -> ${HIBERNATE_PATH}`);
+}
+
+// Called before anything touches the engine on a new connection
+function wake() {
+    if (idleTimer) {
+        clearTimeout(idleTimer);
+        idleTimer = null;
+    }
+    if (!hibernated) return;
+    hibernated = false;
+    let suffix;
+    try {
+        const r = engine.wake();
+        suffix = r.tick;
+        console.log(`[SwarmMind.io] Woke at tick ${r.tick} in ${(r.stateMs + r.fileMs).toFixed(2)} ms`);
+    } catch (err) {
+        console.error(`[SwarmMind.io] Cannot wake the room, starting a new one: ${err.message}`);
+        engine.createEngine(SEED, ROOM_OPTIONS);
+        configureEngine();
+        suffix = `new-${Date.now()}`;   // the original archive stays intact
+    }
+    if (RECORD) startRecording(suffix);
+    loopTimer = setInterval(gameLoop, TICK_INTERVAL);
+}
+
+if (handoff) {
+    const sessions = JSON.parse(handoff.app || '{}').sessions || {};
+    for (const [token, playerId] of Object.entries(sessions)) holdPlayer(token, playerId);
+    console.log(`[SwarmMind.io] Resumed at tick ${handoff.tick}: ${held.size} players, ` +
+                `${handoff.bytes} bytes in ${(handoff.stateMs + handoff.fileMs).toFixed(2)} ms`);
+}
+
+// ── Input batching ─────────────────────────────────────────
+// Records of [u32 playerId][12-byte input frame], handed to the engine once
+// per tick instead of one N-API call per message.
+
+const INPUT_FRAME_SIZE = 12;
+const INPUT_RECORD_SIZE = 4 + INPUT_FRAME_SIZE;
+let inputBatch = Buffer.alloc(INPUT_RECORD_SIZE * 256);
+let inputBatchLen = 0;
+
+function queueInput(playerId, frame) {
+    if (inputBatchLen + INPUT_RECORD_SIZE > inputBatch.length) {
+        const grown = Buffer.alloc(inputBatch.length * 2);
+        inputBatch.copy(grown, 0, 0, inputBatchLen);
+        inputBatch = grown;
+    }
+    inputBatch.writeUInt32LE(playerId, inputBatchLen);
+    frame.copy(inputBatch, inputBatchLen + 4);
+    inputBatchLen += INPUT_RECORD_SIZE;
+}
+
+function flushInputs() {
+    if (inputBatchLen === 0) return;
+    engine.submitInputs(inputBatch.subarray(0, inputBatchLen));
+    inputBatchLen = 0;
+}
 
 // ── Socket.io connection handling ──────────────────────────
 
-io.on('connection', (socket) => {
-    const playerId = engine.addPlayer();
-    players.set(socket.id, { playerId });
+if (io) io.on('connection', (socket) => {
+    wake();
+    const map = engine.getMapSize();   // a woken room may differ from startup
+
+    // Spectators (?spectate) never become players and share one stream
+    if (socket.handshake.query.spectate !== undefined) {
+        if (!SPECTATE) return socket.disconnect(true);
+        socket.join('spectators');
+        spectatorCount++;
+        socket.emit('init', {
+            playerId: 0,
+            spectator: true,
+            mapWidth: map.width,
+            mapHeight: map.height,
+            tickRate: TICK_RATE / SPECTATOR_INTERVAL,
+            compressed: true
+        });
+        const latest = engine.getSpectatorFrame();
+        if (latest) socket.emit('state', Buffer.from(latest));
+        socket.on('disconnect', () => {
+            spectatorCount--;
+            scheduleHibernate();
+        });
+        return;
+    }
+
+    // A token from before a hot restart reclaims the swarm it was playing
+    const resume = socket.handshake.query.resume;
+    const reclaimed = resume ? held.get(resume) : undefined;
+    let playerId, token;
+    if (reclaimed) {
+        clearTimeout(reclaimed.timer);
+        held.delete(resume);
+        playerId = reclaimed.playerId;
+        token = resume;
+    } else {
+        playerId = engine.addPlayer();
+        if (playerId === 0) {
+            console.log(`[!] Room full (${ROOM_OPTIONS.maxPlayers} players), turned away ${socket.id}`);
+            socket.emit('full');
+            socket.disconnect(true);
+            scheduleHibernate();
+            return;
+        }
+        token = crypto.randomBytes(16).toString('hex');
+    }
+    players.set(socket.id, { playerId, socket, token });
+    socket.join('players');
 
-    console.log(`[+] Player ${playerId} connected (${socket.id}). Total: ${players.size}`);
+    console.log(`[+] Player ${playerId} ${reclaimed ? 'resumed' : 'connected'} (${socket.id}). Total: ${players.size}`);
 
     // Send init data to the client
     socket.emit('init', {
         playerId,
-        mapWidth: mapSize.width,
-        mapHeight: mapSize.height,
-        tickRate: TICK_RATE
+        mapWidth: map.width,
+        mapHeight: map.height,
+        tickRate: TICK_RATE,
+        compressed: COMPRESS,
+        resumeToken: token,
+        resumed: !!reclaimed
     });
 
-    // Handle cursor movement from client
-    socket.on('cursor', (data) => {
-        if (data && typeof data.x === 'number' && typeof data.y === 'number') {
-            const x = Math.max(0, Math.min(mapSize.width, data.x));
-            const y = Math.max(0, Math.min(mapSize.height, data.y));
-            engine.setPlayerCursor(playerId, x, y);
-        }
-    });
+    // Cached keyframe: something to draw before the next tick's broadcast
+    socket.emit('state', Buffer.from(engine.getKeyframe()));
 
-    // Handle boost toggle from client
-    socket.on('boost', (active) => {
-        engine.setPlayerBoost(playerId, active === true);
+    // Binary input frames are only size-checked here; the engine validates,
+    // dequantizes and sequences them when the batch is submitted
+    socket.on('input', (data) => {
+        if (Buffer.isBuffer(data) && data.length === INPUT_FRAME_SIZE) {
+            queueInput(playerId, data);
+        }
     });
 
     // Handle disconnection
@@ -68,6 +293,7 @@ io.on('connection', (socket) => {
         engine.removePlayer(playerId);
         players.delete(socket.id);
         console.log(`[-] Player ${playerId} disconnected. Total: ${players.size}`);
+        scheduleHibernate();
     });
 });
 
@@ -75,23 +301,62 @@ io.on('connection', (socket) => {
 
 let tickCount = 0;
 
+function nativeLoop() {
+    const connections = engine.pumpNative();
+    engine.tick();
+
+    const stateBytes = engine.broadcastState();
+    if (tickCount % MINIMAP_INTERVAL === 0) engine.broadcastMinimap();
+    if (SPECTATE) engine.broadcastSpectator();
+
+    tickCount++;
+    if (tickCount % (TICK_RATE * 10) === 0) {
+        const sender = engine.getStats().sender || {};
+        console.log(`[~] Tick ${tickCount} | Native connections: ${connections} | State: ${stateBytes} bytes | Dropped: ${sender.framesDropped || 0}`);
+    }
+}
+
 function gameLoop() {
-    // Call the C++ tick — returns an ArrayBuffer with the full state
-    const stateBuffer = engine.tick();
+    flushInputs();
+    engine.tick();
+
+    // Each client gets its own view: nearby swarms in full, far ones as impostors
+    let stateBytes = 0;
+    for (const { playerId, socket } of players.values()) {
+        const stateBuffer = engine.getStateFor(playerId);
+        if (stateBuffer && stateBuffer.byteLength > 0) {
+            socket.volatile.emit('state', Buffer.from(stateBuffer));
+            stateBytes += stateBuffer.byteLength;
+        }
+    }
 
-    if (stateBuffer && stateBuffer.byteLength > 0) {
-        // Broadcast binary state to all connected clients
-        const buf = Buffer.from(stateBuffer);
-        io.volatile.emit('state', buf);
+    // Coarse occupancy grid for the minimap, shared by every player (live
+    // data, so spectators don't get it)
+    if (tickCount % MINIMAP_INTERVAL === 0 && players.size > 0) {
+        io.to('players').volatile.emit('minimap', Buffer.from(engine.getMinimap()));
+    }
+
+    // Delayed spectator frame: one buffer, one encoded packet for the room
+    const spectatorFrame = SPECTATE ? engine.pollSpectator() : undefined;
+    if (spectatorFrame && spectatorCount > 0) {
+        io.to('spectators').volatile.emit('state', Buffer.from(spectatorFrame));
     }
 
     tickCount++;
     if (tickCount % (TICK_RATE * 10) === 0) {
-        console.log(`[~] Tick ${tickCount} | Players: ${players.size} | State: ${stateBuffer ? stateBuffer.byteLength : 0} bytes`);
+        const avg = players.size ? Math.round(stateBytes / players.size) : 0;
+        let line = `[~] Tick ${tickCount} | Players: ${players.size} | State: ${avg} bytes/client`;
+        if (spectatorCount > 0) line += ` | Spectators: ${spectatorCount}`;
+        if (COMPRESS) {
+            const stats = engine.getStats();
+            line += ` | LZ ${stats.ratio.toFixed(2)}x, ${stats.encodeNsPerByte.toFixed(1)} ns/B`;
+        }
+        console.log(line);
     }
 }
 
-setInterval(gameLoop, TICK_INTERVAL);
+let loopTimer = setInterval(NATIVE_PORT ? nativeLoop : gameLoop, TICK_INTERVAL);
+scheduleHibernate();
 
 // ── Start server ───────────────────────────────────────────
 
@@ -99,3 +364,43 @@ server.listen(PORT, () => {
     console.log(`[SwarmMind.io] Server running on http://localhost:${PORT}`);
     console.log(`[SwarmMind.io] Tick rate: ${TICK_RATE} TPS`);
 });
+
+// Hot restart. Signal handlers run between loop callbacks, so the world is
+// always handed over on a tick boundary, pending inputs included.
+process.on('SIGUSR2', () => {
+    if (NATIVE_PORT) {
+        console.warn('[SwarmMind.io] Hot restart needs socket.io mode; ignoring SIGUSR2');
+        return;
+    }
+    wake();
+    clearInterval(loopTimer);
+    flushInputs();
+
+    const sessions = {};
+    for (const { playerId, token } of players.values()) sessions[token] = playerId;
+    for (const [token, { playerId }] of held) sessions[token] = playerId;
+
+    let r;
+    try {
+        r = engine.writeHandoff(HANDOFF, JSON.stringify({ sessions }));
+    } catch (err) {
+        console.error(`[SwarmMind.io] Handoff failed, still serving: ${err.message}`);
+        loopTimer = setInterval(gameLoop, TICK_INTERVAL);
+        return;
+    }
+    const ms = r.stateMs + r.fileMs;
+    console.log(`[SwarmMind.io] Handed off tick ${r.tick} (${Object.keys(sessions).length} players, ` +
+                `${r.bytes} bytes) in ${ms.toFixed(2)} ms -> ${HANDOFF}`);
+    if (ms > TICK_INTERVAL) console.warn(`[SwarmMind.io] Handoff took longer than a tick (${TICK_INTERVAL} ms)`);
+
+    if (RECORD) engine.stopRecording();
+    process.exit(0);
+});
+
+// Flush the input log on shutdown so it ends with a clean end marker
+for (const sig of ['SIGINT', 'SIGTERM']) {
+    process.on(sig, () => {
+        if (RECORD) engine.stopRecording();
+        process.exit(0);
+    });
+}
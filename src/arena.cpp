@@ -0,0 +1,112 @@
+#include "arena.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// ============================================================
+// Per-Tick Arena
+// ============================================================
+
+TickArena::TickArena(size_t bytes)
+    : block_(new uint8_t[bytes]), size_(bytes) {}
+
+void* TickArena::spill(size_t bytes, size_t align) {
+    spilled_.emplace_back(new uint8_t[bytes + align]);
+    spilledBytes_ += bytes + align;
+    spills_++;
+    uintptr_t p = (uintptr_t)spilled_.back().get();
+    return (void*)((p + align - 1) & ~(uintptr_t)(align - 1));
+}
+
+void TickArena::reset() {
+    size_t needed = used_ + spilledBytes_;
+    if (needed > highWater_) highWater_ = needed;
+
+    // Regrow once so the next tick like this one fits in the block
+    if (!spilled_.empty()) {
+        spilled_.clear();
+        size_t grown = size_;
+        while (grown < needed + needed / 4) grown *= 2;
+        block_.reset(new uint8_t[grown]);
+        size_ = grown;
+    }
+    used_ = 0;
+    spilledBytes_ = 0;
+}
+
+void TickArena::reserve(size_t bytes) {
+    if (bytes <= size_) return;
+    spilled_.clear();
+    block_.reset(new uint8_t[bytes]);
+    size_ = bytes;
+    used_ = 0;
+    spilledBytes_ = 0;
+}
+
+// ============================================================
+// Allocation Accounting
+// ============================================================
+// Replacements of the global allocation functions, counted per thread.
+// The module links with -Bsymbolic-functions (binding.gyp), so every
+// operator new compiled into it (ours and the standard library templates
+// we instantiate) binds to these; Node and other addons keep resolving to
+// the C++ runtime's. Behaviour is the default one plus the counter.
+
+#if defined(__ELF__) && defined(__GNUC__)
+
+static thread_local uint64_t t_heapAllocations = 0;
+
+static void* countedAlloc(size_t size) {
+    t_heapAllocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    t_heapAllocations++;
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    t_heapAllocations++;
+    return std::malloc(size ? size : 1);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+uint64_t threadHeapAllocations() { return t_heapAllocations; }
+bool     allocationCountingSupported() { return true; }
+
+#else
+
+uint64_t threadHeapAllocations() { return 0; }
+bool     allocationCountingSupported() { return false; }
+
+#endif
+
+// ============================================================
+// Huge Pages
+// ============================================================
+
+size_t adviseHugePages(const void* data, size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    const uintptr_t page = 4096;
+    uintptr_t begin = ((uintptr_t)data + page - 1) & ~(page - 1);
+    uintptr_t end   = ((uintptr_t)data + bytes) & ~(page - 1);
+    if (end <= begin) return 0;
+    if (madvise((void*)begin, end - begin, MADV_HUGEPAGE) != 0) return 0;
+    return end - begin;
+#else
+    (void)data;
+    (void)bytes;
+    return 0;
+#endif
+}
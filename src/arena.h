@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================
+// Per-Tick Arena
+// ============================================================
+// Bump allocator for temporaries that never outlive a tick (query results,
+// removal lists, per-player counters). Allocation is a pointer bump,
+// deallocation is a no-op, and reset() at the end of the tick drops
+// everything at once. A tick that runs past the block spills to the heap;
+// the next reset() regrows the block to cover it, so a warm arena serves
+// every tick from one block without touching malloc.
+
+static constexpr size_t TICK_ARENA_INITIAL_BYTES = 64 * 1024;
+
+class TickArena {
+public:
+    explicit TickArena(size_t bytes = TICK_ARENA_INITIAL_BYTES);
+
+    TickArena(const TickArena&) = delete;
+    TickArena& operator=(const TickArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align) {
+        size_t at = (used_ + align - 1) & ~(align - 1);
+        if (at + bytes <= size_) {
+            used_ = at + bytes;
+            return block_.get() + at;
+        }
+        return spill(bytes, align);
+    }
+
+    void reset();
+    // Replaces the block with one of at least `bytes`; only between ticks
+    void reserve(size_t bytes);
+
+    uint8_t* data()            { return block_.get(); }
+    size_t   capacity()  const { return size_; }
+    size_t   highWater() const { return highWater_; }   // most bytes any tick needed
+    uint64_t spills()    const { return spills_; }
+
+private:
+    void* spill(size_t bytes, size_t align);
+
+    std::unique_ptr<uint8_t[]> block_;
+    size_t size_ = 0;
+    size_t used_ = 0;
+
+    std::vector<std::unique_ptr<uint8_t[]>> spilled_;
+    size_t   spilledBytes_ = 0;
+    size_t   highWater_    = 0;
+    uint64_t spills_       = 0;
+};
+
+// std-compatible allocator over a TickArena
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    TickArena* arena;
+
+    explicit ArenaAllocator(TickArena& a) : arena(&a) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+template <typename K, typename V>
+using ArenaMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                                    ArenaAllocator<std::pair<const K, V>>>;
+
+template <typename T>
+ArenaVector<T> arenaVector(TickArena& arena, size_t reserve = 0) {
+    ArenaVector<T> v{ArenaAllocator<T>(arena)};
+    v.reserve(reserve);
+    return v;
+}
+
+template <typename K, typename V>
+ArenaMap<K, V> arenaMap(TickArena& arena, size_t buckets) {
+    return ArenaMap<K, V>(buckets, std::hash<K>(), std::equal_to<K>(),
+                          ArenaAllocator<std::pair<const K, V>>(arena));
+}
+
+// ============================================================
+// Allocation Accounting
+// ============================================================
+// Heap allocations made through operator new by code in this module on the
+// calling thread. Counting relies on operator new/delete replacements bound
+// inside the module (arena.cpp), which needs an ELF toolchain; elsewhere
+// the counter stays at zero and allocationCountingSupported() says so.
+
+uint64_t threadHeapAllocations();
+bool     allocationCountingSupported();
+
+// ============================================================
+// Huge Pages
+// ============================================================
+// Advises the kernel to back [data, data + bytes) with transparent huge
+// pages (Linux madvise(MADV_HUGEPAGE); only whole 2 MB pages inside the
+// range can be promoted). Returns the number of bytes advised, 0 where
+// unsupported.
+
+size_t adviseHugePages(const void* data, size_t bytes);
@@ -0,0 +1,265 @@
+#include "broadcast.h"
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// ============================================================
+// WebSocket Frame Encoding
+// ============================================================
+// Server frames are never masked: FIN + opcode, then a 7-bit, 16-bit or
+// 64-bit big-endian payload length.
+
+WsFrame buildWsFrame(uint8_t opcode, const uint8_t* payload, size_t len) {
+    auto buf = std::make_shared<std::vector<uint8_t>>();
+    buf->reserve(len + 10);
+
+    buf->push_back((uint8_t)(0x80 | (opcode & 0x0F)));
+    if (len < 126) {
+        buf->push_back((uint8_t)len);
+    } else if (len <= 0xFFFF) {
+        buf->push_back(126);
+        buf->push_back((uint8_t)(len >> 8));
+        buf->push_back((uint8_t)(len & 0xFF));
+    } else {
+        buf->push_back(127);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            buf->push_back((uint8_t)((uint64_t)len >> shift));
+        }
+    }
+    buf->insert(buf->end(), payload, payload + len);
+    return buf;
+}
+
+// ============================================================
+// SenderPool Implementation
+// ============================================================
+
+static constexpr uint64_t WAKE_TAG = UINT64_MAX;
+
+#ifdef __linux__
+
+SenderPool::SenderPool(int numThreads) {
+    if (numThreads < 1) numThreads = 1;
+    for (int i = 0; i < numThreads; ++i) {
+        auto w = std::make_unique<Worker>();
+        w->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        w->wakeFd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = WAKE_TAG;
+        epoll_ctl(w->epollFd, EPOLL_CTL_ADD, w->wakeFd, &ev);
+
+        workers_.push_back(std::move(w));
+    }
+    for (auto& w : workers_) {
+        Worker* wp = w.get();
+        wp->thread = std::thread([this, wp] { run(*wp); });
+    }
+}
+
+SenderPool::~SenderPool() {
+    running_ = false;
+    for (auto& w : workers_) {
+        uint64_t one = 1;
+        (void)!write(w->wakeFd, &one, sizeof(one));
+    }
+    for (auto& w : workers_) {
+        if (w->thread.joinable()) w->thread.join();
+        for (auto& [id, c] : w->conns) close(c.fd);
+        close(w->wakeFd);
+        close(w->epollFd);
+    }
+}
+
+void SenderPool::post(Worker& w, Command cmd) {
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.inbox.push_back(std::move(cmd));
+    }
+    uint64_t one = 1;
+    (void)!write(w.wakeFd, &one, sizeof(one));
+}
+
+void SenderPool::addConnection(uint32_t connId, int fd) {
+    post(workerFor(connId), {CommandType::Add, connId, fd, nullptr});
+}
+
+void SenderPool::removeConnection(uint32_t connId) {
+    post(workerFor(connId), {CommandType::Remove, connId, -1, nullptr});
+}
+
+void SenderPool::closeAfterFlush(uint32_t connId) {
+    post(workerFor(connId), {CommandType::CloseAfterFlush, connId, -1, nullptr});
+}
+
+void SenderPool::subscribe(uint32_t connId, uint8_t group) {
+    post(workerFor(connId), {CommandType::Subscribe, connId, -1, nullptr, group});
+}
+
+void SenderPool::send(uint32_t connId, const WsFrame& frame) {
+    post(workerFor(connId), {CommandType::Send, connId, -1, frame});
+}
+
+void SenderPool::broadcast(const WsFrame& frame, uint8_t group) {
+    for (auto& w : workers_) {
+        post(*w, {CommandType::Broadcast, 0, -1, frame, group});
+    }
+}
+
+SenderStats SenderPool::stats() const {
+    SenderStats s;
+    s.framesQueued  = framesQueued_.load();
+    s.framesDropped = framesDropped_.load();
+    s.bytesSent     = bytesSent_.load();
+    s.connections   = connections_.load();
+    return s;
+}
+
+void SenderPool::run(Worker& w) {
+    epoll_event events[64];
+    std::vector<Command> batch;
+
+    while (running_) {
+        int n = epoll_wait(w.epollFd, events, 64, -1);
+        if (n < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.u64 == WAKE_TAG) {
+                uint64_t v;
+                (void)!read(w.wakeFd, &v, sizeof(v));
+                continue;
+            }
+            auto it = w.conns.find((uint32_t)events[i].data.u64);
+            if (it != w.conns.end()) flush(it->second);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            batch.swap(w.inbox);
+        }
+        for (auto& cmd : batch) apply(w, cmd);
+        batch.clear();
+    }
+}
+
+void SenderPool::apply(Worker& w, Command& cmd) {
+    switch (cmd.type) {
+        case CommandType::Add: {
+            Connection c;
+            c.fd = cmd.fd;
+            // Edge-triggered: we only hear about writability after EAGAIN
+            epoll_event ev{};
+            ev.events = EPOLLOUT | EPOLLET;
+            ev.data.u64 = cmd.connId;
+            epoll_ctl(w.epollFd, EPOLL_CTL_ADD, cmd.fd, &ev);
+            w.conns[cmd.connId] = std::move(c);
+            connections_++;
+            break;
+        }
+        case CommandType::Remove: {
+            auto it = w.conns.find(cmd.connId);
+            if (it == w.conns.end()) break;
+            epoll_ctl(w.epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+            close(it->second.fd);
+            w.conns.erase(it);
+            connections_--;
+            break;
+        }
+        case CommandType::Subscribe: {
+            auto it = w.conns.find(cmd.connId);
+            if (it != w.conns.end()) it->second.group = cmd.group;
+            break;
+        }
+        case CommandType::Send: {
+            auto it = w.conns.find(cmd.connId);
+            if (it == w.conns.end()) break;
+            enqueue(it->second, cmd.frame, false);
+            flush(it->second);
+            break;
+        }
+        case CommandType::Broadcast: {
+            for (auto& [id, c] : w.conns) {
+                if (c.group != cmd.group) continue;
+                enqueue(c, cmd.frame, true);
+                flush(c);
+            }
+            break;
+        }
+        case CommandType::CloseAfterFlush: {
+            auto it = w.conns.find(cmd.connId);
+            if (it == w.conns.end()) break;
+            it->second.group = 0;   // nothing new but what is already queued
+            it->second.closing = true;
+            flush(it->second);
+            break;
+        }
+    }
+}
+
+void SenderPool::enqueue(Connection& c, const WsFrame& frame, bool droppable) {
+    if (c.broken) return;
+    if (droppable && c.queuedBytes > SENDER_MAX_BACKLOG) {
+        framesDropped_++;
+        return;
+    }
+    c.queue.push_back(frame);
+    c.queuedBytes += frame->size();
+    framesQueued_++;
+}
+
+void SenderPool::flush(Connection& c) {
+    while (!c.queue.empty() && !c.broken) {
+        const std::vector<uint8_t>& f = *c.queue.front();
+        ssize_t n = ::send(c.fd, f.data() + c.headOffset, f.size() - c.headOffset,
+                           MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            if (errno == EINTR) continue;
+            // Peer is gone; the reading side will notice and remove us
+            c.broken = true;
+            break;
+        }
+        bytesSent_ += (uint64_t)n;
+        c.headOffset += (size_t)n;
+        if (c.headOffset == f.size()) {
+            c.queuedBytes -= f.size();
+            c.queue.pop_front();
+            c.headOffset = 0;
+        }
+    }
+    if (c.broken) {
+        c.queue.clear();
+        c.queuedBytes = 0;
+        c.headOffset = 0;
+    }
+    if (c.closing && c.queue.empty()) {
+        ::shutdown(c.fd, SHUT_RDWR);
+        c.closing = false;
+    }
+}
+
+#else  // !__linux__ — native fan-out is Linux-only; frames are dropped
+
+SenderPool::SenderPool(int) {}
+SenderPool::~SenderPool() {}
+void SenderPool::post(Worker&, Command) {}
+void SenderPool::addConnection(uint32_t, int) {}
+void SenderPool::removeConnection(uint32_t) {}
+void SenderPool::closeAfterFlush(uint32_t) {}
+void SenderPool::subscribe(uint32_t, uint8_t) {}
+void SenderPool::send(uint32_t, const WsFrame&) {}
+void SenderPool::broadcast(const WsFrame&, uint8_t) {}
+SenderStats SenderPool::stats() const { return {}; }
+void SenderPool::run(Worker&) {}
+void SenderPool::apply(Worker&, Command&) {}
+void SenderPool::enqueue(Connection&, const WsFrame&, bool) {}
+void SenderPool::flush(Connection&) {}
+
+#endif
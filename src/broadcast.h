@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+
+// ============================================================
+// WebSocket framing (RFC 6455, server -> client)
+// ============================================================
+
+static constexpr uint8_t WS_OP_CONTINUATION = 0x0;
+static constexpr uint8_t WS_OP_TEXT         = 0x1;
+static constexpr uint8_t WS_OP_BINARY       = 0x2;
+static constexpr uint8_t WS_OP_CLOSE        = 0x8;
+static constexpr uint8_t WS_OP_PING         = 0x9;
+static constexpr uint8_t WS_OP_PONG         = 0xA;
+
+// An encoded frame (header + payload). Immutable once built, so one frame
+// can be queued on any number of connections without copying.
+using WsFrame = std::shared_ptr<const std::vector<uint8_t>>;
+
+WsFrame buildWsFrame(uint8_t opcode, const uint8_t* payload, size_t len);
+
+// ============================================================
+// SenderPool
+// ============================================================
+// Native fan-out: connections are spread over a few worker threads, each
+// running its own epoll loop. broadcast() posts one command per worker (not
+// per connection); the worker appends the shared frame to each of its
+// connections and drains them with non-blocking writes.
+//
+// Ownership: addConnection() hands the fd to the pool for writing;
+// removeConnection() makes the owning worker close it, so the fd number can
+// never be reused while a write is still pending. New connections only get
+// unicast traffic until subscribe() opts them into one broadcast group.
+
+static constexpr size_t SENDER_MAX_BACKLOG = 512 * 1024;  // bytes queued per connection
+
+static constexpr uint8_t SENDER_GROUP_PLAYERS    = 1;
+static constexpr uint8_t SENDER_GROUP_SPECTATORS = 2;
+
+struct SenderStats {
+    uint64_t framesQueued  = 0;
+    uint64_t framesDropped = 0;   // broadcasts skipped on backlogged sockets
+    uint64_t bytesSent     = 0;
+    uint32_t connections   = 0;
+};
+
+class SenderPool {
+public:
+    explicit SenderPool(int numThreads);
+    ~SenderPool();
+
+    SenderPool(const SenderPool&) = delete;
+    SenderPool& operator=(const SenderPool&) = delete;
+
+    void addConnection(uint32_t connId, int fd);
+    void removeConnection(uint32_t connId);
+    // Shuts the socket down once everything queued for it is written; the
+    // reading side then sees EOF and removes the connection as usual
+    void closeAfterFlush(uint32_t connId);
+    void subscribe(uint32_t connId, uint8_t group = SENDER_GROUP_PLAYERS);
+
+    // Reliable unicast (handshake replies, init, control frames)
+    void send(uint32_t connId, const WsFrame& frame);
+    // Droppable fan-out to every connection in a group (snapshots)
+    void broadcast(const WsFrame& frame, uint8_t group = SENDER_GROUP_PLAYERS);
+
+    SenderStats stats() const;
+
+private:
+    enum class CommandType : uint8_t { Add, Remove, Subscribe, Send, Broadcast, CloseAfterFlush };
+
+    struct Command {
+        CommandType type;
+        uint32_t connId;
+        int fd;
+        WsFrame frame;
+        uint8_t group = 0;
+    };
+
+    struct Connection {
+        int fd = -1;
+        std::deque<WsFrame> queue;
+        size_t headOffset  = 0;   // bytes of queue.front() already written
+        size_t queuedBytes = 0;
+        uint8_t group = 0;        // 0 until subscribed
+        bool broken = false;
+        bool closing = false;     // shut down once the queue drains
+    };
+
+    struct Worker {
+        int epollFd = -1;
+        int wakeFd  = -1;
+        std::thread thread;
+        std::mutex mutex;
+        std::vector<Command> inbox;
+        std::unordered_map<uint32_t, Connection> conns;
+    };
+
+    void post(Worker& w, Command cmd);
+    void run(Worker& w);
+    void apply(Worker& w, Command& cmd);
+    void enqueue(Connection& c, const WsFrame& frame, bool droppable);
+    void flush(Connection& c);
+
+    Worker& workerFor(uint32_t connId) { return *workers_[connId % workers_.size()]; }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_{true};
+
+    std::atomic<uint64_t> framesQueued_{0};
+    std::atomic<uint64_t> framesDropped_{0};
+    std::atomic<uint64_t> bytesSent_{0};
+    std::atomic<uint32_t> connections_{0};
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "rng.h"
+#include <cstdint>
+#include <cstring>
+
+// ============================================================
+// State Checksum
+// ============================================================
+// One hash per subsystem of the canonical world state (players in id
+// order, boids and items in vector order, which is id order). Floats are
+// hashed by bit pattern, so a rewrite that changes a single rounding is
+// caught at the first tick it happens, and the part that differs says
+// where to look.
+
+enum ChecksumPart : uint8_t {
+    CHK_WORLD     = 0,   // tick, id counters, spawn accumulators, RNG streams
+    CHK_PLAYERS   = 1,
+    CHK_BOIDS     = 2,
+    CHK_RESOURCES = 3,
+    CHK_PICKUPS   = 4,
+    CHK_PART_COUNT
+};
+
+static const char* const CHECKSUM_PART_NAMES[CHK_PART_COUNT] = {
+    "world", "players", "boids", "resources", "pickups"
+};
+
+struct StateChecksum {
+    uint32_t tick = 0;
+    uint64_t part[CHK_PART_COUNT] = {};
+
+    uint64_t combined() const {
+        uint64_t h = 0;
+        for (uint64_t p : part) h = rngMix64(h ^ p);
+        return h;
+    }
+
+    // First part that differs, or -1 if all match
+    int firstDifference(const StateChecksum& o) const {
+        for (int i = 0; i < CHK_PART_COUNT; ++i)
+            if (part[i] != o.part[i]) return i;
+        return -1;
+    }
+};
+
+// FNV-1a over 64-bit words (one multiply per word), finished with the
+// SplitMix64 mixer
+struct StateHasher {
+    uint64_t h = 0xCBF29CE484222325ull;
+
+    void word(uint64_t w) { h = (h ^ w) * 0x100000001B3ull; }
+    void pair(uint32_t lo, uint32_t hi) { word(((uint64_t)hi << 32) | lo); }
+    void pair(float lo, float hi) {
+        uint32_t a, b;
+        memcpy(&a, &lo, 4);
+        memcpy(&b, &hi, 4);
+        pair(a, b);
+    }
+
+    uint64_t finish() const { return rngMix64(h); }
+};
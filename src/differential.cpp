@@ -0,0 +1,347 @@
+#include "differential.h"
+#include "reference_engine.h"
+#include "recorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// ============================================================
+// Scenario Playback
+// ============================================================
+
+// Join slot -> player id, per engine (ids only agree until a divergence)
+struct SlotTable {
+    std::vector<uint32_t> ids;     // 0 once the slot left
+};
+
+template <typename Engine>
+static void applyCommand(Engine& engine, SlotTable& slots, const DiffCommand& c) {
+    if (c.type == REC_JOIN) {
+        slots.ids.push_back(engine.addPlayer());
+        return;
+    }
+    if (c.slot >= slots.ids.size() || slots.ids[c.slot] == 0) return;
+    uint32_t pid = slots.ids[c.slot];
+
+    switch (c.type) {
+        case REC_LEAVE:
+            engine.removePlayer(pid);
+            slots.ids[c.slot] = 0;
+            break;
+        case REC_CURSOR:
+            engine.setPlayerCursor(pid, c.x, c.y);
+            break;
+        case REC_BOOST:
+            engine.setPlayerBoost(pid, c.flag != 0);
+            break;
+        case REC_INPUT: {
+            InputCommand in;
+            in.playerId = pid;
+            in.seq      = c.seq;
+            in.x        = c.x;
+            in.y        = c.y;
+            in.boost    = c.flag != 0;
+            engine.injectInput(in);
+            break;
+        }
+    }
+}
+
+// ============================================================
+// State Comparison
+// ============================================================
+
+struct Comparer {
+    float tolerance;
+    double maxError = 0.0;
+    std::string detail = {};
+
+    bool near(const char* what, uint32_t id, const char* field, float a, float b) {
+        double err = std::fabs((double)a - (double)b);
+        if (err > maxError && err == err) maxError = err;
+        if (err <= tolerance) return true;
+        fail(what, id, field, std::to_string(a), std::to_string(b));
+        return false;
+    }
+
+    bool equal(const char* what, uint32_t id, const char* field, int64_t a, int64_t b) {
+        if (a == b) return true;
+        fail(what, id, field, std::to_string(a), std::to_string(b));
+        return false;
+    }
+
+    void fail(const char* what, uint32_t id, const char* field,
+              const std::string& engine, const std::string& reference) {
+        detail = std::string(what) + " " + std::to_string(id) + " " + field
+               + ": engine " + engine + ", reference " + reference;
+    }
+
+    bool players(const std::unordered_map<uint32_t, Player>& a,
+                 const std::unordered_map<uint32_t, Player>& b) {
+        if (!equal("players", 0, "count", (int64_t)a.size(), (int64_t)b.size())) return false;
+        for (auto& [pid, p] : a) {
+            auto it = b.find(pid);
+            if (it == b.end()) {
+                fail("player", pid, "presence", "present", "missing");
+                return false;
+            }
+            const Player& q = it->second;
+            if (!equal("player", pid, "score", p.score, q.score)
+                || !equal("player", pid, "alive", p.alive, q.alive)
+                || !equal("player", pid, "boosting", p.boosting, q.boosting)
+                || !equal("player", pid, "hasInput", p.hasInput, q.hasInput)
+                || !equal("player", pid, "lastInputSeq", p.lastInputSeq, q.lastInputSeq)
+                || !equal("player", pid, "shieldTicks", p.shieldTicks, q.shieldTicks)
+                || !equal("player", pid, "speedBurstTicks", p.speedBurstTicks, q.speedBurstTicks)
+                || !equal("player", pid, "slowTicks", p.slowTicks, q.slowTicks)
+                || !near("player", pid, "cursor.x", p.cursor.x, q.cursor.x)
+                || !near("player", pid, "cursor.y", p.cursor.y, q.cursor.y)
+                || !near("player", pid, "boostFuel", p.boostFuel, q.boostFuel)
+                || !near("player", pid, "mutations.speed", p.mutations.speed, q.mutations.speed)
+                || !near("player", pid, "mutations.cohesion", p.mutations.cohesion, q.mutations.cohesion)
+                || !near("player", pid, "mutations.aggression", p.mutations.aggression, q.mutations.aggression)
+                || !near("player", pid, "mutations.collectRange", p.mutations.collectRange, q.mutations.collectRange))
+                return false;
+        }
+        return true;
+    }
+
+    bool boids(const std::vector<Boid>& a, const std::vector<Boid>& b) {
+        size_t n = std::min(a.size(), b.size());
+        for (size_t i = 0; i < n; ++i) {
+            const Boid& p = a[i];
+            const Boid& q = b[i];
+            if (!equal("boid", p.id, "id", p.id, q.id)
+                || !equal("boid", p.id, "playerId", p.playerId, q.playerId)
+                || !near("boid", p.id, "pos.x", p.pos.x, q.pos.x)
+                || !near("boid", p.id, "pos.y", p.pos.y, q.pos.y)
+                || !near("boid", p.id, "vel.x", p.vel.x, q.vel.x)
+                || !near("boid", p.id, "vel.y", p.vel.y, q.vel.y))
+                return false;
+        }
+        return equal("boids", 0, "count", (int64_t)a.size(), (int64_t)b.size());
+    }
+
+    bool resources(const std::vector<Resource>& a, const std::vector<Resource>& b) {
+        if (!equal("resources", 0, "count", (int64_t)a.size(), (int64_t)b.size())) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            const Resource& p = a[i];
+            const Resource& q = b[i];
+            if (!equal("resource", p.id, "id", p.id, q.id)
+                || !equal("resource", p.id, "value", p.value, q.value)
+                || !equal("resource", p.id, "type", p.type, q.type)
+                || !near("resource", p.id, "pos.x", p.pos.x, q.pos.x)
+                || !near("resource", p.id, "pos.y", p.pos.y, q.pos.y))
+                return false;
+        }
+        return true;
+    }
+
+    bool pickups(const std::vector<Pickup>& a, const std::vector<Pickup>& b) {
+        if (!equal("pickups", 0, "count", (int64_t)a.size(), (int64_t)b.size())) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            const Pickup& p = a[i];
+            const Pickup& q = b[i];
+            if (!equal("pickup", p.id, "id", p.id, q.id)
+                || !equal("pickup", p.id, "type", p.type, q.type)
+                || !near("pickup", p.id, "pos.x", p.pos.x, q.pos.x)
+                || !near("pickup", p.id, "pos.y", p.pos.y, q.pos.y))
+                return false;
+        }
+        return true;
+    }
+};
+
+// Returns the first differing part (-1 if none) and fills cmp.detail
+static int compareEngines(const GameEngine& engine, const ReferenceEngine& ref, Comparer& cmp) {
+    StateChecksum a = engine.checksum();
+    StateChecksum b = ref.checksum();
+    bool exact = cmp.tolerance <= 0.0f;
+
+    for (int part = 0; part < CHK_PART_COUNT; ++part) {
+        bool bitsMatch = a.part[part] == b.part[part];
+        if (exact && bitsMatch) continue;
+
+        bool ok = true;
+        switch (part) {
+            case CHK_WORLD:
+                if (!bitsMatch) cmp.detail = "tick, id counters, spawn accumulators or RNG streams";
+                ok = bitsMatch;
+                break;
+            case CHK_PLAYERS:   ok = cmp.players(engine.getPlayers(), ref.players()); break;
+            case CHK_BOIDS:     ok = cmp.boids(engine.getBoids(), ref.boids()); break;
+            case CHK_RESOURCES: ok = cmp.resources(engine.getResources(), ref.resources()); break;
+            case CHK_PICKUPS:   ok = cmp.pickups(engine.getPickups(), ref.pickups()); break;
+        }
+        if (exact && ok) {
+            cmp.detail = "bitwise only (-0/+0 or NaN payload)";
+            ok = false;
+        }
+        if (!ok) return part;
+    }
+    return -1;
+}
+
+// ============================================================
+// Snapshot Roster
+// ============================================================
+// Snapshots can be taken between ticks (a join or leave followed by a
+// getStateFor before the next tick), so after every roster change the
+// encoded snapshot must list exactly the reference's players, with one
+// swarm (full or impostor) per player carrying that player's boid count.
+
+struct SnapshotReader {
+    const uint8_t* p;
+    const uint8_t* end;
+
+    bool has(size_t n) const { return (size_t)(end - p) >= n; }
+    uint16_t u16() { uint16_t v; memcpy(&v, p, 2); p += 2; return v; }
+    uint32_t u32() { uint32_t v; memcpy(&v, p, 4); p += 4; return v; }
+    bool skipVarint() {
+        while (p < end) {
+            if ((*p++ & 0x80) == 0) return true;
+        }
+        return false;
+    }
+};
+
+// Returns false and fills cmp.detail on the first mismatch
+static bool checkSnapshotRoster(const std::vector<uint8_t>& snap, const ReferenceEngine& ref,
+                                Comparer& cmp) {
+    std::vector<std::pair<uint32_t, int64_t>> expected;   // (id, boids), id order
+    for (auto& [pid, player] : ref.players()) expected.push_back({pid, 0});
+    std::sort(expected.begin(), expected.end());
+    for (const Boid& b : ref.boids()) {
+        auto it = std::lower_bound(expected.begin(), expected.end(), std::make_pair(b.playerId, (int64_t)0));
+        if (it != expected.end() && it->first == b.playerId) it->second++;
+    }
+
+    SnapshotReader r{snap.data(), snap.data() + snap.size()};
+    auto truncated = [&]() {
+        cmp.detail = "snapshot truncated";
+        return false;
+    };
+    if (!r.has(18)) return truncated();
+    r.p += 4;   // map size
+    uint16_t numPlayers   = r.u16();
+    uint16_t numSwarms    = r.u16();
+    uint16_t numResources = r.u16();
+    uint16_t numPickups   = r.u16();
+    uint16_t numImpostors = r.u16();
+    r.p += 4;   // tick
+    if (!cmp.equal("snapshot", 0, "numPlayers", numPlayers, (int64_t)expected.size())
+        || !cmp.equal("snapshot", 0, "numSwarms+numImpostors", numSwarms + numImpostors,
+                      (int64_t)expected.size()))
+        return false;
+
+    for (uint16_t i = 0; i < numPlayers; ++i) {
+        if (!r.has(PLAYER_ROW_BYTES)) return truncated();
+        uint32_t pid = r.u32();
+        r.p += PLAYER_ROW_BYTES - 4;
+        if (!cmp.equal("snapshot", pid, "player row id", pid, expected[i].first)) return false;
+    }
+
+    std::vector<std::pair<uint32_t, int64_t>> swarms;
+    for (uint16_t i = 0; i < numSwarms; ++i) {
+        if (!r.has(6)) return truncated();
+        uint32_t pid = r.u32();
+        uint16_t count = r.u16();
+        swarms.push_back({pid, count});
+        for (uint16_t k = 0; k < count; ++k) {
+            if (!r.skipVarint() || !r.has(6)) return truncated();
+            r.p += 6;
+        }
+    }
+    for (uint32_t i = 0; i < (uint32_t)numResources + numPickups; ++i) {
+        if (!r.skipVarint() || !r.has(5)) return truncated();
+        r.p += 5;
+    }
+    for (uint16_t i = 0; i < numImpostors; ++i) {
+        if (!r.has(18)) return truncated();
+        uint32_t pid = r.u32();
+        uint16_t count = r.u16();
+        r.p += 11;
+        uint8_t clusters = *r.p++;
+        if (!r.has(clusters * 5u)) return truncated();
+        r.p += clusters * 5u;
+        swarms.push_back({pid, count});
+    }
+    if (!cmp.equal("snapshot", 0, "trailing bytes", r.end - r.p, 0)) return false;
+
+    std::sort(swarms.begin(), swarms.end());
+    for (size_t i = 0; i < swarms.size(); ++i) {
+        if (!cmp.equal("snapshot", expected[i].first, "swarm id", swarms[i].first, expected[i].first)
+            || !cmp.equal("snapshot", swarms[i].first, "swarm count", swarms[i].second, expected[i].second))
+            return false;
+    }
+    return true;
+}
+
+// ============================================================
+// Driver
+// ============================================================
+
+bool runDifferential(const DiffScenario& scenario, DiffResult& out, std::string& error) {
+    if (scenario.seed == 0) {
+        error = "differential scenarios need a non-zero seed";
+        return false;
+    }
+
+    GameEngine engine(scenario.seed);
+    ReferenceEngine ref(scenario.seed);
+    SlotTable engineSlots, refSlots;
+    Comparer cmp{scenario.tolerance};
+    out = DiffResult();
+
+    auto check = [&]() {
+        int part = compareEngines(engine, ref, cmp);
+        out.maxError = cmp.maxError;
+        if (part < 0) return true;
+        out.diverged = true;
+        out.tick     = engine.currentTick();
+        out.part     = part;
+        out.detail   = cmp.detail;
+        return false;
+    };
+
+    if (!check()) return true;
+
+    size_t next = 0;
+    for (uint32_t t = 0; t < scenario.ticks; ++t) {
+        bool rosterChanged = false;
+        for (; next < scenario.commands.size() && scenario.commands[next].tick <= t; ++next) {
+            const DiffCommand& c = scenario.commands[next];
+            applyCommand(engine, engineSlots, c);
+            applyCommand(ref, refSlots, c);
+            rosterChanged |= c.type == REC_JOIN || c.type == REC_LEAVE;
+        }
+
+        // Full snapshot (may be the cached keyframe) and the view of the
+        // first player still in the room, if any
+        if (rosterChanged) {
+            uint32_t viewer = 0;
+            for (uint32_t pid : engineSlots.ids) {
+                if (pid) { viewer = pid; break; }
+            }
+            if (!checkSnapshotRoster(engine.serializeState(), ref, cmp)
+                || !checkSnapshotRoster(engine.serializeStateFor(viewer), ref, cmp)) {
+                out.diverged = true;
+                out.tick     = t + 1;   // cutting here keeps this tick's commands
+                out.part     = CHK_PLAYERS;
+                out.detail   = cmp.detail;
+                return true;
+            }
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        engine.tick();
+        auto t1 = std::chrono::steady_clock::now();
+        ref.tick();
+        auto t2 = std::chrono::steady_clock::now();
+        out.engineMs    += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        out.referenceMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+        if (!check()) return true;
+    }
+    return true;
+}
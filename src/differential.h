@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================
+// Differential Run
+// ============================================================
+// Drives GameEngine and ReferenceEngine through the same scenario and
+// compares them after every tick. With tolerance 0 the comparison is the
+// per-subsystem StateChecksum (bit-exact); with a tolerance, boid, player
+// and item floats may differ by up to that much, everything discrete
+// (ids, counts, scores, timers, RNG state) must still match exactly.
+//
+// Commands address players by join slot (0 = first join of the scenario),
+// not by id, so a minimizer can drop any command and the rest still make
+// sense; commands for a slot that never joined or already left are no-ops.
+
+struct DiffCommand {
+    uint32_t tick;      // applied before this tick runs
+    uint8_t  type;      // REC_JOIN / REC_LEAVE / REC_CURSOR / REC_BOOST / REC_INPUT
+    uint32_t slot;
+    float    x = 0.0f, y = 0.0f;
+    uint8_t  flag = 0;
+    uint16_t seq = 0;
+};
+
+struct DiffScenario {
+    uint64_t seed  = 1;
+    uint32_t ticks = 0;
+    float    tolerance = 0.0f;
+    std::vector<DiffCommand> commands;   // sorted by tick
+};
+
+struct DiffResult {
+    bool     diverged = false;
+    uint32_t tick     = 0;      // state after this many ticks differs (snapshot
+                                // checks: the commands before this tick suffice)
+    int      part     = -1;     // ChecksumPart
+    std::string detail;         // first differing field, human-readable
+    double   maxError = 0.0;    // largest float difference seen (tolerance mode)
+    double   engineMs = 0.0;
+    double   referenceMs = 0.0;
+};
+
+bool runDifferential(const DiffScenario& scenario, DiffResult& out, std::string& error);
@@ -1,65 +1,145 @@
 #include "engine.h"
+#include "lz.h"
+#include "broadcast.h"
+#include "netserver.h"
+#include "recorder.h"
+#include "replay.h"
+#include "differential.h"
+#include "handoff.h"
+#include "hibernate.h"
 #include <node_api.h>
 #include <cstring>
 #include <cassert>
+#include <chrono>
+#include <type_traits>
+
+// ============================================================
+// Game Modes
+// ============================================================
+
+template <typename C>
+static constexpr GameModeInfo makeModeInfo(const char* name) {
+    return GameModeInfo{name, C::MAP_WIDTH, C::MAP_HEIGHT, C::MAX_BOIDS_PER_PLAYER,
+                        C::MAX_RESOURCES, C::MAX_PICKUPS,
+                        C::QUADTREE_MAX_OBJECTS, C::QUADTREE_MAX_LEVELS};
+}
+
+static constexpr GameModeInfo MODE_INFO[GAME_MODE_COUNT] = {
+    makeModeInfo<ClassicConfig>("classic"),
+    makeModeInfo<BlitzConfig>("blitz"),
+    makeModeInfo<MegaConfig>("mega"),
+    makeModeInfo<HordeConfig>("horde"),
+};
+
+// Snapshot coordinates and the per-swarm boid count are u16
+static_assert(MegaConfig::MAP_WIDTH <= 65535.0f && MegaConfig::MAP_HEIGHT <= 65535.0f,
+              "map must fit u16 snapshot coordinates");
+static_assert(HordeConfig::MAX_BOIDS_PER_PLAYER <= 65535, "swarm size must fit u16");
+
+const GameModeInfo& gameModeInfo(GameMode mode) {
+    return MODE_INFO[(int)mode < GAME_MODE_COUNT ? (int)mode : 0];
+}
+
+bool parseGameMode(const std::string& name, GameMode& mode) {
+    for (int i = 0; i < GAME_MODE_COUNT; ++i) {
+        if (name == MODE_INFO[i].name) {
+            mode = (GameMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename F>
+void GameEngine::withConfig(F&& f) {
+    switch (mode_) {
+        case GameMode::Blitz: f(BlitzConfig{}); break;
+        case GameMode::Mega:  f(MegaConfig{}); break;
+        case GameMode::Horde: f(HordeConfig{}); break;
+        default:              f(ClassicConfig{}); break;
+    }
+}
 
 // ============================================================
 // QuadTree Implementation
 // ============================================================
 
-QuadTree::QuadTree(Rect bounds, int level)
-    : bounds_(bounds), level_(level) {
-    objects_.reserve(QUADTREE_MAX_OBJECTS);
+QuadTree::QuadTree(Rect bounds, int nodeObjects) : bounds_(bounds), nodeObjects_(nodeObjects) {
+    clear();
 }
 
 void QuadTree::clear() {
-    objects_.clear();
-    if (divided_) {
-        for (auto& c : children_) c.reset();
-        divided_ = false;
+    used_ = 0;
+    makeNode(bounds_, 0);
+}
+
+uint32_t QuadTree::makeNode(Rect bounds, int level) {
+    if (used_ == nodes_.size()) {
+        nodes_.emplace_back();
+        nodes_.back().objects.reserve(nodeObjects_);
     }
+    Node& n = nodes_[used_];
+    n.bounds = bounds;
+    n.level = level;
+    n.firstChild = 0;
+    n.objects.clear();
+    return used_++;
 }
 
-void QuadTree::subdivide() {
-    float hw = bounds_.w * 0.5f;
-    float hh = bounds_.h * 0.5f;
-    float x  = bounds_.x;
-    float y  = bounds_.y;
+void QuadTree::reserve(size_t nodes) {
+    if (nodes <= nodes_.size()) return;
+    nodes_.reserve(nodes);
+    while (nodes_.size() < nodes) {
+        nodes_.emplace_back();
+        nodes_.back().objects.reserve(nodeObjects_);
+    }
+}
 
-    children_[0] = std::make_unique<QuadTree>(Rect{x,      y,      hw, hh}, level_ + 1);
-    children_[1] = std::make_unique<QuadTree>(Rect{x + hw, y,      hw, hh}, level_ + 1);
-    children_[2] = std::make_unique<QuadTree>(Rect{x,      y + hh, hw, hh}, level_ + 1);
-    children_[3] = std::make_unique<QuadTree>(Rect{x + hw, y + hh, hw, hh}, level_ + 1);
-    divided_ = true;
+void QuadTree::subdivide(uint32_t node) {
+    // Copies: makeNode may grow the pool under a reference
+    Rect b = nodes_[node].bounds;
+    int level = nodes_[node].level + 1;
+    float hw = b.w * 0.5f;
+    float hh = b.h * 0.5f;
+
+    uint32_t first = makeNode(Rect{b.x,      b.y,      hw, hh}, level);
+    makeNode(Rect{b.x + hw, b.y,      hw, hh}, level);
+    makeNode(Rect{b.x,      b.y + hh, hw, hh}, level);
+    makeNode(Rect{b.x + hw, b.y + hh, hw, hh}, level);
+    nodes_[node].firstChild = first;
 }
 
-void QuadTree::insert(const QTEntry& entry) {
-    if (!bounds_.contains(entry.x, entry.y)) return;
+template <int MaxObjects, int MaxLevels>
+void QuadTree::insert(uint32_t node, const QTEntry& entry) {
+    Node& n = nodes_[node];
+    if (!n.bounds.contains(entry.x, entry.y)) return;
 
-    if ((int)objects_.size() < QUADTREE_MAX_OBJECTS || level_ >= QUADTREE_MAX_LEVELS) {
-        objects_.push_back(entry);
+    if ((int)n.objects.size() < MaxObjects || n.level >= MaxLevels) {
+        n.objects.push_back(entry);
         return;
     }
 
-    if (!divided_) subdivide();
+    if (n.firstChild == 0) subdivide(node);
 
-    for (auto& c : children_) {
-        c->insert(entry);
+    uint32_t first = nodes_[node].firstChild;
+    for (uint32_t c = 0; c < 4; ++c) {
+        insert<MaxObjects, MaxLevels>(first + c, entry);
     }
 }
 
-void QuadTree::query(const Rect& range, std::vector<QTEntry>& found) const {
-    if (!bounds_.intersects(range)) return;
+void QuadTree::query(uint32_t node, const Rect& range, ArenaVector<QTEntry>& found) const {
+    const Node& n = nodes_[node];
+    if (!n.bounds.intersects(range)) return;
 
-    for (auto& obj : objects_) {
+    for (auto& obj : n.objects) {
         if (range.contains(obj.x, obj.y)) {
             found.push_back(obj);
         }
     }
 
-    if (divided_) {
-        for (auto& c : children_) {
-            c->query(range, found);
+    if (n.firstChild != 0) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            query(n.firstChild + c, range, found);
         }
     }
 }
@@ -68,116 +148,377 @@ void QuadTree::query(const Rect& range, std::vector<QTEntry>& found) const {
 // GameEngine Implementation
 // ============================================================
 
-GameEngine::GameEngine()
-    : rng_(std::random_device{}()) {
-    quadTree_ = std::make_unique<QuadTree>(Rect{0, 0, MAP_WIDTH, MAP_HEIGHT});
+GameEngine::GameEngine(uint64_t seed, const RoomCapacity& capacity, GameMode mode)
+    : GameEngine(seed, capacity, mode, true) {}
+
+GameEngine::GameEngine(uint64_t seed, const RoomCapacity& capacity, GameMode mode, bool prespawn)
+    : mode_(mode),
+      capacity_(capacity),
+      seed_(seed ? seed : ((uint64_t)std::random_device{}() << 32) ^ std::random_device{}()),
+      rngSpawn_(seed_, RNG_STREAM_SPAWN),
+      rngResource_(seed_, RNG_STREAM_RESOURCE),
+      rngPickup_(seed_, RNG_STREAM_PICKUP),
+      rngEffect_(seed_, RNG_STREAM_EFFECT) {
+    const GameModeInfo& info = modeInfo();
+    quadTree_ = std::make_unique<QuadTree>(Rect{0, 0, info.mapWidth, info.mapHeight},
+                                           info.quadTreeMaxObjects);
+    inputExtent_ = {info.mapWidth, info.mapHeight};
+    minimap_.resize(MINIMAP_GRID_SIZE * MINIMAP_GRID_SIZE);
+    resources_.reserve(info.maxResources);
+    pickups_.reserve(info.maxPickups);
+    reserveRoom();
+    resetChangeTracking();
+    if (!prespawn) return;
 
     // Pre-spawn some resources
-    for (int i = 0; i < MAX_RESOURCES / 2; ++i) {
-        spawnResources();
-        resourceSpawnAccum_ = 0.0f;
-    }
+    withConfig([&](auto config) {
+        using C = decltype(config);
+        for (int i = 0; i < C::MAX_RESOURCES / 2; ++i) {
+            spawnResources<C>();
+            resourceSpawnAccum_ = 0.0f;
+        }
+    });
+    refreshKeyframe();
+}
+
+GameEngine::~GameEngine() {
+    stopRecording();
 }
 
-Vec2 GameEngine::randomPosition() const {
-    std::uniform_real_distribution<float> dx(100.0f, MAP_WIDTH - 100.0f);
-    std::uniform_real_distribution<float> dy(100.0f, MAP_HEIGHT - 100.0f);
-    return {dx(rng_), dy(rng_)};
+// The world comes entirely from the checkpoint, so skip the pre-spawn (and
+// its keyframe encode) that loadState would throw away
+std::unique_ptr<GameEngine> GameEngine::restore(const uint8_t* data, size_t len, std::string& error,
+                                                const RoomCapacity& capacity) {
+    std::unique_ptr<GameEngine> engine(new GameEngine(1, capacity, GameMode::Classic, false));
+    if (!engine->loadState(data, len, error)) return nullptr;
+    return engine;
+}
+
+bool GameEngine::startRecording(const std::string& path, std::string& error) {
+    stopRecording();
+    auto rec = std::make_unique<InputRecorder>();
+    if (!rec->open(path, seed_, error)) return false;
+    rec->keyframe(tick_, saveState(false));
+    recorder_ = std::move(rec);
+    return true;
+}
+
+void GameEngine::stopRecording() {
+    if (!recorder_) return;
+    recorder_->close(tick_);
+    recorder_.reset();
+}
+
+template <typename C>
+Vec2 GameEngine::randomPosition(RngStream& rng) {
+    float x = rng.uniform(100.0f, C::MAP_WIDTH - 100.0f);
+    float y = rng.uniform(100.0f, C::MAP_HEIGHT - 100.0f);
+    return {x, y};
 }
 
 uint32_t GameEngine::addPlayer() {
+    if (capacity_.maxPlayers && playerOrder_.size() >= capacity_.maxPlayers) {
+        capacityStats_.rejectedJoins++;
+        return 0;
+    }
     uint32_t pid = nextPlayerId_++;
-    Player p;
-    p.id = pid;
-    p.cursor = {MAP_WIDTH * 0.5f, MAP_HEIGHT * 0.5f};
-    players_[pid] = p;
-    spawnBoidsForPlayer(pid, INITIAL_BOIDS);
+    PlayerHot hot;
+    hot.cursor = {modeInfo().mapWidth * 0.5f, modeInfo().mapHeight * 0.5f};
+    playerOrder_.push_back(pid);   // ids only grow, so the new slot is last
+    playerHot_.push_back(hot);
+    playerCold_.push_back(PlayerCold{});
+    playerChanges_.push_back(PlayerChanges{});
+    uint32_t slot = (uint32_t)playerOrder_.size() - 1;
+    playerRowStale_.assign(playerOrder_.size(), 1);
+    markPlayer(slot, PLAYER_ALL_COMPONENTS);
+    withConfig([&](auto config) {
+        using C = decltype(config);
+        spawnBoidsForPlayer<C>(slot, C::INITIAL_BOIDS);
+    });
+    computeSwarmSummaries();   // snapshots taken before the next tick
+    keyframeCurrent_ = false;
+    if (recorder_) recorder_->join(tick_, pid);
     return pid;
 }
 
 void GameEngine::removePlayer(uint32_t playerId) {
-    players_.erase(playerId);
-    // Remove all boids belonging to this player
-    boids_.erase(
-        std::remove_if(boids_.begin(), boids_.end(),
-            [playerId](const Boid& b) { return b.playerId == playerId; }),
-        boids_.end()
-    );
+    if (recorder_) recorder_->leave(tick_, playerId);
+    int slot = slotOf(playerId);
+    if (slot < 0) return;
+    playerOrder_.erase(playerOrder_.begin() + slot);
+    playerHot_.erase(playerHot_.begin() + slot);
+    playerCold_.erase(playerCold_.begin() + slot);
+    playerChanges_.erase(playerChanges_.begin() + slot);
+    playerRowStale_.assign(playerOrder_.size(), 1);
+    removedPlayers_.record(playerId, changeEpoch());
+
+    // Remove all boids belonging to this player; later slots shift down
+    boids_.forEach([&](uint32_t row, BoidHot& b) {
+        if (b.slot == (uint32_t)slot) boids_.destroy(row);
+        else if (b.slot > (uint32_t)slot) b.slot--;
+    });
+    boids_.sweep();
+    computeSwarmSummaries();   // summaries index the swept rows and slots
+    keyframeCurrent_ = false;
 }
 
 void GameEngine::setPlayerCursor(uint32_t playerId, float x, float y) {
-    auto it = players_.find(playerId);
-    if (it != players_.end()) {
-        it->second.cursor = {x, y};
+    int slot = slotOf(playerId);
+    if (slot >= 0) {
+        playerHot_[slot].cursor = {x, y};
+        markPlayer(slot, PLAYER_INPUT);
+        if (recorder_) recorder_->cursor(tick_, playerId, x, y);
     }
 }
 
 void GameEngine::setPlayerBoost(uint32_t playerId, bool active) {
-    auto it = players_.find(playerId);
-    if (it != players_.end()) {
-        it->second.boosting = active;
+    int slot = slotOf(playerId);
+    if (slot >= 0) {
+        if (playerHot_[slot].boosting != active) {
+            markPlayer(slot, PLAYER_BOOST);
+            keyframeCurrent_ = false;
+        }
+        playerHot_[slot].boosting = active;
+        if (recorder_) recorder_->boost(tick_, playerId, active);
     }
 }
 
-void GameEngine::spawnBoidsForPlayer(uint32_t playerId, int count) {
-    Vec2 center = randomPosition();
-    std::uniform_real_distribution<float> spread(-30.0f, 30.0f);
-    std::uniform_real_distribution<float> vspread(-1.0f, 1.0f);
+int GameEngine::slotOf(uint32_t playerId) const {
+    auto it = std::lower_bound(playerOrder_.begin(), playerOrder_.end(), playerId);
+    if (it == playerOrder_.end() || *it != playerId) return -1;
+    return (int)(it - playerOrder_.begin());
+}
 
-    for (int i = 0; i < count; ++i) {
-        Boid b;
-        b.id = nextBoidId_++;
-        b.playerId = playerId;
-        b.pos = {center.x + spread(rng_), center.y + spread(rng_)};
-        b.vel = {vspread(rng_), vspread(rng_)};
-        boids_.push_back(b);
+Player GameEngine::playerRecord(uint32_t slot) const {
+    const PlayerHot& hot = playerHot_[slot];
+    const PlayerCold& cold = playerCold_[slot];
+    Player p;
+    p.id                  = playerOrder_[slot];
+    p.cursor              = hot.cursor;
+    p.hasInput            = cold.hasInput;
+    p.lastInputSeq        = cold.lastInputSeq;
+    p.lastInputClientTime = cold.lastInputClientTime;
+    p.mutations           = hot.mutations;
+    p.score               = cold.score;
+    p.alive               = cold.alive;
+    p.boosting            = hot.boosting;
+    p.boostFuel           = hot.boostFuel;
+    p.shieldTicks         = hot.shieldTicks;
+    p.speedBurstTicks     = hot.speedBurstTicks;
+    p.slowTicks           = hot.slowTicks;
+    return p;
+}
+
+std::unordered_map<uint32_t, Player> GameEngine::getPlayers() const {
+    std::unordered_map<uint32_t, Player> players;
+    players.reserve(playerOrder_.size());
+    for (uint32_t slot = 0; slot < (uint32_t)playerOrder_.size(); ++slot) {
+        players[playerOrder_[slot]] = playerRecord(slot);
     }
+    return players;
 }
 
-void GameEngine::spawnResources() {
-    // Count active resources
-    int activeCount = 0;
-    for (auto& r : resources_) {
-        if (r.active) activeCount++;
+std::vector<Boid> GameEngine::getBoids() const {
+    std::vector<Boid> boids;
+    boids.reserve(boids_.live());
+    boids_.forEach([&](uint32_t row, const BoidHot& b) {
+        boids.push_back(Boid{boids_.id(row), playerOrder_[b.slot], b.pos, b.vel});
+    });
+    return boids;
+}
+
+std::vector<Resource> GameEngine::getResources() const {
+    std::vector<Resource> resources;
+    resources.reserve(resources_.rows());
+    for (uint32_t row = 0; row < (uint32_t)resources_.rows(); ++row) {
+        const ResourceYield& y = resources_.get<ResourceYield>(row);
+        resources.push_back(Resource{resources_.id(row), resources_.get<Vec2>(row), y.value, y.type,
+                                     resources_.alive(row)});
+    }
+    return resources;
+}
+
+std::vector<Pickup> GameEngine::getPickups() const {
+    std::vector<Pickup> pickups;
+    pickups.reserve(pickups_.rows());
+    for (uint32_t row = 0; row < (uint32_t)pickups_.rows(); ++row) {
+        pickups.push_back(Pickup{pickups_.id(row), pickups_.get<Vec2>(row),
+                                 pickups_.get<PickupKind>(row).type, pickups_.alive(row)});
+    }
+    return pickups;
+}
+
+bool GameEngine::submitInputFrame(uint32_t playerId, const uint8_t* frame) {
+    uint16_t seq, qx, qy;
+    uint32_t clientTime;
+    memcpy(&seq, frame, 2);
+    memcpy(&qx,  frame + 2, 2);
+    memcpy(&qy,  frame + 4, 2);
+    uint8_t flags    = frame[6];
+    uint8_t reserved = frame[7];
+    memcpy(&clientTime, frame + 8, 4);
+
+    if ((flags & ~INPUT_FLAGS_KNOWN) != 0 || reserved != 0) {
+        inputsRejected_++;
+        return false;
     }
-    if (activeCount >= MAX_RESOURCES) return;
 
-    std::uniform_int_distribution<int> valDist(RESOURCE_VALUE_MIN, RESOURCE_VALUE_MAX);
-    std::uniform_int_distribution<int> typeDist(0, 3);
+    InputCommand cmd;
+    cmd.playerId   = playerId;
+    cmd.seq        = seq;
+    cmd.boost      = (flags & INPUT_FLAG_BOOST) != 0;
+    cmd.clientTime = clientTime;
+
+    // Quantized coordinates can't leave the map, so no further clamping
+    std::lock_guard<std::mutex> lock(inputMutex_);
+    cmd.x = (float)qx * (inputExtent_.x / 65535.0f);
+    cmd.y = (float)qy * (inputExtent_.y / 65535.0f);
+    inputQueue_.push_back(cmd);
+    inputsAccepted_++;
+    return true;
+}
+
+size_t GameEngine::submitInputBatch(const uint8_t* records, size_t len) {
+    size_t accepted = 0;
+    for (size_t off = 0; off + INPUT_RECORD_SIZE <= len; off += INPUT_RECORD_SIZE) {
+        uint32_t pid;
+        memcpy(&pid, records + off, 4);
+        if (submitInputFrame(pid, records + off + 4)) accepted++;
+    }
+    return accepted;
+}
+
+void GameEngine::injectInput(const InputCommand& cmd) {
+    std::lock_guard<std::mutex> lock(inputMutex_);
+    inputQueue_.push_back(cmd);
+}
+
+InputStats GameEngine::getInputStats() const {
+    InputStats s;
+    s.accepted = inputsAccepted_.load();
+    s.rejected = inputsRejected_.load();
+    s.stale    = inputsStale_.load();
+    return s;
+}
+
+// Sequence numbers wrap at 16 bits; "newer" means ahead by less than half
+static inline bool seqNewer(uint16_t a, uint16_t b) {
+    return (int16_t)(uint16_t)(a - b) > 0;
+}
+
+void GameEngine::applyQueuedInputs() {
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        inputScratch_.swap(inputQueue_);
+    }
+    for (auto& cmd : inputScratch_) {
+        int slot = slotOf(cmd.playerId);
+        if (slot < 0) continue;
+        PlayerCold& cold = playerCold_[slot];
+        if (recorder_) recorder_->input(tick_, cmd);
+
+        if (cold.hasInput && !seqNewer(cmd.seq, cold.lastInputSeq)) {
+            inputsStale_++;
+            continue;
+        }
+        cold.hasInput = true;
+        cold.lastInputSeq = cmd.seq;
+        cold.lastInputClientTime = cmd.clientTime;
+        playerHot_[slot].cursor = {cmd.x, cmd.y};
+        uint32_t changed = PLAYER_INPUT;
+        if (playerHot_[slot].boosting != cmd.boost) changed |= PLAYER_BOOST;
+        playerHot_[slot].boosting = cmd.boost;
+        markPlayer(slot, changed);
+    }
+    inputScratch_.clear();
+}
+
+template <typename C>
+void GameEngine::spawnBoidsForPlayer(uint32_t slot, int count) {
+    Vec2 center = randomPosition<C>(rngSpawn_);
 
-    Resource r;
-    r.id = nextResourceId_++;
-    r.pos = randomPosition();
-    r.value = valDist(rng_);
-    r.type = (uint8_t)typeDist(rng_);
-    r.active = true;
-    resources_.push_back(r);
+    for (int i = 0; i < count; ++i) {
+        float sx = rngSpawn_.uniform(-30.0f, 30.0f);
+        float sy = rngSpawn_.uniform(-30.0f, 30.0f);
+        float vx = rngSpawn_.uniform(-1.0f, 1.0f);
+        float vy = rngSpawn_.uniform(-1.0f, 1.0f);
+        spawnBoid(slot, {center.x + sx, center.y + sy}, {vx, vy});
+    }
+}
+
+template <typename C>
+void GameEngine::spawnResources() {
+    if (resources_.live() >= (size_t)C::MAX_RESOURCES) return;
+
+    uint32_t id = nextResourceId_++;
+    Vec2 pos = randomPosition<C>(rngResource_);
+    ResourceYield yield;
+    yield.value = rngResource_.range(C::RESOURCE_VALUE_MIN, C::RESOURCE_VALUE_MAX);
+    yield.type  = (uint8_t)rngResource_.range(0, 3);
+    resources_.create(id, pos, yield);
 }
 
-void GameEngine::buildQuadTree() {
+template <typename C>
+void GameEngine::buildQuadTree(bool updateMinimap) {
+    auto& boids = boids_.column<BoidHot>();
     quadTree_->clear();
-    for (uint32_t i = 0; i < (uint32_t)boids_.size(); ++i) {
+    if (updateMinimap) {
+        std::fill(minimap_.begin(), minimap_.end(), MinimapCell{});
+    }
+
+    const float cellW = C::MAP_WIDTH  / (float)MINIMAP_GRID_SIZE;
+    const float cellH = C::MAP_HEIGHT / (float)MINIMAP_GRID_SIZE;
+
+    for (uint32_t i = 0; i < (uint32_t)boids.size(); ++i) {
         QTEntry e;
         e.boidIndex = i;
-        e.x = boids_[i].pos.x;
-        e.y = boids_[i].pos.y;
-        quadTree_->insert(e);
+        e.x = boids[i].pos.x;
+        e.y = boids[i].pos.y;
+        quadTree_->insert<C::QUADTREE_MAX_OBJECTS, C::QUADTREE_MAX_LEVELS>(e);
+
+        if (!updateMinimap) continue;
+        int cx = std::clamp((int)(e.x / cellW), 0, MINIMAP_GRID_SIZE - 1);
+        int cy = std::clamp((int)(e.y / cellH), 0, MINIMAP_GRID_SIZE - 1);
+        MinimapCell& cell = minimap_[cy * MINIMAP_GRID_SIZE + cx];
+        uint32_t owner = playerOrder_[boids[i].slot];
+        cell.count++;
+        if (cell.votes == 0) {
+            cell.owner = owner;
+            cell.votes = 1;
+        } else if (cell.owner == owner) {
+            cell.votes++;
+        } else {
+            cell.votes--;
+        }
     }
 }
 
-void GameEngine::applyBoidRules() {
-    float maxRadius = std::max({SEPARATION_RADIUS, ALIGNMENT_RADIUS, COHESION_RADIUS, 120.0f});
-    std::vector<QTEntry> nearby;
-    nearby.reserve(64);
-
-    for (auto& boid : boids_) {
-        auto pit = players_.find(boid.playerId);
-        if (pit == players_.end()) continue;
-        const Player& player = pit->second;
-        const Mutations& mut = player.mutations;
-
-        float effectiveCohesionRadius = COHESION_RADIUS * mut.cohesion;
-        float queryR = std::max({SEPARATION_RADIUS, ALIGNMENT_RADIUS, effectiveCohesionRadius, BOID_BASE_AGGRESSION * mut.aggression});
+// Boids are stepped in index order (each sees the already-updated
+// neighbours before it), one run of consecutive same-owner boids at a time.
+// A run goes to the kernel instantiated for its owner's effect flags, so
+// the speed cap and the mutation-derived radii and weights are run
+// constants and the flag tests compile away. Same operations in the same
+// order as the plain loop, so results are bit-identical.
+
+template <typename C, uint32_t Effects>
+void GameEngine::steerBoids(uint32_t begin, uint32_t end, ArenaVector<QTEntry>& nearby) {
+    auto& boids = boids_.column<BoidHot>();
+    const PlayerHot& player = playerHot_[boids[begin].slot];
+    const Mutations& mut = player.mutations;
+
+    const float effectiveCohesionRadius = C::COHESION_RADIUS * mut.cohesion;
+    const float aggroRange = C::BOID_BASE_AGGRESSION * mut.aggression;
+    const float queryR = std::max({C::SEPARATION_RADIUS, C::ALIGNMENT_RADIUS, effectiveCohesionRadius, aggroRange});
+    const float cohesionWeight = C::COHESION_WEIGHT * mut.cohesion;
+    const float chaseWeight = 1.5f * mut.aggression;
+
+    float maxSpeed = C::BOID_BASE_SPEED * mut.speed;
+    if constexpr ((Effects & BOID_FX_BOOST) != 0) maxSpeed *= C::BOOST_SPEED_MULT;
+    if constexpr ((Effects & BOID_FX_BURST) != 0) maxSpeed *= C::SPEED_BURST_MULT;
+    if constexpr ((Effects & BOID_FX_SLOW) != 0)  maxSpeed *= C::SLOW_MULT;
+
+    for (uint32_t i = begin; i < end; ++i) {
+        BoidHot& boid = boids[i];
 
         Rect queryRect = {
             boid.pos.x - queryR, boid.pos.y - queryR,
@@ -193,24 +534,23 @@ void GameEngine::applyBoidRules() {
         int  alignCount = 0;
         int  cohesionCount = 0;
 
-        Vec2 chase = {0, 0};
         float closestEnemyDist = 1e9f;
         int closestEnemyIdx = -1;
 
         for (auto& ne : nearby) {
-            if (ne.boidIndex == (uint32_t)(&boid - &boids_[0])) continue;
+            if (ne.boidIndex == i) continue;
 
-            const Boid& other = boids_[ne.boidIndex];
+            const BoidHot& other = boids[ne.boidIndex];
             Vec2 diff = boid.pos - other.pos;
             float distSq = diff.lengthSq();
             float dist = std::sqrt(distSq);
 
-            if (other.playerId == boid.playerId) {
+            if (other.slot == boid.slot) {
                 // Same team — Boids rules
-                if (dist < SEPARATION_RADIUS && dist > 0.01f) {
+                if (dist < C::SEPARATION_RADIUS && dist > 0.01f) {
                     separation += diff * (1.0f / dist);
                 }
-                if (dist < ALIGNMENT_RADIUS) {
+                if (dist < C::ALIGNMENT_RADIUS) {
                     alignment += other.vel;
                     alignCount++;
                 }
@@ -220,7 +560,6 @@ void GameEngine::applyBoidRules() {
                 }
             } else {
                 // Enemy — aggression check
-                float aggroRange = BOID_BASE_AGGRESSION * mut.aggression;
                 if (dist < aggroRange && dist < closestEnemyDist) {
                     closestEnemyDist = dist;
                     closestEnemyIdx = (int)ne.boidIndex;
@@ -231,14 +570,14 @@ void GameEngine::applyBoidRules() {
         Vec2 steer = {0, 0};
 
         // Separation
-        steer += separation * SEPARATION_WEIGHT;
+        steer += separation * C::SEPARATION_WEIGHT;
 
         // Alignment
         if (alignCount > 0) {
             alignment = alignment * (1.0f / (float)alignCount);
             Vec2 alignSteer = alignment - boid.vel;
             alignSteer.clampLength(0.5f);
-            steer += alignSteer * ALIGNMENT_WEIGHT;
+            steer += alignSteer * C::ALIGNMENT_WEIGHT;
         }
 
         // Cohesion (defense)
@@ -246,7 +585,7 @@ void GameEngine::applyBoidRules() {
             cohesionCenter = cohesionCenter * (1.0f / (float)cohesionCount);
             Vec2 toCenter = cohesionCenter - boid.pos;
             toCenter.clampLength(0.5f);
-            steer += toCenter * (COHESION_WEIGHT * mut.cohesion);
+            steer += toCenter * cohesionWeight;
         }
 
         // Cursor attraction
@@ -254,64 +593,121 @@ void GameEngine::applyBoidRules() {
         float cursorDist = toCursor.length();
         if (cursorDist > 5.0f) {
             toCursor = toCursor.normalized();
-            steer += toCursor * CURSOR_WEIGHT;
+            steer += toCursor * C::CURSOR_WEIGHT;
         }
 
         // Chase enemy
         if (closestEnemyIdx >= 0) {
-            Vec2 toEnemy = boids_[closestEnemyIdx].pos - boid.pos;
+            Vec2 toEnemy = boids[closestEnemyIdx].pos - boid.pos;
             toEnemy = toEnemy.normalized();
-            steer += toEnemy * (1.5f * mut.aggression);
+            steer += toEnemy * chaseWeight;
         }
 
-        // Apply steering
+        // Apply steering, capped by the run's (boost / burst / slow) speed
         boid.vel += steer;
-
-        float maxSpeed = BOID_BASE_SPEED * mut.speed;
-        // Boost: multiply speed if player is boosting and has fuel
-        if (player.boosting && player.boostFuel > 0.0f) {
-            maxSpeed *= BOOST_SPEED_MULT;
-        }
-        // Speed burst pickup effect
-        if (player.speedBurstTicks > 0) {
-            maxSpeed *= SPEED_BURST_MULT;
-        }
-        // Slow trap effect
-        if (player.slowTicks > 0) {
-            maxSpeed *= SLOW_MULT;
-        }
         boid.vel.clampLength(maxSpeed);
-
         boid.pos += boid.vel;
     }
 }
 
+template <typename C>
+GameEngine::BoidKernel GameEngine::boidKernel(uint32_t effects) {
+    static constexpr BoidKernel kernels[BOID_KERNEL_VARIANTS] = {
+        &GameEngine::steerBoids<C, 0>, &GameEngine::steerBoids<C, 1>,
+        &GameEngine::steerBoids<C, 2>, &GameEngine::steerBoids<C, 3>,
+        &GameEngine::steerBoids<C, 4>, &GameEngine::steerBoids<C, 5>,
+        &GameEngine::steerBoids<C, 6>, &GameEngine::steerBoids<C, 7>,
+    };
+    return kernels[effects];
+}
+
+template <typename C>
+void GameEngine::applyBoidRules() {
+    auto& boids = boids_.column<BoidHot>();
+    ArenaVector<QTEntry> nearby = arenaVector<QTEntry>(arena_, 64);
+    const uint32_t n = (uint32_t)boids.size();
+
+    for (uint32_t begin = 0; begin < n; ) {
+        uint32_t slot = boids[begin].slot;
+        uint32_t end = begin + 1;
+        while (end < n && boids[end].slot == slot) end++;
+
+        const PlayerHot& player = playerHot_[slot];
+        uint32_t effects = 0;
+        if (player.boosting && player.boostFuel > 0.0f) effects |= BOID_FX_BOOST;
+        if (player.speedBurstTicks > 0)                 effects |= BOID_FX_BURST;
+        if (player.slowTicks > 0)                       effects |= BOID_FX_SLOW;
+
+        (this->*boidKernel<C>(effects))(begin, end, nearby);
+        kernelStats_.runs[effects]++;
+        kernelStats_.boids[effects] += end - begin;
+        begin = end;
+    }
+}
+
+// Steers the current world with every run forced onto one variant, from
+// the same starting boids each round; the world is restored afterwards.
+void GameEngine::benchmarkKernels(int rounds, double nsPerBoid[BOID_KERNEL_VARIANTS]) {
+    withConfig([&](auto config) {
+        using C = decltype(config);
+        auto& boids = boids_.column<BoidHot>();
+        std::vector<BoidHot> saved = boids;
+        buildQuadTree<C>();
+        ArenaVector<QTEntry> nearby = arenaVector<QTEntry>(arena_, 64);
+        const uint32_t n = (uint32_t)boids.size();
+
+        for (uint32_t v = 0; v < (uint32_t)BOID_KERNEL_VARIANTS; ++v) {
+            BoidKernel kernel = boidKernel<C>(v);
+            uint64_t nanos = 0;
+            for (int r = 0; r < rounds; ++r) {
+                std::copy(saved.begin(), saved.end(), boids.begin());
+                auto t0 = std::chrono::steady_clock::now();
+                for (uint32_t begin = 0; begin < n; ) {
+                    uint32_t end = begin + 1;
+                    while (end < n && boids[end].slot == boids[begin].slot) end++;
+                    (this->*kernel)(begin, end, nearby);
+                    begin = end;
+                }
+                nanos += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+            }
+            nsPerBoid[v] = n && rounds > 0 ? (double)nanos / ((double)n * rounds) : 0.0;
+        }
+
+        std::copy(saved.begin(), saved.end(), boids.begin());   // keeps the column's reservation
+        buildQuadTree<C>();
+    });
+    arena_.reset();
+}
+
+template <typename C>
 void GameEngine::collectResources() {
-    for (auto& res : resources_) {
-        if (!res.active) continue;
+    auto& boids = boids_.column<BoidHot>();
+    ArenaVector<QTEntry> nearby = arenaVector<QTEntry>(arena_, 64);
 
+    resources_.forEach([&](uint32_t row, const Vec2& pos, const ResourceYield& res) {
         // Query nearby boids
-        float maxRange = BOID_BASE_COLLECT_RANGE * 3.0f; // max possible
+        float maxRange = C::BOID_BASE_COLLECT_RANGE * 3.0f; // max possible
         Rect queryRect = {
-            res.pos.x - maxRange, res.pos.y - maxRange,
+            pos.x - maxRange, pos.y - maxRange,
             maxRange * 2.0f, maxRange * 2.0f
         };
 
-        std::vector<QTEntry> nearby;
+        nearby.clear();
         quadTree_->query(queryRect, nearby);
 
         for (auto& ne : nearby) {
-            const Boid& b = boids_[ne.boidIndex];
-            auto pit = players_.find(b.playerId);
-            if (pit == players_.end()) continue;
+            const BoidHot& b = boids[ne.boidIndex];
+            PlayerHot& player = playerHot_[b.slot];
 
-            float collectRange = BOID_BASE_COLLECT_RANGE * pit->second.mutations.collectRange;
-            Vec2 diff = b.pos - res.pos;
+            float collectRange = C::BOID_BASE_COLLECT_RANGE * player.mutations.collectRange;
+            Vec2 diff = b.pos - pos;
             if (diff.lengthSq() < collectRange * collectRange) {
                 // Consume resource
-                res.active = false;
-                Player& player = pit->second;
-                player.score += res.value;
+                resources_.destroy(row);
+                PlayerCold& cold = playerCold_[b.slot];
+                cold.score += res.value;
+                markPlayer(b.slot, PLAYER_SCORE | PLAYER_MUTATIONS);
 
                 // Apply mutation based on type
                 float boost = 0.02f * res.value;
@@ -323,294 +719,563 @@ void GameEngine::collectResources() {
                 }
 
                 // Possibly spawn a new boid
+                uint32_t slot = b.slot;
                 int boidCount = 0;
-                for (auto& bb : boids_) {
-                    if (bb.playerId == player.id) boidCount++;
+                for (auto& bb : boids) {
+                    if (bb.slot == slot) boidCount++;
                 }
-                if (boidCount < MAX_BOIDS_PER_PLAYER && player.score % 3 == 0) {
-                    Boid nb;
-                    nb.id = nextBoidId_++;
-                    nb.playerId = player.id;
-                    nb.pos = b.pos;
-                    nb.vel = {0, 0};
-                    boids_.push_back(nb);
+                if (boidCount < C::MAX_BOIDS_PER_PLAYER && cold.score % 3 == 0) {
+                    // Copy first: spawnBoid may reallocate the column under b
+                    Vec2 origin = b.pos;
+                    spawnBoid(slot, origin, {0, 0});
                 }
 
                 break; // Resource consumed, stop checking boids
             }
         }
-    }
+    });
 
-    // Remove inactive resources
-    resources_.erase(
-        std::remove_if(resources_.begin(), resources_.end(),
-            [](const Resource& r) { return !r.active; }),
-        resources_.end()
-    );
+    // Remove consumed resources
+    resources_.sweep();
 }
 
+template <typename C>
 void GameEngine::handleCombat() {
     // For each boid, check if an enemy boid is within COMBAT_ABSORB_RADIUS
-    // The player with more boids wins the encounter
-    std::vector<uint32_t> toRemove;
-
-    // Count boids per player
-    std::unordered_map<uint32_t, int> boidCounts;
-    for (auto& b : boids_) {
-        boidCounts[b.playerId]++;
+    // The player with more boids wins the encounter. Losers are destroyed
+    // in place (still visible to the rest of the pass) and swept at the end.
+    auto& boids = boids_.column<BoidHot>();
+    ArenaVector<QTEntry> nearby = arenaVector<QTEntry>(arena_, 64);
+
+    // Count boids per player slot
+    ArenaVector<int> boidCounts = arenaVector<int>(arena_);
+    boidCounts.assign(playerOrder_.size(), 0);
+    for (auto& b : boids) {
+        boidCounts[b.slot]++;
     }
 
-    float combatRadiusSq = COMBAT_ABSORB_RADIUS * COMBAT_ABSORB_RADIUS;
+    float combatRadiusSq = C::COMBAT_ABSORB_RADIUS * C::COMBAT_ABSORB_RADIUS;
 
-    for (uint32_t i = 0; i < (uint32_t)boids_.size(); ++i) {
+    for (uint32_t i = 0; i < (uint32_t)boids.size(); ++i) {
         Rect queryRect = {
-            boids_[i].pos.x - COMBAT_ABSORB_RADIUS,
-            boids_[i].pos.y - COMBAT_ABSORB_RADIUS,
-            COMBAT_ABSORB_RADIUS * 2.0f,
-            COMBAT_ABSORB_RADIUS * 2.0f
+            boids[i].pos.x - C::COMBAT_ABSORB_RADIUS,
+            boids[i].pos.y - C::COMBAT_ABSORB_RADIUS,
+            C::COMBAT_ABSORB_RADIUS * 2.0f,
+            C::COMBAT_ABSORB_RADIUS * 2.0f
         };
 
-        std::vector<QTEntry> nearby;
+        nearby.clear();
         quadTree_->query(queryRect, nearby);
 
         for (auto& ne : nearby) {
             if (ne.boidIndex == i) continue;
-            const Boid& other = boids_[ne.boidIndex];
-            if (other.playerId == boids_[i].playerId) continue;
+            const BoidHot& other = boids[ne.boidIndex];
+            uint32_t mySlot = boids[i].slot;
+            if (other.slot == mySlot) continue;
 
-            Vec2 diff = boids_[i].pos - other.pos;
+            Vec2 diff = boids[i].pos - other.pos;
             if (diff.lengthSq() < combatRadiusSq) {
                 // The smaller swarm loses this boid
-                int myCount    = boidCounts[boids_[i].playerId];
-                int otherCount = boidCounts[other.playerId];
+                int myCount    = boidCounts[mySlot];
+                int otherCount = boidCounts[other.slot];
 
                 // Shield protection
-                auto myPlayer = players_.find(boids_[i].playerId);
-                auto otherPlayer = players_.find(other.playerId);
-                bool myShield = (myPlayer != players_.end() && myPlayer->second.shieldTicks > 0);
-                bool otherShield = (otherPlayer != players_.end() && otherPlayer->second.shieldTicks > 0);
+                bool myShield    = playerHot_[mySlot].shieldTicks > 0;
+                bool otherShield = playerHot_[other.slot].shieldTicks > 0;
 
                 if (myCount < otherCount && !myShield) {
-                    toRemove.push_back(i);
-                    boidCounts[boids_[i].playerId]--;
+                    boids_.destroy(i);
+                    boidCounts[mySlot]--;
                     break;
                 } else if (otherCount < myCount && !otherShield) {
-                    toRemove.push_back(ne.boidIndex);
-                    boidCounts[other.playerId]--;
+                    boids_.destroy(ne.boidIndex);
+                    boidCounts[other.slot]--;
                 }
                 // If equal, no one dies
             }
         }
     }
 
-    // Sort and remove duplicates
-    std::sort(toRemove.begin(), toRemove.end());
-    toRemove.erase(std::unique(toRemove.begin(), toRemove.end()), toRemove.end());
-
-    // Remove from back to front
-    for (int i = (int)toRemove.size() - 1; i >= 0; --i) {
-        uint32_t idx = toRemove[i];
-        if (idx < boids_.size()) {
-            boids_.erase(boids_.begin() + idx);
-        }
-    }
+    boids_.sweep();
 }
 
+template <typename C>
 void GameEngine::clampPositions() {
-    for (auto& b : boids_) {
-        if (b.pos.x < 0)          { b.pos.x = 0;          b.vel.x *= -0.5f; }
-        if (b.pos.x > MAP_WIDTH)  { b.pos.x = MAP_WIDTH;  b.vel.x *= -0.5f; }
-        if (b.pos.y < 0)          { b.pos.y = 0;          b.vel.y *= -0.5f; }
-        if (b.pos.y > MAP_HEIGHT) { b.pos.y = MAP_HEIGHT;  b.vel.y *= -0.5f; }
+    auto& boids = boids_.column<BoidHot>();
+    for (auto& b : boids) {
+        if (b.pos.x < 0)             { b.pos.x = 0;             b.vel.x *= -0.5f; }
+        if (b.pos.x > C::MAP_WIDTH)  { b.pos.x = C::MAP_WIDTH;  b.vel.x *= -0.5f; }
+        if (b.pos.y < 0)             { b.pos.y = 0;             b.vel.y *= -0.5f; }
+        if (b.pos.y > C::MAP_HEIGHT) { b.pos.y = C::MAP_HEIGHT; b.vel.y *= -0.5f; }
     }
 }
 
+template <typename C>
 void GameEngine::spawnPickups() {
-    int activeCount = 0;
-    for (auto& p : pickups_) {
-        if (p.active) activeCount++;
-    }
-    if (activeCount >= MAX_PICKUPS) return;
+    if (pickups_.live() >= (size_t)C::MAX_PICKUPS) return;
 
     pickupSpawnAccum_ += 1.0f;
-    if (pickupSpawnAccum_ < PICKUP_SPAWN_INTERVAL) return;
+    if (pickupSpawnAccum_ < C::PICKUP_SPAWN_INTERVAL) return;
     pickupSpawnAccum_ = 0.0f;
 
-    std::uniform_int_distribution<int> typeDist(0, 7);
-    Pickup p;
-    p.id = nextPickupId_++;
-    p.pos = randomPosition();
-    p.type = (uint8_t)typeDist(rng_);
-    p.active = true;
-    pickups_.push_back(p);
+    uint32_t id = nextPickupId_++;
+    Vec2 pos = randomPosition<C>(rngPickup_);
+    PickupKind kind;
+    kind.type = (uint8_t)rngPickup_.range(0, 7);
+    pickups_.create(id, pos, kind);
 }
 
+template <typename C>
 void GameEngine::collectPickups() {
-    float radiusSq = PICKUP_COLLECT_RADIUS * PICKUP_COLLECT_RADIUS;
+    auto& boids = boids_.column<BoidHot>();
+    float radiusSq = C::PICKUP_COLLECT_RADIUS * C::PICKUP_COLLECT_RADIUS;
 
-    for (auto& pickup : pickups_) {
-        if (!pickup.active) continue;
+    // Boids killed by mines are destroyed in place and swept after the
+    // loop, so the spatial index (built from the current rows) stays valid
+    ArenaVector<QTEntry> nearby = arenaVector<QTEntry>(arena_, 64);
+    int minedCount = 0;
 
+    pickups_.forEach([&](uint32_t row, const Vec2& pos, const PickupKind& pickup) {
         // Query nearby boids
         Rect queryRect = {
-            pickup.pos.x - PICKUP_COLLECT_RADIUS, pickup.pos.y - PICKUP_COLLECT_RADIUS,
-            PICKUP_COLLECT_RADIUS * 2.0f, PICKUP_COLLECT_RADIUS * 2.0f
+            pos.x - C::PICKUP_COLLECT_RADIUS, pos.y - C::PICKUP_COLLECT_RADIUS,
+            C::PICKUP_COLLECT_RADIUS * 2.0f, C::PICKUP_COLLECT_RADIUS * 2.0f
         };
 
-        std::vector<QTEntry> nearby;
+        nearby.clear();
         quadTree_->query(queryRect, nearby);
 
         for (auto& ne : nearby) {
-            const Boid& b = boids_[ne.boidIndex];
-            Vec2 diff = b.pos - pickup.pos;
+            if (!boids_.alive(ne.boidIndex)) continue;
+            const BoidHot& b = boids[ne.boidIndex];
+            Vec2 diff = b.pos - pos;
             if (diff.lengthSq() >= radiusSq) continue;
 
-            auto pit = players_.find(b.playerId);
-            if (pit == players_.end()) continue;
-            Player& player = pit->second;
+            uint32_t slot = b.slot;
+            PlayerHot& player = playerHot_[slot];
 
-            pickup.active = false;
+            pickups_.destroy(row);
 
             switch (pickup.type) {
                 case 0: // BOOST_REFILL
                     player.boostFuel = 1.0f;
+                    markPlayer(slot, PLAYER_BOOST);
                     break;
                 case 1: { // MASS_SPAWN — gain 5 boids
                     int boidCount = 0;
-                    for (auto& bb : boids_) {
-                        if (bb.playerId == player.id) boidCount++;
+                    for (auto& bb : boids) {
+                        if (bb.slot == slot) boidCount++;
                     }
-                    int toSpawn = std::min(5, MAX_BOIDS_PER_PLAYER - boidCount);
+                    int toSpawn = std::min(5, C::MAX_BOIDS_PER_PLAYER - boidCount);
                     if (toSpawn > 0) {
-                        std::uniform_real_distribution<float> spread(-20.0f, 20.0f);
+                        // Copy first: spawnBoid below may reallocate the column under b
+                        Vec2 origin = b.pos;
                         for (int i = 0; i < toSpawn; ++i) {
-                            Boid nb;
-                            nb.id = nextBoidId_++;
-                            nb.playerId = player.id;
-                            nb.pos = {b.pos.x + spread(rng_), b.pos.y + spread(rng_)};
-                            nb.vel = {0, 0};
-                            boids_.push_back(nb);
+                            float sx = rngEffect_.uniform(-20.0f, 20.0f);
+                            float sy = rngEffect_.uniform(-20.0f, 20.0f);
+                            spawnBoid(slot, {origin.x + sx, origin.y + sy}, {0, 0});
                         }
                     }
                     break;
                 }
                 case 2: // SHIELD
-                    player.shieldTicks = SHIELD_DURATION;
+                    player.shieldTicks = C::SHIELD_DURATION;
+                    markPlayer(slot, PLAYER_EFFECTS);
                     break;
                 case 3: // SPEED_BURST
-                    player.speedBurstTicks = SPEED_BURST_DURATION;
+                    player.speedBurstTicks = C::SPEED_BURST_DURATION;
+                    markPlayer(slot, PLAYER_EFFECTS);
                     break;
                 case 4: // SLOW_TRAP
-                    player.slowTicks = SLOW_DURATION;
+                    player.slowTicks = C::SLOW_DURATION;
+                    markPlayer(slot, PLAYER_EFFECTS);
                     break;
                 case 5: { // SCATTER_BOMB — explode boids outward
-                    for (auto& bb : boids_) {
-                        if (bb.playerId != player.id) continue;
-                        Vec2 dir = bb.pos - pickup.pos;
+                    for (uint32_t bi = 0; bi < (uint32_t)boids.size(); ++bi) {
+                        BoidHot& bb = boids[bi];
+                        if (bb.slot != slot) continue;
+                        Vec2 dir = bb.pos - pos;
                         float d = dir.length();
                         if (d < 0.01f) dir = {1, 0};
                         else dir = dir.normalized();
-                        bb.vel = dir * SCATTER_FORCE;
+                        bb.vel = dir * C::SCATTER_FORCE;
+                        boids_.touch(bi);
                     }
                     break;
                 }
                 case 6: // DRAIN_TRAP — empty boost fuel
                     player.boostFuel = 0.0f;
                     player.boosting = false;
+                    markPlayer(slot, PLAYER_BOOST);
                     break;
                 case 7: { // MINE — kills some boids
                     int killed = 0;
-                    for (int bi = (int)boids_.size() - 1; bi >= 0 && killed < MINE_KILL_COUNT; --bi) {
-                        if (boids_[bi].playerId == player.id) {
-                            boids_.erase(boids_.begin() + bi);
+                    for (int bi = (int)boids.size() - 1; bi >= 0 && killed < C::MINE_KILL_COUNT; --bi) {
+                        if (boids[bi].slot == slot && boids_.alive(bi)) {
+                            boids_.destroy(bi);
                             killed++;
                         }
                     }
+                    minedCount += killed;
                     break;
                 }
             }
             break; // Pickup consumed
         }
-    }
+    });
 
-    // Remove inactive pickups
-    pickups_.erase(
-        std::remove_if(pickups_.begin(), pickups_.end(),
-            [](const Pickup& p) { return !p.active; }),
-        pickups_.end()
-    );
+    // Remove consumed pickups
+    pickups_.sweep();
+
+    // Remove mined boids (order-preserving) and re-index them for combat
+    if (minedCount > 0) {
+        boids_.sweep();
+        buildQuadTree<C>();
+    }
 }
 
 void GameEngine::tickPlayerEffects() {
-    for (auto& [pid, player] : players_) {
+    for (uint32_t slot = 0; slot < (uint32_t)playerHot_.size(); ++slot) {
+        PlayerHot& player = playerHot_[slot];
+        if ((player.shieldTicks | player.speedBurstTicks | player.slowTicks) == 0) continue;
         if (player.shieldTicks > 0) player.shieldTicks--;
         if (player.speedBurstTicks > 0) player.speedBurstTicks--;
         if (player.slowTicks > 0) player.slowTicks--;
+        markPlayer(slot, PLAYER_EFFECTS);
     }
 }
 
-void GameEngine::tick() {
-    // 0. Update boost fuel for all players
-    for (auto& [pid, player] : players_) {
+// Steps 0b-11 of tick()
+template <typename C>
+void GameEngine::simulate() {
+    // 0b. Update boost fuel for all players
+    for (uint32_t slot = 0; slot < (uint32_t)playerHot_.size(); ++slot) {
+        PlayerHot& player = playerHot_[slot];
+        float fuel = player.boostFuel;
+        bool boosting = player.boosting;
         if (player.boosting && player.boostFuel > 0.0f) {
-            player.boostFuel -= BOOST_DRAIN_RATE;
+            player.boostFuel -= C::BOOST_DRAIN_RATE;
             if (player.boostFuel <= 0.0f) {
                 player.boostFuel = 0.0f;
                 player.boosting = false;
             }
         } else if (!player.boosting && player.boostFuel < 1.0f) {
-            player.boostFuel += BOOST_RECHARGE_RATE;
+            player.boostFuel += C::BOOST_RECHARGE_RATE;
             if (player.boostFuel > 1.0f) player.boostFuel = 1.0f;
         }
         // Can't boost below minimum
-        if (player.boosting && player.boostFuel < BOOST_MIN_FUEL) {
+        if (player.boosting && player.boostFuel < C::BOOST_MIN_FUEL) {
             player.boosting = false;
         }
+        if (player.boostFuel != fuel || player.boosting != boosting) markPlayer(slot, PLAYER_BOOST);
     }
 
     // 1. Tick player effects (decrement timers)
     tickPlayerEffects();
 
     // 2. Spawn resources
-    resourceSpawnAccum_ += RESOURCE_SPAWN_RATE;
+    resourceSpawnAccum_ += C::RESOURCE_SPAWN_RATE;
     while (resourceSpawnAccum_ >= 1.0f) {
-        spawnResources();
+        spawnResources<C>();
         resourceSpawnAccum_ -= 1.0f;
     }
 
     // 3. Spawn pickups
-    spawnPickups();
+    spawnPickups<C>();
 
     // 4. Build spatial index
-    buildQuadTree();
+    buildQuadTree<C>();
 
     // 5. Apply boid rules + steering
-    applyBoidRules();
+    applyBoidRules<C>();
 
     // 6. Clamp to map bounds
-    clampPositions();
+    clampPositions<C>();
 
-    // 7. Rebuild quadtree after movement
-    buildQuadTree();
+    // 7. Rebuild quadtree after movement (also refreshes the minimap grid)
+    buildQuadTree<C>(true);
 
     // 8. Collect resources
-    collectResources();
+    collectResources<C>();
 
     // 9. Collect pickups
-    collectPickups();
+    collectPickups<C>();
 
     // 10. Handle combat
-    handleCombat();
+    handleCombat<C>();
 
     // 11. Check for dead players (0 boids)
-    for (auto& [pid, player] : players_) {
-        int count = 0;
-        for (auto& b : boids_) {
-            if (b.playerId == pid) count++;
+    {
+        ArenaVector<int> counts = arenaVector<int>(arena_);
+        counts.assign(playerOrder_.size(), 0);
+        for (auto& b : boids_.column<BoidHot>()) counts[b.slot]++;
+        for (size_t slot = 0; slot < counts.size(); ++slot) {
+            if (counts[slot] == 0 && playerCold_[slot].alive) {
+                playerCold_[slot].alive = false;
+                markPlayer((uint32_t)slot, PLAYER_ALIVE);
+            }
+        }
+    }
+}
+
+void GameEngine::tick() {
+    uint64_t allocsBefore = threadHeapAllocations();
+
+    // 0. Apply inputs queued by network threads
+    applyQueuedInputs();
+
+    // 0b-11. Simulate, with the room's mode constants compiled in
+    withConfig([this](auto config) { simulate<decltype(config)>(); });
+
+    // 12. Summarize swarms for impostor encoding
+    computeSwarmSummaries();
+
+    tick_++;
+    syncChangeEpoch();
+
+    // 13. Refresh the late-join keyframe
+    if (tick_ % KEYFRAME_INTERVAL == 0) refreshKeyframe();
+
+    // 14. Feed the spectator delay line
+    if (spectatorEnabled_ && tick_ % SPECTATOR_INTERVAL == 0) pushSpectatorFrame();
+
+    // 15. Hash the world for divergence checks (recorded for replays)
+    if (checksumInterval_ > 0 && tick_ % checksumInterval_ == 0) {
+        lastChecksum_ = checksum();
+        if (recorder_) recorder_->checksum(lastChecksum_);
+    }
+
+    // 16. Hand this tick's records (and periodic keyframe) to the log writer
+    if (recorder_) {
+        if (tick_ % ARCHIVE_KEYFRAME_INTERVAL == 0) recorder_->keyframe(tick_, saveState(false));
+        recorder_->commit();
+    }
+
+    // 17. Drop removals past the change history, this tick's temporaries,
+    // and account for heap traffic
+    if (tick_ > CHANGE_HISTORY_TICKS) {
+        uint32_t upTo = tick_ - CHANGE_HISTORY_TICKS;
+        removedPlayers_.trim(upTo);
+        boids_.trimRemovals(upTo);
+        resources_.trimRemovals(upTo);
+        pickups_.trimRemovals(upTo);
+    }
+    arena_.reset();
+    if (capacity_.maxPlayers) checkReservations();
+    uint64_t allocs = threadHeapAllocations() - allocsBefore;
+    allocStats_.lastTick = allocs;
+    allocStats_.total += allocs;
+    if (allocs > 0) {
+        allocStats_.allocatingTicks++;
+        allocStats_.quietStreak = 0;
+    } else {
+        allocStats_.quietStreak++;
+    }
+}
+
+// ============================================================
+// Change Tracking
+// ============================================================
+
+void GameEngine::markPlayer(uint32_t slot, uint32_t components) {
+    PlayerChanges& changes = playerChanges_[slot];
+    uint32_t epoch = changeEpoch();
+    for (int c = 0; c < PLAYER_COMPONENT_COUNT; ++c) {
+        if (components & (1u << c)) changes.epoch[c] = epoch;
+    }
+    playerRowStale_[slot] = 1;
+}
+
+void GameEngine::syncChangeEpoch() {
+    boids_.setEpoch(changeEpoch());
+    resources_.setEpoch(changeEpoch());
+    pickups_.setEpoch(changeEpoch());
+}
+
+// A constructed or loaded world has no history: every row counts as changed
+// in the coming tick, and nothing before it is known
+void GameEngine::resetChangeTracking() {
+    changeHistoryFloor_ = tick_;
+    syncChangeEpoch();
+    playerChanges_.assign(playerOrder_.size(), PlayerChanges{});
+    playerRowStale_.assign(playerOrder_.size(), 1);
+    for (uint32_t slot = 0; slot < (uint32_t)playerOrder_.size(); ++slot) {
+        markPlayer(slot, PLAYER_ALL_COMPONENTS);
+    }
+    removedPlayers_.clear();
+    for (uint32_t row = 0; row < (uint32_t)boids_.rows(); ++row) boids_.touch(row);
+    for (uint32_t row = 0; row < (uint32_t)resources_.rows(); ++row) resources_.touch(row);
+    for (uint32_t row = 0; row < (uint32_t)pickups_.rows(); ++row) pickups_.touch(row);
+    boids_.trimRemovals(changeEpoch());
+    resources_.trimRemovals(changeEpoch());
+    pickups_.trimRemovals(changeEpoch());
+}
+
+uint32_t GameEngine::changeHistoryStart() const {
+    uint32_t kept = tick_ > CHANGE_HISTORY_TICKS ? tick_ - CHANGE_HISTORY_TICKS : 0;
+    return std::max(changeHistoryFloor_, kept);
+}
+
+// ============================================================
+// Room Capacity
+// ============================================================
+// Everything a full room touches per tick is sized once here: entity
+// containers, swarm summaries, input queues, snapshot buffers (worst case:
+// every swarm in full detail), the tick arena and the whole quadtree pool.
+// Idempotent; loadState calls it again after swapping in the checkpoint's
+// containers.
+
+void GameEngine::reserveRoom() {
+    if (!capacity_.maxPlayers) return;
+    const GameModeInfo& info = modeInfo();
+    size_t players = capacity_.maxPlayers;
+    size_t boids   = players * info.maxBoidsPerPlayer;
+
+    playerOrder_.reserve(players);
+    playerHot_.reserve(players);
+    playerCold_.reserve(players);
+    playerChanges_.reserve(players);
+    playerRowStale_.reserve(players);
+    playerBlock_.reserve(players * PLAYER_ROW_BYTES);
+    swarms_.reserve(players);
+    boids_.reserve(boids);
+    swarmBoidOrder_.reserve(boids);
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        inputQueue_.reserve(players * 4);
+    }
+    inputScratch_.reserve(players * 4);
+
+    size_t snapshot = 18 + players * (43 + 6) + boids * 11 + info.maxResources * 10
+                    + info.maxPickups * 10;
+    encodeScratch_.reserve(snapshot);
+    keyframe_.reserve(4 + lzCompressBound(snapshot));
+    viewerDetail_.reserve(players);
+    viewerScratch_.reserve(snapshot);
+    viewerPayload_.reserve(4 + lzCompressBound(snapshot));
+
+    arena_.reserve(boids * 5 + players * 64 + TICK_ARENA_INITIAL_BYTES);
+
+    // Full tree: sum of 4^level for level 0..the mode's quadtree depth
+    size_t nodes = 0;
+    for (int level = 0, n = 1; level <= info.quadTreeMaxLevels; ++level, n *= 4) nodes += n;
+    quadTree_->reserve(nodes);
+
+    capacityStats_.reservedBytes =
+        players * (sizeof(PlayerHot) + sizeof(PlayerCold) + sizeof(uint32_t) + sizeof(SwarmSummary)
+                   + 8 * sizeof(InputCommand))
+        + boids * (sizeof(BoidHot) + 2 * sizeof(uint32_t) + 1)
+        + encodeScratch_.capacity() + keyframe_.capacity() + arena_.capacity()
+        + viewerScratch_.capacity() + viewerPayload_.capacity() + viewerDetail_.capacity()
+        + quadTree_->nodeCapacity() * info.quadTreeMaxObjects * sizeof(QTEntry);
+
+    capacityStats_.hugePageBytes = 0;
+    if (capacity_.hugePages) {
+        capacityStats_.hugePageBytes =
+            adviseHugePages(boids_.column<BoidHot>().data(), boids_.capacity() * sizeof(BoidHot))
+            + adviseHugePages(boids_.ids().data(), boids_.capacity() * sizeof(uint32_t))
+            + adviseHugePages(swarmBoidOrder_.data(), swarmBoidOrder_.capacity() * sizeof(uint32_t))
+            + adviseHugePages(arena_.data(), arena_.capacity())
+            + adviseHugePages(encodeScratch_.data(), encodeScratch_.capacity())
+            + adviseHugePages(keyframe_.data(), keyframe_.capacity());
+    }
+
+    reservedBoids_    = boids_.capacity();
+    reservedSnapshot_ = keyframe_.capacity();
+    reservedArena_    = arena_.capacity();
+    reservedNodes_    = quadTree_->nodeCapacity();
+}
+
+// A capped room should never outgrow its reservation; count it when it does
+void GameEngine::checkReservations() {
+    bool grew = false;
+    if (boids_.capacity() != reservedBoids_)       { reservedBoids_ = boids_.capacity(); grew = true; }
+    if (keyframe_.capacity() != reservedSnapshot_) { reservedSnapshot_ = keyframe_.capacity(); grew = true; }
+    if (arena_.capacity() != reservedArena_)       { reservedArena_ = arena_.capacity(); grew = true; }
+    if (quadTree_->nodeCapacity() != reservedNodes_) { reservedNodes_ = quadTree_->nodeCapacity(); grew = true; }
+    if (grew) capacityStats_.regrowths++;
+}
+
+void GameEngine::setSpectatorEnabled(bool enabled) {
+    if (!enabled) spectator_.clear();
+    spectatorEnabled_ = enabled;
+}
+
+// Swarm i belongs to player slot i
+void GameEngine::computeSwarmSummaries() {
+    auto& boids = boids_.column<BoidHot>();
+    swarms_.clear();
+    swarms_.reserve(playerOrder_.size());
+    for (uint32_t pid : sortedPlayerIds()) {
+        SwarmSummary s;
+        s.playerId = pid;
+        swarms_.push_back(s);
+    }
+
+    // Pass 1: counts, centroid, mean velocity, bounds
+    for (uint32_t i = 0; i < (uint32_t)boids.size(); ++i) {
+        const BoidHot& b = boids[i];
+        SwarmSummary& s = swarms_[b.slot];
+        if (s.count == 0) {
+            s.minPos = b.pos;
+            s.maxPos = b.pos;
+        } else {
+            s.minPos = {std::min(s.minPos.x, b.pos.x), std::min(s.minPos.y, b.pos.y)};
+            s.maxPos = {std::max(s.maxPos.x, b.pos.x), std::max(s.maxPos.y, b.pos.y)};
         }
-        if (count == 0 && player.alive) {
-            player.alive = false;
+        s.count++;
+        s.centroid += b.pos;
+        s.meanVel  += b.vel;
+    }
+
+    uint32_t offset = 0;
+    for (auto& s : swarms_) {
+        s.firstBoid = offset;
+        offset += (uint32_t)s.count;
+        if (s.count > 0) {
+            float inv = 1.0f / (float)s.count;
+            s.centroid = s.centroid * inv;
+            s.meanVel  = s.meanVel * inv;
+        }
+    }
+
+    // Pass 2: covariance, quadrant clusters, and grouping by swarm
+    swarmBoidOrder_.resize(offset);
+    ArenaVector<uint32_t> fill = arenaVector<uint32_t>(arena_);
+    fill.assign(swarms_.size(), 0);
+    for (uint32_t i = 0; i < (uint32_t)boids.size(); ++i) {
+        uint32_t slot = boids[i].slot;
+        SwarmSummary& s = swarms_[slot];
+        Vec2 d = boids[i].pos - s.centroid;
+        s.covXX += d.x * d.x;
+        s.covXY += d.x * d.y;
+        s.covYY += d.y * d.y;
+
+        int q = (d.x >= 0.0f ? 1 : 0) + (d.y >= 0.0f ? 2 : 0);
+        s.clusters[q] += boids[i].pos;
+        s.clusterCounts[q]++;
+
+        swarmBoidOrder_[s.firstBoid + fill[slot]++] = i;
+    }
+
+    for (auto& s : swarms_) {
+        if (s.count == 0) continue;
+        float inv = 1.0f / (float)s.count;
+        s.covXX *= inv;
+        s.covXY *= inv;
+        s.covYY *= inv;
+
+        // Compact non-empty quadrants to the front (n <= q, safe in place)
+        int n = 0;
+        for (int q = 0; q < SWARM_SUMMARY_CLUSTERS; ++q) {
+            int c = s.clusterCounts[q];
+            if (c == 0) continue;
+            s.clusters[n] = s.clusters[q] * (1.0f / (float)c);
+            s.clusterCounts[n] = c;
+            n++;
         }
+        for (int q = n; q < SWARM_SUMMARY_CLUSTERS; ++q) s.clusterCounts[q] = 0;
+        s.numClusters = n;
     }
 }
 
@@ -622,9 +1287,11 @@ void GameEngine::tick() {
 //     [uint16] mapWidth
 //     [uint16] mapHeight
 //     [uint16] numPlayers
-//     [uint16] numBoids
+//     [uint16] numSwarms (swarms sent with per-boid data)
 //     [uint16] numResources
 //     [uint16] numPickups
+//     [uint16] numImpostors
+//     [uint32] tick (monotonic, completed simulation steps)
 //   Per Player (numPlayers times):
 //     [uint32] playerId
 //     [uint16] score
@@ -638,45 +1305,206 @@ void GameEngine::tick() {
 //     [uint8]  shieldTicks
 //     [uint8]  speedBurstTicks
 //     [uint8]  slowTicks
-//   Per Boid (numBoids times):
+//     [uint16] last applied input sequence (ack)
+//     [uint32] client timestamp of that input (echo, for latency)
+//   Per Swarm (numSwarms times):
 //     [uint32] playerId
-//     [uint16] x  (integer position)
-//     [uint16] y
-//     [int8]   vx (velocity * 10, clamped to [-127,127])
-//     [int8]   vy
+//     [uint16] count
+//     Per Boid (count times):
+//       [varint] id delta (zigzag, from the previous boid id in this swarm)
+//       [uint16] x  (integer position)
+//       [uint16] y
+//       [int8]   vx (velocity * 10, clamped to [-127,127])
+//       [int8]   vy
 //   Per Resource (numResources times):
+//     [varint] id delta (zigzag, from the previous resource id)
 //     [uint16] x
 //     [uint16] y
 //     [uint8]  type
 //   Per Pickup (numPickups times):
+//     [varint] id delta (zigzag, from the previous pickup id)
 //     [uint16] x
 //     [uint16] y
 //     [uint8]  type
-
+//
+//   Varints are LEB128 (7 bits per byte, low first). Ids within each section
+//   are ascending in practice, so most deltas fit in one byte.
+//   Per Impostor (numImpostors times, swarms sent as a summary):
+//     [uint32] playerId
+//     [uint16] count
+//     [uint16] centroid x
+//     [uint16] centroid y
+//     [int8]   mean vx (* 10)
+//     [int8]   mean vy (* 10)
+//     [uint16] stddev x
+//     [uint16] stddev y
+//     [int8]   correlation (* 127)
+//     [uint8]  numClusters
+//     Per Cluster (numClusters times):
+//       [uint16] x
+//       [uint16] y
+//       [uint8]  share of count (* 255)
+//
+// Input Frame (client -> server, INPUT_FRAME_SIZE = 12 bytes):
+//     [uint16] sequence number (wrapping; older frames are dropped)
+//     [uint16] cursor x (quantized: x / map width  * 65535)
+//     [uint16] cursor y (quantized: y / map height * 65535)
+//     [uint8]  flags (bit 0 = boost; other bits must be 0)
+//     [uint8]  reserved (must be 0)
+//     [uint32] client timestamp (ms, wrapping)
+//   Bulk submission (submitInputBatch) prefixes each frame with [uint32] playerId.
+//
+// serializeState() sends every swarm in full. serializeStateFor(viewer)
+// sends full boids only for swarms overlapping the viewer's area (centred
+// on the viewer's own swarm) and impostors for everything else.
+
+// The keyframe is reused while it still describes this tick's state
 std::vector<uint8_t> GameEngine::serializeState() const {
-    size_t headerSize    = 12;                   // added numPickups u16
-    size_t playerSize    = 4 + 2 + 1 + 1 + 4 + 4 * 4 + 3;  // 31 bytes per player (+3 effect bytes)
-    size_t boidSize      = 4 + 2 + 2 + 1 + 1;   // 10 bytes per boid
-    size_t resourceSize  = 2 + 2 + 1;            // 5 bytes per resource
-    size_t pickupSize    = 2 + 2 + 1;            // 5 bytes per pickup
+    if (keyframeCurrent_ && keyframeTick_ == tick_) return keyframe_;
+    return packPayload(encodeSnapshot(std::vector<uint8_t>(swarms_.size(), 1)));
+}
+
+// Both re-encode into buffers kept from the previous frame
+void GameEngine::refreshKeyframe() {
+    ArenaVector<uint8_t> all = arenaVector<uint8_t>(arena_);
+    all.assign(swarms_.size(), 1);
+    if (compression_) {
+        encodeSnapshot(all.data(), encodeScratch_);
+        compressPayload(encodeScratch_, keyframe_);
+    } else {
+        encodeSnapshot(all.data(), keyframe_);
+    }
+    keyframeTick_ = tick_;
+    keyframeCurrent_ = true;
+}
+
+void GameEngine::pushSpectatorFrame() {
+    ArenaVector<uint8_t> all = arenaVector<uint8_t>(arena_);
+    all.assign(swarms_.size(), 1);
+    encodeSnapshot(all.data(), encodeScratch_);
+    std::vector<uint8_t> frame = spectator_.recycle();
+    compressPayload(encodeScratch_, frame);
+    spectator_.push(tick_, std::move(frame), SPECTATOR_DELAY);
+}
+
+const std::vector<uint8_t>& GameEngine::serializeStateFor(uint32_t viewerId) const {
+    Vec2 center = {modeInfo().mapWidth * 0.5f, modeInfo().mapHeight * 0.5f};
+    int slot = slotOf(viewerId);
+    if (slot >= 0) center = playerHot_[slot].cursor;
+    for (auto& s : swarms_) {
+        if (s.playerId == viewerId && s.count > 0) {
+            center = s.centroid;
+            break;
+        }
+    }
+
+    Rect view = {
+        center.x - VIEW_HALF_WIDTH - VIEW_MARGIN,
+        center.y - VIEW_HALF_HEIGHT - VIEW_MARGIN,
+        (VIEW_HALF_WIDTH + VIEW_MARGIN) * 2.0f,
+        (VIEW_HALF_HEIGHT + VIEW_MARGIN) * 2.0f
+    };
+
+    viewerDetail_.assign(swarms_.size(), 0);
+    for (size_t i = 0; i < swarms_.size(); ++i) {
+        const SwarmSummary& s = swarms_[i];
+        if (s.playerId == viewerId || s.count == 0) {
+            viewerDetail_[i] = 1;
+            continue;
+        }
+        Rect bounds = {s.minPos.x, s.minPos.y, s.maxPos.x - s.minPos.x, s.maxPos.y - s.minPos.y};
+        viewerDetail_[i] = view.intersects(bounds) ? 1 : 0;
+    }
+
+    // Called once per viewer per broadcast: encode into retained buffers
+    if (compression_) {
+        encodeSnapshot(viewerDetail_.data(), viewerScratch_);
+        compressPayload(viewerScratch_, viewerPayload_);
+    } else {
+        encodeSnapshot(viewerDetail_.data(), viewerPayload_);
+    }
+    return viewerPayload_;
+}
+
+void GameEngine::encodePlayerRow(uint32_t slot, uint8_t* out) const {
+    const PlayerHot& player = playerHot_[slot];
+    const PlayerCold& cold = playerCold_[slot];
+    auto put = [&](const auto& v) {
+        memcpy(out, &v, sizeof(v)); out += sizeof(v);
+    };
+    put(playerOrder_[slot]);
+    put((uint16_t)std::min(cold.score, 65535));
+    put((uint8_t)(cold.alive ? 1 : 0));
+    put((uint8_t)(player.boosting ? 1 : 0));
+    put(player.boostFuel);
+    put(player.mutations.speed);
+    put(player.mutations.cohesion);
+    put(player.mutations.aggression);
+    put(player.mutations.collectRange);
+    put((uint8_t)std::min(player.shieldTicks, 255));
+    put((uint8_t)std::min(player.speedBurstTicks, 255));
+    put((uint8_t)std::min(player.slowTicks, 255));
+    put(cold.lastInputSeq);
+    put(cold.lastInputClientTime);
+}
 
-    int activeResources = 0;
-    for (auto& r : resources_) {
-        if (r.active) activeResources++;
+void GameEngine::refreshPlayerBlock() const {
+    size_t players = playerOrder_.size();
+    playerBlock_.resize(players * PLAYER_ROW_BYTES);
+    for (uint32_t slot = 0; slot < (uint32_t)players; ++slot) {
+        if (!playerRowStale_[slot]) {
+            serializerStats_.playerRowsReused++;
+            continue;
+        }
+        encodePlayerRow(slot, playerBlock_.data() + (size_t)slot * PLAYER_ROW_BYTES);
+        playerRowStale_[slot] = 0;
+        serializerStats_.playerRowsEncoded++;
     }
+}
 
-    int activePickups = 0;
-    for (auto& p : pickups_) {
-        if (p.active) activePickups++;
+std::vector<uint8_t> GameEngine::encodeSnapshot(const std::vector<uint8_t>& fullDetail) const {
+    std::vector<uint8_t> buf;
+    encodeSnapshot(fullDetail.data(), buf);
+    return buf;
+}
+
+void GameEngine::encodeSnapshot(const uint8_t* fullDetail, std::vector<uint8_t>& buf) const {
+    size_t headerSize    = 18;                   // added tick u32
+    size_t playerSize    = PLAYER_ROW_BYTES;     // 37 bytes per player (+6 input ack bytes)
+    size_t swarmSize     = 4 + 2;                // 6 bytes per swarm block
+    size_t boidSize      = 5 + 2 + 2 + 1 + 1;   // <= 11 bytes per boid (varint id delta)
+    size_t resourceSize  = 5 + 2 + 2 + 1;        // <= 10 bytes per resource
+    size_t pickupSize    = 5 + 2 + 2 + 1;        // <= 10 bytes per pickup
+    size_t impostorSize  = 4 + 2 + 2 + 2 + 1 + 1 + 2 + 2 + 1 + 1;  // 18 bytes + clusters
+    size_t clusterSize   = 2 + 2 + 1;            // 5 bytes per cluster
+
+    size_t activeResources = resources_.live();
+    size_t activePickups   = pickups_.live();
+
+    size_t numSwarms = 0;
+    size_t numBoids = 0;
+    size_t numImpostors = 0;
+    size_t numClusters = 0;
+    for (size_t i = 0; i < swarms_.size(); ++i) {
+        if (fullDetail[i]) {
+            numSwarms++;
+            numBoids += swarms_[i].count;
+        } else {
+            numImpostors++;
+            numClusters += swarms_[i].numClusters;
+        }
     }
 
     size_t totalSize = headerSize
-        + players_.size() * playerSize
-        + boids_.size() * boidSize
+        + playerOrder_.size() * playerSize
+        + numSwarms * swarmSize
+        + numBoids * boidSize
         + activeResources * resourceSize
-        + activePickups * pickupSize;
+        + activePickups * pickupSize
+        + numImpostors * impostorSize
+        + numClusters * clusterSize;
 
-    std::vector<uint8_t> buf(totalSize);
+    buf.resize(totalSize);
     uint8_t* ptr = buf.data();
 
     auto writeU16 = [&](uint16_t v) {
@@ -685,122 +1513,802 @@ std::vector<uint8_t> GameEngine::serializeState() const {
     auto writeU32 = [&](uint32_t v) {
         memcpy(ptr, &v, 4); ptr += 4;
     };
-    auto writeF32 = [&](float v) {
-        memcpy(ptr, &v, 4); ptr += 4;
-    };
     auto writeU8 = [&](uint8_t v) {
         *ptr++ = v;
     };
     auto writeI8 = [&](int8_t v) {
         *ptr++ = (uint8_t)v;
     };
+    auto writeCoord = [&](float v) {
+        writeU16((uint16_t)std::clamp(v, 0.0f, (float)UINT16_MAX));
+    };
+    auto writeVel = [&](float v) {
+        writeI8((int8_t)std::clamp((int)(v * 10.0f), -127, 127));
+    };
+    auto writeIdDelta = [&](uint32_t id, uint32_t& prev) {
+        int32_t d = (int32_t)(id - prev);
+        uint32_t v = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+        prev = id;
+        while (v >= 0x80) {
+            *ptr++ = (uint8_t)(v | 0x80);
+            v >>= 7;
+        }
+        *ptr++ = (uint8_t)v;
+    };
 
     // Header
-    writeU16((uint16_t)MAP_WIDTH);
-    writeU16((uint16_t)MAP_HEIGHT);
-    writeU16((uint16_t)players_.size());
-    writeU16((uint16_t)boids_.size());
+    writeU16((uint16_t)modeInfo().mapWidth);
+    writeU16((uint16_t)modeInfo().mapHeight);
+    writeU16((uint16_t)playerOrder_.size());
+    writeU16((uint16_t)numSwarms);
     writeU16((uint16_t)activeResources);
     writeU16((uint16_t)activePickups);
-
-    // Players
-    for (auto& [pid, player] : players_) {
-        writeU32(pid);
-        writeU16((uint16_t)std::min(player.score, 65535));
-        writeU8(player.alive ? 1 : 0);
-        writeU8(player.boosting ? 1 : 0);
-        writeF32(player.boostFuel);
-        writeF32(player.mutations.speed);
-        writeF32(player.mutations.cohesion);
-        writeF32(player.mutations.aggression);
-        writeF32(player.mutations.collectRange);
-        writeU8((uint8_t)std::min(player.shieldTicks, 255));
-        writeU8((uint8_t)std::min(player.speedBurstTicks, 255));
-        writeU8((uint8_t)std::min(player.slowTicks, 255));
-    }
-
-    // Boids
-    for (auto& b : boids_) {
-        writeU32(b.playerId);
-        writeU16((uint16_t)std::clamp(b.pos.x, 0.0f, (float)UINT16_MAX));
-        writeU16((uint16_t)std::clamp(b.pos.y, 0.0f, (float)UINT16_MAX));
-        int vx = (int)(b.vel.x * 10.0f);
-        int vy = (int)(b.vel.y * 10.0f);
-        writeI8((int8_t)std::clamp(vx, -127, 127));
-        writeI8((int8_t)std::clamp(vy, -127, 127));
+    writeU16((uint16_t)numImpostors);
+    writeU32(tick_);
+
+    // Players, in id order (slot order): the same for every viewer, so the
+    // block is kept encoded and only rows changed since the last encode redo
+    refreshPlayerBlock();
+    if (!playerBlock_.empty()) memcpy(ptr, playerBlock_.data(), playerBlock_.size());
+    ptr += playerBlock_.size();
+
+    // Boids, one block per swarm
+    const auto& boids = boids_.column<BoidHot>();
+    for (size_t si = 0; si < swarms_.size(); ++si) {
+        if (!fullDetail[si]) continue;
+        const SwarmSummary& s = swarms_[si];
+        writeU32(s.playerId);
+        writeU16((uint16_t)std::min(s.count, 65535));
+        uint32_t prevId = 0;
+        for (int k = 0; k < s.count; ++k) {
+            uint32_t idx = swarmBoidOrder_[s.firstBoid + k];
+            const BoidHot& b = boids[idx];
+            writeIdDelta(boids_.id(idx), prevId);
+            writeCoord(b.pos.x);
+            writeCoord(b.pos.y);
+            writeVel(b.vel.x);
+            writeVel(b.vel.y);
+        }
     }
 
     // Resources
-    for (auto& r : resources_) {
-        if (!r.active) continue;
-        writeU16((uint16_t)r.pos.x);
-        writeU16((uint16_t)r.pos.y);
+    uint32_t prevResourceId = 0;
+    resources_.forEach([&](uint32_t row, const Vec2& pos, const ResourceYield& r) {
+        writeIdDelta(resources_.id(row), prevResourceId);
+        writeU16((uint16_t)pos.x);
+        writeU16((uint16_t)pos.y);
         writeU8(r.type);
-    }
+    });
 
     // Pickups
-    for (auto& p : pickups_) {
-        if (!p.active) continue;
-        writeU16((uint16_t)p.pos.x);
-        writeU16((uint16_t)p.pos.y);
+    uint32_t prevPickupId = 0;
+    pickups_.forEach([&](uint32_t row, const Vec2& pos, const PickupKind& p) {
+        writeIdDelta(pickups_.id(row), prevPickupId);
+        writeU16((uint16_t)pos.x);
+        writeU16((uint16_t)pos.y);
         writeU8(p.type);
+    });
+
+    // Impostors
+    for (size_t si = 0; si < swarms_.size(); ++si) {
+        if (fullDetail[si]) continue;
+        const SwarmSummary& s = swarms_[si];
+        float sdx = std::sqrt(s.covXX);
+        float sdy = std::sqrt(s.covYY);
+        float corr = (sdx > 0.01f && sdy > 0.01f) ? s.covXY / (sdx * sdy) : 0.0f;
+
+        writeU32(s.playerId);
+        writeU16((uint16_t)std::min(s.count, 65535));
+        writeCoord(s.centroid.x);
+        writeCoord(s.centroid.y);
+        writeVel(s.meanVel.x);
+        writeVel(s.meanVel.y);
+        writeCoord(sdx);
+        writeCoord(sdy);
+        writeI8((int8_t)std::clamp((int)(corr * 127.0f), -127, 127));
+        writeU8((uint8_t)s.numClusters);
+        for (int c = 0; c < s.numClusters; ++c) {
+            writeCoord(s.clusters[c].x);
+            writeCoord(s.clusters[c].y);
+            writeU8((uint8_t)std::min(255, s.clusterCounts[c] * 255 / s.count));
+        }
     }
 
-    return buf;
+    buf.resize((size_t)(ptr - buf.data()));
 }
 
 // ============================================================
-// N-API Bindings
+// Minimap Serialization
 // ============================================================
+// Format (all little-endian):
+//   [uint8]  gridWidth
+//   [uint8]  gridHeight
+//   [uint8]  numOwners
+//   [uint32] ownerId (numOwners times, palette)
+//   [uint16] numRuns
+//   Per Run (row-major cell order):
+//     [uint8] length (1-255)
+//     [uint8] owner  (0 = empty, otherwise palette index + 1)
+//     [uint8] density (boid count clamped to MINIMAP_MAX_DENSITY)
+
+std::vector<uint8_t> GameEngine::serializeMinimap() const {
+    std::vector<uint32_t> palette;
+    std::vector<uint8_t> runs;
+    runs.reserve(256 * 3);
+
+    auto paletteIndex = [&](uint32_t owner) -> uint8_t {
+        if (owner == 0) return 0;
+        for (size_t i = 0; i < palette.size(); ++i) {
+            if (palette[i] == owner) return (uint8_t)(i + 1);
+        }
+        if (palette.size() >= 255) return 0;
+        palette.push_back(owner);
+        return (uint8_t)palette.size();
+    };
 
-static GameEngine* g_engine = nullptr;
-
-// createEngine()
-static napi_value NapiCreateEngine(napi_env env, napi_callback_info info) {
-    if (g_engine) delete g_engine;
-    g_engine = new GameEngine();
+    uint8_t runOwner = 0, runDensity = 0, runLength = 0;
+    uint16_t numRuns = 0;
+    auto flush = [&]() {
+        if (runLength == 0) return;
+        runs.push_back(runLength);
+        runs.push_back(runOwner);
+        runs.push_back(runDensity);
+        numRuns++;
+        runLength = 0;
+    };
 
-    napi_value result;
-    napi_get_boolean(env, true, &result);
-    return result;
-}
+    for (const MinimapCell& cell : minimap_) {
+        uint8_t owner   = cell.count ? paletteIndex(cell.owner) : 0;
+        uint8_t density = (uint8_t)std::min<int>(cell.count, MINIMAP_MAX_DENSITY);
+        if (runLength > 0 && (owner != runOwner || density != runDensity || runLength == 255)) {
+            flush();
+        }
+        runOwner = owner;
+        runDensity = density;
+        runLength++;
+    }
+    flush();
 
-// addPlayer() -> playerId (number)
-static napi_value NapiAddPlayer(napi_env env, napi_callback_info info) {
-    if (!g_engine) {
-        napi_value undef;
-        napi_get_undefined(env, &undef);
-        return undef;
+    std::vector<uint8_t> buf(3 + palette.size() * 4 + 2 + runs.size());
+    uint8_t* ptr = buf.data();
+    *ptr++ = (uint8_t)MINIMAP_GRID_SIZE;
+    *ptr++ = (uint8_t)MINIMAP_GRID_SIZE;
+    *ptr++ = (uint8_t)palette.size();
+    for (uint32_t id : palette) {
+        memcpy(ptr, &id, 4); ptr += 4;
     }
-    uint32_t pid = g_engine->addPlayer();
-    napi_value result;
-    napi_create_uint32(env, pid, &result);
-    return result;
+    memcpy(ptr, &numRuns, 2); ptr += 2;
+    memcpy(ptr, runs.data(), runs.size());
+
+    return packPayload(std::move(buf));
 }
 
-// removePlayer(playerId)
-static napi_value NapiRemovePlayer(napi_env env, napi_callback_info info) {
-    size_t argc = 1;
-    napi_value args[1];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+// ============================================================
+// Payload Compression
+// ============================================================
 
-    uint32_t pid;
-    napi_get_value_uint32(env, args[0], &pid);
+std::vector<uint8_t> GameEngine::packPayload(std::vector<uint8_t> raw) const {
+    return packPayload(std::move(raw), compression_);
+}
 
-    if (g_engine) g_engine->removePlayer(pid);
+std::vector<uint8_t> GameEngine::packPayload(std::vector<uint8_t> raw, bool compress) const {
+    if (!compress) return raw;
+    std::vector<uint8_t> out;
+    compressPayload(raw, out);
+    return out;
+}
 
-    napi_value undef;
-    napi_get_undefined(env, &undef);
-    return undef;
+void GameEngine::compressPayload(const std::vector<uint8_t>& raw, std::vector<uint8_t>& out) const {
+    auto t0 = std::chrono::steady_clock::now();
+
+    out.resize(4 + lzCompressBound(raw.size()));
+    uint32_t rawSize = (uint32_t)raw.size();
+    memcpy(out.data(), &rawSize, 4);
+    size_t n = lzCompress(raw.data(), raw.size(), out.data() + 4);
+    out.resize(4 + n);
+
+    auto t1 = std::chrono::steady_clock::now();
+    serializerStats_.payloads++;
+    serializerStats_.rawBytes     += raw.size();
+    serializerStats_.encodedBytes += out.size();
+    serializerStats_.encodeNanos  +=
+        (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
 }
 
-// setPlayerCursor(playerId, x, y)
-static napi_value NapiSetCursor(napi_env env, napi_callback_info info) {
-    size_t argc = 3;
-    napi_value args[3];
-    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+// ============================================================
+// World Checkpoints
+// ============================================================
+// Everything needed to continue the simulation bit-for-bit. Derived state
+// (quadtree, swarm summaries, minimap, keyframe) is rebuilt on load.
+//
+// Header (132 bytes):
+//   [uint32] magic 'SMWS'     [uint16] version    [uint16] sizeof(Boid)
+//   [uint64] seed             [uint32] game mode  [uint32] tick
+//   [uint32] nextPlayerId, nextBoidId, nextResourceId, nextPickupId
+//   [float32] resourceSpawnAccum, pickupSpawnAccum
+//   4x [uint64 key][uint64 counter]  RNG streams: spawn, resource, pickup, effect
+//   [uint32] players, boids, resources, pickups, queued inputs
+// Then, in that order:
+//   players   57 bytes each, field by field
+//   boids     Boid records, 24 bytes each (id, playerId, pos, vel; the
+//             header size guards the layout)
+//   resources 18 bytes each: id, x, y, value, type, active
+//   pickups   14 bytes each: id, x, y, type, active
+//   inputs    19 bytes each: playerId, seq, x, y, boost, clientTime
+//             (received but not yet applied by a tick)
+// Version 1 (no game mode field) still loads, as a classic world.
+
+static constexpr uint32_t STATE_MAGIC   = 0x53574D53;   // "SMWS" little-endian
+static constexpr uint16_t STATE_VERSION = 2;
+
+static_assert(std::is_trivially_copyable<Boid>::value, "Boid records are memcpy'd into checkpoints");
+static_assert(sizeof(Boid) == 24, "Boid must stay padding-free for checkpoints");
+
+struct StateWriter {
+    std::vector<uint8_t>& out;
+    template <typename T>
+    void put(const T& v) {
+        size_t at = out.size();
+        out.resize(at + sizeof(T));
+        memcpy(out.data() + at, &v, sizeof(T));
+    }
+};
+
+struct StateReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+    template <typename T>
+    T get() {
+        T v{};
+        if ((size_t)(end - p) < sizeof(T)) { ok = false; return v; }
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+    const uint8_t* take(size_t len) {
+        if ((size_t)(end - p) < len) { ok = false; return nullptr; }
+        const uint8_t* r = p;
+        p += len;
+        return r;
+    }
+};
 
-    uint32_t pid;
+std::vector<uint8_t> GameEngine::saveState(bool includeQueuedInputs) const {
+    std::vector<InputCommand> queued;
+    if (includeQueuedInputs) {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        queued = inputQueue_;
+    }
+
+    std::vector<uint8_t> buf;
+    buf.reserve(132 + playerOrder_.size() * 57 + boids_.rows() * sizeof(Boid)
+                + resources_.rows() * 18 + pickups_.rows() * 14 + queued.size() * 19);
+    StateWriter w{buf};
+
+    w.put(STATE_MAGIC);
+    w.put(STATE_VERSION);
+    w.put((uint16_t)sizeof(Boid));
+    w.put(seed_);
+    w.put((uint32_t)mode_);
+    w.put(tick_);
+    w.put(nextPlayerId_);
+    w.put(nextBoidId_);
+    w.put(nextResourceId_);
+    w.put(nextPickupId_);
+    w.put(resourceSpawnAccum_);
+    w.put(pickupSpawnAccum_);
+    for (const RngStream* r : {&rngSpawn_, &rngResource_, &rngPickup_, &rngEffect_}) {
+        w.put(r->key);
+        w.put(r->counter);
+    }
+    w.put((uint32_t)playerOrder_.size());
+    w.put((uint32_t)boids_.rows());
+    w.put((uint32_t)resources_.rows());
+    w.put((uint32_t)pickups_.rows());
+    w.put((uint32_t)queued.size());
+
+    for (uint32_t slot = 0; slot < (uint32_t)playerOrder_.size(); ++slot) {
+        const Player p = playerRecord(slot);
+        w.put(p.id);
+        w.put(p.cursor.x);
+        w.put(p.cursor.y);
+        w.put((uint8_t)p.hasInput);
+        w.put(p.lastInputSeq);
+        w.put(p.lastInputClientTime);
+        w.put(p.mutations.speed);
+        w.put(p.mutations.cohesion);
+        w.put(p.mutations.aggression);
+        w.put(p.mutations.collectRange);
+        w.put((int32_t)p.score);
+        w.put((uint8_t)p.alive);
+        w.put((uint8_t)p.boosting);
+        w.put(p.boostFuel);
+        w.put((int32_t)p.shieldTicks);
+        w.put((int32_t)p.speedBurstTicks);
+        w.put((int32_t)p.slowTicks);
+    }
+
+    const auto& boids = boids_.column<BoidHot>();
+    for (uint32_t row = 0; row < (uint32_t)boids_.rows(); ++row) {
+        Boid b;
+        b.id       = boids_.id(row);
+        b.playerId = playerOrder_[boids[row].slot];
+        b.pos      = boids[row].pos;
+        b.vel      = boids[row].vel;
+        w.put(b);
+    }
+
+    // active is the row's alive flag
+    for (uint32_t row = 0; row < (uint32_t)resources_.rows(); ++row) {
+        const Vec2& pos = resources_.get<Vec2>(row);
+        const ResourceYield& y = resources_.get<ResourceYield>(row);
+        w.put(resources_.id(row));
+        w.put(pos.x);
+        w.put(pos.y);
+        w.put(y.value);
+        w.put(y.type);
+        w.put((uint8_t)resources_.alive(row));
+    }
+    for (uint32_t row = 0; row < (uint32_t)pickups_.rows(); ++row) {
+        const Vec2& pos = pickups_.get<Vec2>(row);
+        w.put(pickups_.id(row));
+        w.put(pos.x);
+        w.put(pos.y);
+        w.put(pickups_.get<PickupKind>(row).type);
+        w.put((uint8_t)pickups_.alive(row));
+    }
+    for (const InputCommand& c : queued) {
+        w.put(c.playerId);
+        w.put(c.seq);
+        w.put(c.x);
+        w.put(c.y);
+        w.put((uint8_t)c.boost);
+        w.put(c.clientTime);
+    }
+    return buf;
+}
+
+bool GameEngine::loadState(const uint8_t* data, size_t len, std::string& error) {
+    if (recorder_) {
+        error = "cannot load a checkpoint while recording inputs";
+        return false;
+    }
+
+    StateReader r{data, data + len};
+    uint32_t magic    = r.get<uint32_t>();
+    uint16_t version  = r.get<uint16_t>();
+    uint16_t boidSize = r.get<uint16_t>();
+    if (!r.ok || magic != STATE_MAGIC || version < 1 || version > STATE_VERSION
+        || boidSize != sizeof(Boid)) {
+        error = "not a world checkpoint (or unsupported version)";
+        return false;
+    }
+
+    // Decode into locals first so a bad checkpoint leaves the engine untouched
+    uint64_t seed           = r.get<uint64_t>();
+    uint32_t mode           = version >= 2 ? r.get<uint32_t>() : (uint32_t)GameMode::Classic;
+    uint32_t tick           = r.get<uint32_t>();
+    uint32_t nextPlayerId   = r.get<uint32_t>();
+    uint32_t nextBoidId     = r.get<uint32_t>();
+    uint32_t nextResourceId = r.get<uint32_t>();
+    uint32_t nextPickupId   = r.get<uint32_t>();
+    float resourceAccum     = r.get<float>();
+    float pickupAccum       = r.get<float>();
+    RngStream rng[4];
+    for (RngStream& s : rng) {
+        s.key     = r.get<uint64_t>();
+        s.counter = r.get<uint64_t>();
+    }
+    uint32_t numPlayers   = r.get<uint32_t>();
+    uint32_t numBoids     = r.get<uint32_t>();
+    uint32_t numResources = r.get<uint32_t>();
+    uint32_t numPickups   = r.get<uint32_t>();
+    uint32_t numInputs    = r.get<uint32_t>();
+
+    size_t needed = (size_t)numPlayers * 57 + (size_t)numBoids * sizeof(Boid)
+                  + (size_t)numResources * 18 + (size_t)numPickups * 14 + (size_t)numInputs * 19;
+    if (!r.ok || (size_t)(r.end - r.p) != needed) {
+        error = "truncated or oversized world checkpoint";
+        return false;
+    }
+    if (mode >= (uint32_t)GAME_MODE_COUNT) {
+        error = "checkpoint has unknown game mode " + std::to_string(mode);
+        return false;
+    }
+    if (capacity_.maxPlayers && numPlayers > capacity_.maxPlayers) {
+        error = "checkpoint has " + std::to_string(numPlayers) + " players, room is capped at "
+              + std::to_string(capacity_.maxPlayers);
+        return false;
+    }
+
+    std::vector<Player> players(numPlayers);
+    for (Player& p : players) {
+        p.id                      = r.get<uint32_t>();
+        p.cursor.x                = r.get<float>();
+        p.cursor.y                = r.get<float>();
+        p.hasInput                = r.get<uint8_t>() != 0;
+        p.lastInputSeq            = r.get<uint16_t>();
+        p.lastInputClientTime     = r.get<uint32_t>();
+        p.mutations.speed         = r.get<float>();
+        p.mutations.cohesion      = r.get<float>();
+        p.mutations.aggression    = r.get<float>();
+        p.mutations.collectRange  = r.get<float>();
+        p.score                   = r.get<int32_t>();
+        p.alive                   = r.get<uint8_t>() != 0;
+        p.boosting                = r.get<uint8_t>() != 0;
+        p.boostFuel               = r.get<float>();
+        p.shieldTicks             = r.get<int32_t>();
+        p.speedBurstTicks         = r.get<int32_t>();
+        p.slowTicks               = r.get<int32_t>();
+    }
+    std::sort(players.begin(), players.end(),
+              [](const Player& a, const Player& b) { return a.id < b.id; });
+    std::vector<uint32_t> order(numPlayers);
+    std::vector<PlayerHot> hot(numPlayers);
+    std::vector<PlayerCold> cold(numPlayers);
+    for (uint32_t slot = 0; slot < numPlayers; ++slot) {
+        const Player& p = players[slot];
+        if (slot > 0 && p.id == order[slot - 1]) {
+            error = "duplicate player " + std::to_string(p.id) + " in checkpoint";
+            return false;
+        }
+        order[slot] = p.id;
+        hot[slot].cursor          = p.cursor;
+        hot[slot].mutations       = p.mutations;
+        hot[slot].boostFuel       = p.boostFuel;
+        hot[slot].shieldTicks     = p.shieldTicks;
+        hot[slot].speedBurstTicks = p.speedBurstTicks;
+        hot[slot].slowTicks       = p.slowTicks;
+        hot[slot].boosting        = p.boosting;
+        cold[slot].score               = p.score;
+        cold[slot].alive               = p.alive;
+        cold[slot].hasInput            = p.hasInput;
+        cold[slot].lastInputSeq        = p.lastInputSeq;
+        cold[slot].lastInputClientTime = p.lastInputClientTime;
+    }
+
+    std::vector<BoidHot> boids(numBoids);
+    std::vector<uint32_t> boidIds(numBoids);
+    for (uint32_t i = 0; i < numBoids; ++i) {
+        Boid b = r.get<Boid>();
+        auto it = std::lower_bound(order.begin(), order.end(), b.playerId);
+        if (it == order.end() || *it != b.playerId) {
+            error = "boid " + std::to_string(b.id) + " belongs to unknown player " + std::to_string(b.playerId);
+            return false;
+        }
+        boids[i] = BoidHot{b.pos, b.vel, (uint32_t)(it - order.begin())};
+        boidIds[i] = b.id;
+    }
+
+    std::vector<Resource> resources(numResources);
+    for (Resource& res : resources) {
+        res.id     = r.get<uint32_t>();
+        res.pos.x  = r.get<float>();
+        res.pos.y  = r.get<float>();
+        res.value  = r.get<int32_t>();
+        res.type   = r.get<uint8_t>();
+        res.active = r.get<uint8_t>() != 0;
+    }
+    std::vector<Pickup> pickups(numPickups);
+    for (Pickup& pk : pickups) {
+        pk.id     = r.get<uint32_t>();
+        pk.pos.x  = r.get<float>();
+        pk.pos.y  = r.get<float>();
+        pk.type   = r.get<uint8_t>();
+        pk.active = r.get<uint8_t>() != 0;
+    }
+    std::vector<InputCommand> inputs(numInputs);
+    for (InputCommand& c : inputs) {
+        c.playerId   = r.get<uint32_t>();
+        c.seq        = r.get<uint16_t>();
+        c.x          = r.get<float>();
+        c.y          = r.get<float>();
+        c.boost      = r.get<uint8_t>() != 0;
+        c.clientTime = r.get<uint32_t>();
+    }
+
+    playerOrder_ = std::move(order);
+    playerHot_   = std::move(hot);
+    playerCold_  = std::move(cold);
+    boids_.clear();
+    resources_.clear();
+    pickups_.clear();
+    boids_.reserve(numBoids);
+    for (uint32_t i = 0; i < numBoids; ++i) boids_.create(boidIds[i], boids[i]);
+    for (const Resource& res : resources) {
+        uint32_t row = resources_.create(res.id, res.pos, ResourceYield{res.value, res.type});
+        if (!res.active) resources_.destroy(row);
+    }
+    for (const Pickup& pk : pickups) {
+        uint32_t row = pickups_.create(pk.id, pk.pos, PickupKind{pk.type});
+        if (!pk.active) pickups_.destroy(row);
+    }
+    if ((GameMode)mode != mode_) {
+        mode_ = (GameMode)mode;
+        quadTree_ = std::make_unique<QuadTree>(Rect{0, 0, modeInfo().mapWidth, modeInfo().mapHeight},
+                                               modeInfo().quadTreeMaxObjects);
+    }
+    resources_.reserve(modeInfo().maxResources);
+    pickups_.reserve(modeInfo().maxPickups);
+    {
+        std::lock_guard<std::mutex> lock(inputMutex_);
+        inputQueue_ = std::move(inputs);
+        inputExtent_ = {modeInfo().mapWidth, modeInfo().mapHeight};
+    }
+    reserveRoom();
+
+    seed_           = seed;
+    tick_           = tick;
+    nextPlayerId_   = nextPlayerId;
+    nextBoidId_     = nextBoidId;
+    nextResourceId_ = nextResourceId;
+    nextPickupId_   = nextPickupId;
+    resourceSpawnAccum_ = resourceAccum;
+    pickupSpawnAccum_   = pickupAccum;
+    rngSpawn_    = rng[0];
+    rngResource_ = rng[1];
+    rngPickup_   = rng[2];
+    rngEffect_   = rng[3];
+
+    // Derived state
+    withConfig([this](auto config) { buildQuadTree<decltype(config)>(true); });
+    computeSwarmSummaries();
+    resetChangeTracking();
+    spectator_.clear();
+    refreshKeyframe();
+    return true;
+}
+
+// ============================================================
+// State Checksum
+// ============================================================
+// Same fields as saveState(), minus queued inputs (not yet applied, so not
+// part of the simulated state).
+
+uint64_t checksumWorld(uint32_t tick, const uint32_t nextIds[4],
+                       float resourceAccum, float pickupAccum, const RngStream* const rngs[4]) {
+    StateHasher h;
+    h.pair(tick, nextIds[0]);
+    h.pair(nextIds[1], nextIds[2]);
+    h.pair(nextIds[3], 0u);
+    h.pair(resourceAccum, pickupAccum);
+    for (int i = 0; i < 4; ++i) {
+        h.word(rngs[i]->key);
+        h.word(rngs[i]->counter);
+    }
+    return h.finish();
+}
+
+// Per-record steps, shared by the map/vector forms below and by
+// GameEngine::checksum(), which walks its player columns and entity stores
+static void hashPlayer(StateHasher& h, const Player& p) {
+    h.pair(p.id, (uint32_t)p.score);
+    h.pair(p.cursor.x, p.cursor.y);
+    h.pair((uint32_t)p.hasInput | (uint32_t)p.alive << 1 | (uint32_t)p.boosting << 2
+           | (uint32_t)p.lastInputSeq << 16, p.lastInputClientTime);
+    h.pair(p.mutations.speed, p.mutations.cohesion);
+    h.pair(p.mutations.aggression, p.mutations.collectRange);
+    h.pair(p.boostFuel, 0.0f);
+    h.pair((uint32_t)p.shieldTicks, (uint32_t)p.speedBurstTicks);
+    h.pair((uint32_t)p.slowTicks, 0u);
+}
+
+static void hashBoid(StateHasher& h, uint32_t id, uint32_t playerId, const Vec2& pos, const Vec2& vel) {
+    h.pair(id, playerId);
+    h.pair(pos.x, pos.y);
+    h.pair(vel.x, vel.y);
+}
+
+static void hashResource(StateHasher& h, uint32_t id, const Vec2& pos, int value, uint8_t type, bool active) {
+    h.pair(id, (uint32_t)value);
+    h.pair(pos.x, pos.y);
+    h.pair((uint32_t)type, (uint32_t)active);
+}
+
+static void hashPickup(StateHasher& h, uint32_t id, const Vec2& pos, uint8_t type, bool active) {
+    h.pair(id, (uint32_t)type | (uint32_t)active << 8);
+    h.pair(pos.x, pos.y);
+}
+
+uint64_t checksumPlayers(const std::unordered_map<uint32_t, Player>& players) {
+    std::vector<uint32_t> ids;
+    ids.reserve(players.size());
+    for (auto& [pid, player] : players) ids.push_back(pid);
+    std::sort(ids.begin(), ids.end());
+
+    StateHasher h;
+    for (uint32_t pid : ids) hashPlayer(h, players.at(pid));
+    return h.finish();
+}
+
+uint64_t checksumBoids(const std::vector<Boid>& boids) {
+    StateHasher h;
+    for (const Boid& b : boids) hashBoid(h, b.id, b.playerId, b.pos, b.vel);
+    return h.finish();
+}
+
+uint64_t checksumResources(const std::vector<Resource>& resources) {
+    StateHasher h;
+    for (const Resource& r : resources) hashResource(h, r.id, r.pos, r.value, r.type, r.active);
+    return h.finish();
+}
+
+uint64_t checksumPickups(const std::vector<Pickup>& pickups) {
+    StateHasher h;
+    for (const Pickup& p : pickups) hashPickup(h, p.id, p.pos, p.type, p.active);
+    return h.finish();
+}
+
+StateChecksum GameEngine::checksum() const {
+    const uint32_t nextIds[4] = {nextPlayerId_, nextBoidId_, nextResourceId_, nextPickupId_};
+    const RngStream* const rngs[4] = {&rngSpawn_, &rngResource_, &rngPickup_, &rngEffect_};
+
+    StateChecksum sum;
+    sum.tick = tick_;
+    sum.part[CHK_WORLD]     = checksumWorld(tick_, nextIds, resourceSpawnAccum_, pickupSpawnAccum_, rngs);
+
+    StateHasher resources;
+    for (uint32_t row = 0; row < (uint32_t)resources_.rows(); ++row) {
+        const ResourceYield& y = resources_.get<ResourceYield>(row);
+        hashResource(resources, resources_.id(row), resources_.get<Vec2>(row), y.value, y.type,
+                     resources_.alive(row));
+    }
+    sum.part[CHK_RESOURCES] = resources.finish();
+
+    StateHasher pickups;
+    for (uint32_t row = 0; row < (uint32_t)pickups_.rows(); ++row) {
+        hashPickup(pickups, pickups_.id(row), pickups_.get<Vec2>(row),
+                   pickups_.get<PickupKind>(row).type, pickups_.alive(row));
+    }
+    sum.part[CHK_PICKUPS] = pickups.finish();
+
+    StateHasher players;
+    for (uint32_t slot = 0; slot < (uint32_t)playerOrder_.size(); ++slot) {
+        hashPlayer(players, playerRecord(slot));
+    }
+    sum.part[CHK_PLAYERS] = players.finish();
+
+    StateHasher boids;
+    const auto& hot = boids_.column<BoidHot>();
+    for (uint32_t row = 0; row < (uint32_t)boids_.rows(); ++row) {
+        const BoidHot& b = hot[row];
+        hashBoid(boids, boids_.id(row), playerOrder_[b.slot], b.pos, b.vel);
+    }
+    sum.part[CHK_BOIDS] = boids.finish();
+    return sum;
+}
+
+// ============================================================
+// N-API Bindings
+// ============================================================
+
+static GameEngine* g_engine = nullptr;
+static SenderPool* g_sender = nullptr;
+static NativeServer* g_native = nullptr;
+
+// Host settings of a hibernated room; the image only holds the world
+struct HibernatedRoom {
+    std::string path;
+    bool compression = false;
+    bool spectator = false;
+    int  checksumInterval = 0;
+    RoomCapacity capacity;
+};
+static HibernatedRoom* g_hibernated = nullptr;
+
+static napi_value ToArrayBuffer(napi_env env, const std::vector<uint8_t>& data) {
+    napi_value arrayBuffer;
+    void* bufferData;
+    napi_create_arraybuffer(env, data.size(), &bufferData, &arrayBuffer);
+    memcpy(bufferData, data.data(), data.size());
+    return arrayBuffer;
+}
+
+// Seeds arrive as BigInt (full 64 bits) or number
+static uint64_t GetSeed(napi_env env, napi_value value) {
+    napi_valuetype type;
+    napi_typeof(env, value, &type);
+    uint64_t seed = 0;
+    if (type == napi_bigint) {
+        bool lossless;
+        napi_get_value_bigint_uint64(env, value, &seed, &lossless);
+    } else if (type == napi_number) {
+        int64_t v = 0;
+        napi_get_value_int64(env, value, &v);
+        seed = (uint64_t)v;
+    }
+    return seed;
+}
+
+// createEngine(seed?, { maxPlayers?, hugePages?, mode? }?) — seed is a number or
+// BigInt; omitted or 0 = random. maxPlayers > 0 pre-sizes the room and caps
+// joins. mode: 'classic' (default), 'blitz', 'mega' or 'horde'; throws on others.
+static napi_value NapiCreateEngine(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    uint64_t seed = argc >= 1 ? GetSeed(env, args[0]) : 0;
+
+    RoomCapacity capacity;
+    GameMode mode = GameMode::Classic;
+    napi_valuetype optsType = napi_undefined;
+    if (argc >= 2) napi_typeof(env, args[1], &optsType);
+    if (optsType == napi_object) {
+        napi_value v;
+        bool has = false;
+        napi_has_named_property(env, args[1], "maxPlayers", &has);
+        if (has && napi_get_named_property(env, args[1], "maxPlayers", &v) == napi_ok) {
+            napi_get_value_uint32(env, v, &capacity.maxPlayers);
+        }
+        napi_has_named_property(env, args[1], "hugePages", &has);
+        if (has && napi_get_named_property(env, args[1], "hugePages", &v) == napi_ok) {
+            napi_get_value_bool(env, v, &capacity.hugePages);
+        }
+        napi_has_named_property(env, args[1], "mode", &has);
+        if (has && napi_get_named_property(env, args[1], "mode", &v) == napi_ok) {
+            char name[32];
+            size_t len = 0;
+            napi_get_value_string_utf8(env, v, name, sizeof(name), &len);
+            if (!parseGameMode(std::string(name, len), mode)) {
+                napi_throw_error(env, nullptr, "unknown game mode (classic, blitz, mega, horde)");
+                return nullptr;
+            }
+        }
+    }
+
+    // The native front end holds an engine pointer; it must be restarted
+    if (g_native) {
+        delete g_native;
+        g_native = nullptr;
+    }
+    if (g_engine) delete g_engine;
+    delete g_hibernated;
+    g_hibernated = nullptr;
+    g_engine = new GameEngine(seed, capacity, mode);
+
+    napi_value result;
+    napi_get_boolean(env, true, &result);
+    return result;
+}
+
+// addPlayer() -> playerId (number), 0 when a capped room is full
+static napi_value NapiAddPlayer(napi_env env, napi_callback_info info) {
+    if (!g_engine) {
+        napi_value undef;
+        napi_get_undefined(env, &undef);
+        return undef;
+    }
+    uint32_t pid = g_engine->addPlayer();
+    napi_value result;
+    napi_create_uint32(env, pid, &result);
+    return result;
+}
+
+// removePlayer(playerId)
+static napi_value NapiRemovePlayer(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    uint32_t pid;
+    napi_get_value_uint32(env, args[0], &pid);
+
+    if (g_engine) g_engine->removePlayer(pid);
+
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+// setPlayerCursor(playerId, x, y)
+static napi_value NapiSetCursor(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    uint32_t pid;
     double x, y;
     napi_get_value_uint32(env, args[0], &pid);
     napi_get_value_double(env, args[1], &x);
@@ -813,6 +2321,25 @@ static napi_value NapiSetCursor(napi_env env, napi_callback_info info) {
     return undef;
 }
 
+// submitInputs(buffer) -> accepted count. Buffer holds INPUT_RECORD_SIZE
+// records: [uint32 playerId][input frame].
+static napi_value NapiSubmitInputs(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    size_t accepted = 0;
+    void* data = nullptr;
+    size_t len = 0;
+    if (g_engine && argc > 0 && napi_get_buffer_info(env, args[0], &data, &len) == napi_ok) {
+        accepted = g_engine->submitInputBatch((const uint8_t*)data, len);
+    }
+
+    napi_value result;
+    napi_create_uint32(env, (uint32_t)accepted, &result);
+    return result;
+}
+
 // setPlayerBoost(playerId, boosting)
 static napi_value NapiSetBoost(napi_env env, napi_callback_info info) {
     size_t argc = 2;
@@ -831,24 +2358,1025 @@ static napi_value NapiSetBoost(napi_env env, napi_callback_info info) {
     return undef;
 }
 
-// tick() -> ArrayBuffer with serialized state
+// tick() — advance the simulation by one step
 static napi_value NapiTick(napi_env env, napi_callback_info info) {
+    if (g_engine) g_engine->tick();
+
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+// getState() -> ArrayBuffer with every swarm in full detail
+static napi_value NapiGetState(napi_env env, napi_callback_info info) {
     if (!g_engine) {
         napi_value undef;
         napi_get_undefined(env, &undef);
         return undef;
     }
+    return ToArrayBuffer(env, g_engine->serializeState());
+}
 
-    g_engine->tick();
+// getStateFor(playerId) -> ArrayBuffer with far swarms encoded as impostors
+static napi_value NapiGetStateFor(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
 
-    std::vector<uint8_t> data = g_engine->serializeState();
+    if (!g_engine) {
+        napi_value undef;
+        napi_get_undefined(env, &undef);
+        return undef;
+    }
 
-    napi_value arrayBuffer;
-    void* bufferData;
-    napi_create_arraybuffer(env, data.size(), &bufferData, &arrayBuffer);
-    memcpy(bufferData, data.data(), data.size());
+    uint32_t pid;
+    napi_get_value_uint32(env, args[0], &pid);
+    return ToArrayBuffer(env, g_engine->serializeStateFor(pid));
+}
 
-    return arrayBuffer;
+// getKeyframe() -> ArrayBuffer (cached full snapshot, at most
+// KEYFRAME_INTERVAL ticks old)
+static napi_value NapiGetKeyframe(napi_env env, napi_callback_info info) {
+    if (!g_engine) {
+        napi_value undef;
+        napi_get_undefined(env, &undef);
+        return undef;
+    }
+    return ToArrayBuffer(env, g_engine->getKeyframe());
+}
+
+// getMinimap() -> ArrayBuffer with the run-length encoded occupancy grid
+static napi_value NapiGetMinimap(napi_env env, napi_callback_info info) {
+    if (!g_engine) {
+        napi_value undef;
+        napi_get_undefined(env, &undef);
+        return undef;
+    }
+    return ToArrayBuffer(env, g_engine->serializeMinimap());
+}
+
+// setCompression(enabled)
+static napi_value NapiSetCompression(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    bool enabled = false;
+    napi_get_value_bool(env, args[0], &enabled);
+    if (g_engine) g_engine->setCompression(enabled);
+
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+// getStats() -> serializer, input and (native mode) sender counters
+static napi_value NapiGetStats(napi_env env, napi_callback_info info) {
+    napi_value obj;
+    napi_create_object(env, &obj);
+    if (!g_engine) return obj;
+
+    const SerializerStats& st = g_engine->getSerializerStats();
+    auto setNumber = [&](const char* name, double v) {
+        napi_value n;
+        napi_create_double(env, v, &n);
+        napi_set_named_property(env, obj, name, n);
+    };
+
+    napi_value enabled;
+    napi_get_boolean(env, g_engine->compressionEnabled(), &enabled);
+    napi_set_named_property(env, obj, "compression", enabled);
+
+    napi_value mode;
+    napi_create_string_utf8(env, g_engine->modeInfo().name, NAPI_AUTO_LENGTH, &mode);
+    napi_set_named_property(env, obj, "mode", mode);
+
+    setNumber("payloads",        (double)st.payloads);
+    setNumber("rawBytes",        (double)st.rawBytes);
+    setNumber("encodedBytes",    (double)st.encodedBytes);
+    setNumber("ratio",           st.encodedBytes ? (double)st.rawBytes / (double)st.encodedBytes : 1.0);
+    setNumber("encodeMs",        (double)st.encodeNanos / 1e6);
+    setNumber("encodeNsPerByte", st.rawBytes ? (double)st.encodeNanos / (double)st.rawBytes : 0.0);
+    setNumber("playerRowsEncoded", (double)st.playerRowsEncoded);
+    setNumber("playerRowsReused",  (double)st.playerRowsReused);
+
+    InputStats is = g_engine->getInputStats();
+    setNumber("inputsAccepted", (double)is.accepted);
+    setNumber("inputsRejected", (double)is.rejected);
+    setNumber("inputsStale",    (double)is.stale);
+
+    {
+        const TickAllocStats& as = g_engine->getAllocStats();
+        napi_value allocations, counted;
+        napi_create_object(env, &allocations);
+        auto setAlloc = [&](const char* name, double v) {
+            napi_value n;
+            napi_create_double(env, v, &n);
+            napi_set_named_property(env, allocations, name, n);
+        };
+        napi_get_boolean(env, allocationCountingSupported(), &counted);
+        napi_set_named_property(env, allocations, "counted", counted);
+        setAlloc("lastTick",        (double)as.lastTick);
+        setAlloc("total",           (double)as.total);
+        setAlloc("allocatingTicks", (double)as.allocatingTicks);
+        setAlloc("quietStreak",     (double)as.quietStreak);
+        setAlloc("arenaBytes",      (double)g_engine->tickArena().capacity());
+        setAlloc("arenaHighWater",  (double)g_engine->tickArena().highWater());
+        setAlloc("arenaSpills",     (double)g_engine->tickArena().spills());
+        setAlloc("quadTreeNodes",   (double)g_engine->quadTree().nodeCapacity());
+        napi_set_named_property(env, obj, "allocations", allocations);
+    }
+
+    {
+        const CapacityStats& cs = g_engine->getCapacityStats();
+        napi_value capacity;
+        napi_create_object(env, &capacity);
+        auto setCapacity = [&](const char* name, double v) {
+            napi_value n;
+            napi_create_double(env, v, &n);
+            napi_set_named_property(env, capacity, name, n);
+        };
+        setCapacity("maxPlayers",    (double)g_engine->capacity().maxPlayers);
+        setCapacity("reservedBytes", (double)cs.reservedBytes);
+        setCapacity("hugePageBytes", (double)cs.hugePageBytes);
+        setCapacity("rejectedJoins", (double)cs.rejectedJoins);
+        setCapacity("regrowths",     (double)cs.regrowths);
+        napi_set_named_property(env, obj, "capacity", capacity);
+    }
+
+    {
+        // kernels[effects] = { runs, boids } per specialized boid kernel
+        const BoidKernelStats& ks = g_engine->getKernelStats();
+        napi_value kernels;
+        napi_create_array_with_length(env, BOID_KERNEL_VARIANTS, &kernels);
+        for (uint32_t v = 0; v < (uint32_t)BOID_KERNEL_VARIANTS; ++v) {
+            napi_value entry, runs, boids;
+            napi_create_object(env, &entry);
+            napi_create_double(env, (double)ks.runs[v], &runs);
+            napi_create_double(env, (double)ks.boids[v], &boids);
+            napi_set_named_property(env, entry, "runs", runs);
+            napi_set_named_property(env, entry, "boids", boids);
+            napi_set_element(env, kernels, v, entry);
+        }
+        napi_set_named_property(env, obj, "kernels", kernels);
+    }
+
+    {
+        // entities.{boids,resources,pickups} = { live, created, destroyed }
+        napi_value entities;
+        napi_create_object(env, &entities);
+        auto setStore = [&](const char* name, size_t live, uint64_t created, uint64_t destroyed) {
+            napi_value store, v;
+            napi_create_object(env, &store);
+            napi_create_double(env, (double)live, &v);
+            napi_set_named_property(env, store, "live", v);
+            napi_create_double(env, (double)created, &v);
+            napi_set_named_property(env, store, "created", v);
+            napi_create_double(env, (double)destroyed, &v);
+            napi_set_named_property(env, store, "destroyed", v);
+            napi_set_named_property(env, entities, name, store);
+        };
+        const BoidStore& boids = g_engine->boidStore();
+        const ResourceStore& resources = g_engine->resourceStore();
+        const PickupStore& pickups = g_engine->pickupStore();
+        setStore("boids",     boids.live(),     boids.created(),     boids.destroyed());
+        setStore("resources", resources.live(), resources.created(), resources.destroyed());
+        setStore("pickups",   pickups.live(),   pickups.created(),   pickups.destroyed());
+        napi_set_named_property(env, obj, "entities", entities);
+    }
+
+    {
+        // changes = { historyStart, players (changed in the last tick), removalsKept }
+        napi_value changes;
+        napi_create_object(env, &changes);
+        auto setChanges = [&](const char* name, double v) {
+            napi_value n;
+            napi_create_double(env, v, &n);
+            napi_set_named_property(env, changes, name, n);
+        };
+        uint32_t tick = g_engine->currentTick();
+        uint32_t changed = 0;
+        g_engine->forEachPlayerChange(tick ? tick - 1 : 0, [&](uint32_t, uint32_t) { changed++; });
+        setChanges("historyStart", (double)g_engine->changeHistoryStart());
+        setChanges("players",      (double)changed);
+        setChanges("removalsKept", (double)(g_engine->removedPlayers().size()
+                                            + g_engine->boidStore().removals().size()
+                                            + g_engine->resourceStore().removals().size()
+                                            + g_engine->pickupStore().removals().size()));
+        napi_set_named_property(env, obj, "changes", changes);
+    }
+
+    if (const InputRecorder* rec = g_engine->recorder()) {
+        RecorderStats rs = rec->stats();
+        napi_value recorder;
+        napi_create_object(env, &recorder);
+        auto setRecorder = [&](const char* name, double v) {
+            napi_value n;
+            napi_create_double(env, v, &n);
+            napi_set_named_property(env, recorder, name, n);
+        };
+        setRecorder("records", (double)rs.records);
+        setRecorder("bytes",   (double)rs.bytes);
+        setRecorder("writes",  (double)rs.writes);
+        setRecorder("keyframes", (double)rs.keyframes);
+        napi_set_named_property(env, obj, "recorder", recorder);
+    }
+
+    if (g_engine->spectatorEnabled()) {
+        SpectatorStats sp = g_engine->spectator().stats();
+        napi_value spectator;
+        napi_create_object(env, &spectator);
+        auto setSpectator = [&](const char* name, double v) {
+            napi_value n;
+            napi_create_double(env, v, &n);
+            napi_set_named_property(env, spectator, name, n);
+        };
+        setSpectator("frames",    (double)sp.frames);
+        setSpectator("bytes",     (double)sp.bytes);
+        setSpectator("queued",    (double)sp.queued);
+        setSpectator("sinkBytes", (double)sp.sinkBytes);
+        setSpectator("sinkDrops", (double)sp.sinkDrops);
+        napi_set_named_property(env, obj, "spectator", spectator);
+    }
+
+    if (g_sender) {
+        SenderStats ss = g_sender->stats();
+        napi_value sender;
+        napi_create_object(env, &sender);
+        auto setSender = [&](const char* name, double v) {
+            napi_value n;
+            napi_create_double(env, v, &n);
+            napi_set_named_property(env, sender, name, n);
+        };
+        setSender("connections",   (double)ss.connections);
+        setSender("framesQueued",  (double)ss.framesQueued);
+        setSender("framesDropped", (double)ss.framesDropped);
+        setSender("bytesSent",     (double)ss.bytesSent);
+        napi_set_named_property(env, obj, "sender", sender);
+    }
+
+    return obj;
+}
+
+// getChanges(sinceTick) -> what changed after sinceTick:
+//   { tick, complete, players: [{ id, components }], removedPlayers: [id],
+//     resources: { changed: [id], removed: [id] }, pickups: { ... },
+//     boids: { changed, removed } }
+// components is a PlayerComponent mask; boids are counted, not listed, and
+// their motion is not tracked. complete is false when sinceTick predates the
+// kept history, in which case removals may be missing: resync from a snapshot.
+static napi_value NapiGetChanges(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    uint32_t since = 0;
+    if (argc >= 1) napi_get_value_uint32(env, args[0], &since);
+
+    napi_value obj;
+    napi_create_object(env, &obj);
+    if (!g_engine) return obj;
+
+    auto number = [&](double v) {
+        napi_value n;
+        napi_create_double(env, v, &n);
+        return n;
+    };
+    auto push = [&](napi_value arr, uint32_t& len, napi_value v) {
+        napi_set_element(env, arr, len++, v);
+    };
+
+    napi_value complete;
+    napi_get_boolean(env, since >= g_engine->changeHistoryStart(), &complete);
+    napi_set_named_property(env, obj, "tick", number(g_engine->currentTick()));
+    napi_set_named_property(env, obj, "complete", complete);
+
+    napi_value players, removedPlayers;
+    uint32_t numPlayers = 0, numRemoved = 0;
+    napi_create_array(env, &players);
+    napi_create_array(env, &removedPlayers);
+    g_engine->forEachPlayerChange(since, [&](uint32_t id, uint32_t components) {
+        napi_value entry;
+        napi_create_object(env, &entry);
+        napi_set_named_property(env, entry, "id", number(id));
+        napi_set_named_property(env, entry, "components", number(components));
+        push(players, numPlayers, entry);
+    });
+    g_engine->removedPlayers().forEachSince(since, [&](uint32_t id, uint32_t) {
+        push(removedPlayers, numRemoved, number(id));
+    });
+    napi_set_named_property(env, obj, "players", players);
+    napi_set_named_property(env, obj, "removedPlayers", removedPlayers);
+
+    auto listStore = [&](const char* name, const auto& store) {
+        napi_value entry, changed, removed;
+        uint32_t numChanged = 0, numGone = 0;
+        napi_create_object(env, &entry);
+        napi_create_array(env, &changed);
+        napi_create_array(env, &removed);
+        for (uint32_t row = 0; row < (uint32_t)store.rows(); ++row) {
+            if (store.alive(row) && store.changedSince(row, since)) {
+                push(changed, numChanged, number(store.id(row)));
+            }
+        }
+        store.removals().forEachSince(since, [&](uint32_t id, uint32_t) {
+            push(removed, numGone, number(id));
+        });
+        napi_set_named_property(env, entry, "changed", changed);
+        napi_set_named_property(env, entry, "removed", removed);
+        napi_set_named_property(env, obj, name, entry);
+    };
+    listStore("resources", g_engine->resourceStore());
+    listStore("pickups",   g_engine->pickupStore());
+
+    const BoidStore& boidStore = g_engine->boidStore();
+    uint32_t boidsChanged = 0, boidsRemoved = 0;
+    for (uint32_t row = 0; row < (uint32_t)boidStore.rows(); ++row) {
+        if (boidStore.alive(row) && boidStore.changedSince(row, since)) boidsChanged++;
+    }
+    boidStore.removals().forEachSince(since, [&](uint32_t, uint32_t) { boidsRemoved++; });
+    napi_value boids;
+    napi_create_object(env, &boids);
+    napi_set_named_property(env, boids, "changed", number(boidsChanged));
+    napi_set_named_property(env, boids, "removed", number(boidsRemoved));
+    napi_set_named_property(env, obj, "boids", boids);
+
+    return obj;
+}
+
+// startNativeServer({ port, threads, tickRate }) — epoll WebSocket front end
+static napi_value NapiStartNativeServer(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    napi_value result;
+    napi_get_boolean(env, g_native != nullptr, &result);
+    if (!g_engine || g_native) return result;
+
+    NativeServerConfig config;
+    auto readU32 = [&](const char* name, uint32_t& out) {
+        bool has = false;
+        if (argc < 1 || napi_has_named_property(env, args[0], name, &has) != napi_ok || !has) return;
+        napi_value v;
+        napi_get_named_property(env, args[0], name, &v);
+        napi_get_value_uint32(env, v, &out);
+    };
+    uint32_t port = config.port, threads = (uint32_t)config.sendThreads, tickRate = (uint32_t)config.tickRate;
+    readU32("port", port);
+    readU32("threads", threads);
+    readU32("tickRate", tickRate);
+    config.port = (uint16_t)port;
+    config.sendThreads = (int)std::clamp<uint32_t>(threads, 1, 16);
+    config.tickRate = (int)tickRate;
+
+    if (!g_sender) g_sender = new SenderPool(config.sendThreads);
+    g_native = new NativeServer(g_engine, g_sender, config);
+
+    std::string error;
+    if (!g_native->start(error)) {
+        delete g_native;
+        g_native = nullptr;
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+
+    napi_get_boolean(env, true, &result);
+    return result;
+}
+
+// pumpNative() — apply native joins/leaves on the engine thread
+static napi_value NapiPumpNative(napi_env env, napi_callback_info info) {
+    if (g_native) g_native->pump();
+
+    napi_value count;
+    napi_create_uint32(env, g_native ? g_native->connectionCount() : 0, &count);
+    return count;
+}
+
+// broadcastState() -> bytes per message. Encodes the full snapshot once and
+// hands one shared WebSocket frame to every native connection.
+static napi_value NapiBroadcastState(napi_env env, napi_callback_info info) {
+    size_t size = 0;
+    if (g_engine && g_native) {
+        std::vector<uint8_t> data = g_engine->serializeState();
+        g_native->broadcast(NATIVE_CH_STATE, data);
+        size = data.size();
+    }
+
+    napi_value result;
+    napi_create_uint32(env, (uint32_t)size, &result);
+    return result;
+}
+
+// broadcastMinimap() -> bytes per message
+static napi_value NapiBroadcastMinimap(napi_env env, napi_callback_info info) {
+    size_t size = 0;
+    if (g_engine && g_native) {
+        std::vector<uint8_t> data = g_engine->serializeMinimap();
+        g_native->broadcast(NATIVE_CH_MINIMAP, data);
+        size = data.size();
+    }
+
+    napi_value result;
+    napi_create_uint32(env, (uint32_t)size, &result);
+    return result;
+}
+
+// setSpectator({ enabled, sink }) -> true. sink is an optional file or FIFO
+// path that receives every released spectator frame; throws if it can't open.
+static napi_value NapiSetSpectator(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    napi_value result;
+    napi_get_boolean(env, g_engine != nullptr, &result);
+    if (!g_engine || argc < 1) return result;
+
+    bool has = false;
+    bool enabled = true;
+    if (napi_has_named_property(env, args[0], "enabled", &has) == napi_ok && has) {
+        napi_value v;
+        napi_get_named_property(env, args[0], "enabled", &v);
+        napi_get_value_bool(env, v, &enabled);
+    }
+    g_engine->setSpectatorEnabled(enabled);
+
+    has = false;
+    g_engine->spectator().closeSink();
+    if (enabled && napi_has_named_property(env, args[0], "sink", &has) == napi_ok && has) {
+        napi_value v;
+        napi_get_named_property(env, args[0], "sink", &v);
+        char path[1024];
+        size_t len = 0;
+        if (napi_get_value_string_utf8(env, v, path, sizeof(path), &len) == napi_ok && len > 0) {
+            std::string error;
+            if (!g_engine->spectator().openSink(path, error)) {
+                napi_throw_error(env, nullptr, error.c_str());
+                return nullptr;
+            }
+        }
+    }
+    return result;
+}
+
+// pollSpectator() -> ArrayBuffer if a spectator frame was released since the
+// last poll, otherwise undefined. One shared payload for every spectator.
+static napi_value NapiPollSpectator(napi_env env, napi_callback_info info) {
+    if (!g_engine || !g_engine->spectator().takeFresh()) {
+        napi_value undef;
+        napi_get_undefined(env, &undef);
+        return undef;
+    }
+    return ToArrayBuffer(env, g_engine->spectator().latest());
+}
+
+// getSpectatorFrame() -> latest released frame (for newly attached
+// spectators), or undefined before the first release
+static napi_value NapiGetSpectatorFrame(napi_env env, napi_callback_info info) {
+    if (!g_engine || g_engine->spectator().latest().empty()) {
+        napi_value undef;
+        napi_get_undefined(env, &undef);
+        return undef;
+    }
+    return ToArrayBuffer(env, g_engine->spectator().latest());
+}
+
+// broadcastSpectator() -> bytes per message, 0 if no frame was released
+static napi_value NapiBroadcastSpectator(napi_env env, napi_callback_info info) {
+    size_t size = 0;
+    if (g_engine && g_native && g_engine->spectator().takeFresh()) {
+        const std::vector<uint8_t>& data = g_engine->spectator().latest();
+        g_native->broadcast(NATIVE_CH_STATE, data, SENDER_GROUP_SPECTATORS);
+        size = data.size();
+    }
+
+    napi_value result;
+    napi_create_uint32(env, (uint32_t)size, &result);
+    return result;
+}
+
+// saveState() -> ArrayBuffer world checkpoint
+static napi_value NapiSaveState(napi_env env, napi_callback_info info) {
+    if (!g_engine) {
+        napi_value undef;
+        napi_get_undefined(env, &undef);
+        return undef;
+    }
+    return ToArrayBuffer(env, g_engine->saveState());
+}
+
+// loadState(buffer) -> true; throws on a malformed checkpoint (the engine
+// is left unchanged)
+static napi_value NapiLoadState(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    napi_value result;
+    napi_get_boolean(env, false, &result);
+    void* data = nullptr;
+    size_t len = 0;
+    if (!g_engine || argc < 1 || napi_get_buffer_info(env, args[0], &data, &len) != napi_ok) {
+        return result;
+    }
+
+    std::string error;
+    if (!g_engine->loadState((const uint8_t*)data, len, error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+    napi_get_boolean(env, true, &result);
+    return result;
+}
+
+// startRecording(path) -> true; throws if the archive can't be opened.
+// Starts with a keyframe, so any tick is fine.
+static napi_value NapiStartRecording(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    napi_value result;
+    napi_get_boolean(env, false, &result);
+    if (!g_engine || argc < 1) return result;
+
+    char path[1024];
+    size_t len = 0;
+    napi_get_value_string_utf8(env, args[0], path, sizeof(path), &len);
+
+    std::string error;
+    if (!g_engine->startRecording(path, error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+    napi_get_boolean(env, true, &result);
+    return result;
+}
+
+// stopRecording() — writes the end marker and keyframe index, flushes
+static napi_value NapiStopRecording(napi_env env, napi_callback_info info) {
+    if (g_engine) g_engine->stopRecording();
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+// replay(path) -> { seed, firstTick, ticks, records, players, keyframes,
+// totalMs, meanMs, p50Ms, p99Ms, maxMs, maxTick, clean, checksums,
+// divergence: null | { tick, subsystem, expected, actual }, state }. Runs
+// on a private engine; the live engine is untouched.
+static napi_value NapiReplay(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    char path[1024] = {};
+    size_t len = 0;
+    if (argc >= 1) napi_get_value_string_utf8(env, args[0], path, sizeof(path), &len);
+
+    ReplayResult r;
+    std::string error;
+    if (!replayLog(path, r, error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+
+    napi_value obj;
+    napi_create_object(env, &obj);
+    auto setNumber = [&](const char* name, double v) {
+        napi_value n;
+        napi_create_double(env, v, &n);
+        napi_set_named_property(env, obj, name, n);
+    };
+    napi_value seed, clean;
+    napi_create_bigint_uint64(env, r.seed, &seed);
+    napi_set_named_property(env, obj, "seed", seed);
+    setNumber("firstTick", r.firstTick);
+    setNumber("ticks",   r.ticks);
+    setNumber("records", (double)r.records);
+    setNumber("players", r.players);
+    setNumber("keyframes", r.keyframes);
+    setNumber("totalMs", r.totalMs);
+    setNumber("meanMs",  r.meanMs);
+    setNumber("p50Ms",   r.p50Ms);
+    setNumber("p99Ms",   r.p99Ms);
+    setNumber("maxMs",   r.maxMs);
+    setNumber("maxTick", r.maxTick);
+    napi_get_boolean(env, r.clean, &clean);
+    napi_set_named_property(env, obj, "clean", clean);
+    setNumber("checksums", r.checksums);
+
+    napi_value divergence;
+    if (r.divergence.found) {
+        napi_value tick, subsystem, expected, actual;
+        napi_create_object(env, &divergence);
+        napi_create_uint32(env, r.divergence.tick, &tick);
+        napi_create_string_utf8(env, CHECKSUM_PART_NAMES[r.divergence.part], NAPI_AUTO_LENGTH, &subsystem);
+        napi_create_bigint_uint64(env, r.divergence.expected, &expected);
+        napi_create_bigint_uint64(env, r.divergence.actual, &actual);
+        napi_set_named_property(env, divergence, "tick", tick);
+        napi_set_named_property(env, divergence, "subsystem", subsystem);
+        napi_set_named_property(env, divergence, "expected", expected);
+        napi_set_named_property(env, divergence, "actual", actual);
+    } else {
+        napi_get_null(env, &divergence);
+    }
+    napi_set_named_property(env, obj, "divergence", divergence);
+    napi_set_named_property(env, obj, "state", ToArrayBuffer(env, r.finalState));
+    return obj;
+}
+
+// setChecksumInterval(ticks) — hash the world every N ticks (0 = off);
+// recordings embed each checksum for replay verification
+static napi_value NapiSetChecksumInterval(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    int32_t ticks = 0;
+    if (argc >= 1) napi_get_value_int32(env, args[0], &ticks);
+    if (g_engine) g_engine->setChecksumInterval(ticks);
+
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+// getChecksum() -> { tick, hash, world, players, boids, resources, pickups }
+// (BigInt hashes) of the current state, computed on the spot
+static napi_value NapiGetChecksum(napi_env env, napi_callback_info info) {
+    napi_value obj;
+    napi_create_object(env, &obj);
+    if (!g_engine) return obj;
+
+    StateChecksum sum = g_engine->checksum();
+    napi_value tick, hash;
+    napi_create_uint32(env, sum.tick, &tick);
+    napi_create_bigint_uint64(env, sum.combined(), &hash);
+    napi_set_named_property(env, obj, "tick", tick);
+    napi_set_named_property(env, obj, "hash", hash);
+    for (int i = 0; i < CHK_PART_COUNT; ++i) {
+        napi_value v;
+        napi_create_bigint_uint64(env, sum.part[i], &v);
+        napi_set_named_property(env, obj, CHECKSUM_PART_NAMES[i], v);
+    }
+    return obj;
+}
+
+static ReplayArchive* g_replay = nullptr;
+static GameEngine* g_replayEngine = nullptr;
+
+// closeReplay() — unmaps the open archive and drops its engine
+static napi_value NapiCloseReplay(napi_env env, napi_callback_info info) {
+    delete g_replayEngine;
+    delete g_replay;
+    g_replayEngine = nullptr;
+    g_replay = nullptr;
+    napi_value undef;
+    napi_get_undefined(env, &undef);
+    return undef;
+}
+
+// openReplay(path) -> { seed, firstTick, endTick, keyframes: [tick...],
+// clean }. Maps the archive for seekReplay; replaces any open one.
+static napi_value NapiOpenReplay(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    char path[1024] = {};
+    size_t len = 0;
+    if (argc >= 1) napi_get_value_string_utf8(env, args[0], path, sizeof(path), &len);
+
+    NapiCloseReplay(env, info);
+    auto archive = new ReplayArchive();
+    std::string error;
+    if (!archive->open(path, error)) {
+        delete archive;
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+    g_replay = archive;
+    g_replayEngine = new GameEngine(archive->seed());
+
+    napi_value obj, seed, first, end, keyframes, clean;
+    napi_create_object(env, &obj);
+    napi_create_bigint_uint64(env, archive->seed(), &seed);
+    napi_create_uint32(env, archive->firstTick(), &first);
+    napi_create_uint32(env, archive->endTick(), &end);
+    napi_create_array_with_length(env, archive->keyframes().size(), &keyframes);
+    for (size_t i = 0; i < archive->keyframes().size(); ++i) {
+        napi_value t;
+        napi_create_uint32(env, archive->keyframes()[i].tick, &t);
+        napi_set_element(env, keyframes, (uint32_t)i, t);
+    }
+    napi_get_boolean(env, archive->clean(), &clean);
+    napi_set_named_property(env, obj, "seed", seed);
+    napi_set_named_property(env, obj, "firstTick", first);
+    napi_set_named_property(env, obj, "endTick", end);
+    napi_set_named_property(env, obj, "keyframes", keyframes);
+    napi_set_named_property(env, obj, "clean", clean);
+    return obj;
+}
+
+// seekReplay(tick) -> ArrayBuffer (getState encoding) of the archived game
+// at that tick, clamped to the recorded range
+static napi_value NapiSeekReplay(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (!g_replay) {
+        napi_throw_error(env, nullptr, "no replay archive open (call openReplay)");
+        return nullptr;
+    }
+    uint32_t tick = 0;
+    if (argc >= 1) napi_get_value_uint32(env, args[0], &tick);
+
+    std::string error;
+    if (!g_replay->seek(*g_replayEngine, tick, error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+    return ToArrayBuffer(env, g_replayEngine->serializeState());
+}
+
+static napi_value HandoffResult(napi_env env, const HandoffStats& st) {
+    napi_value obj;
+    napi_create_object(env, &obj);
+    auto setNumber = [&](const char* name, double v) {
+        napi_value n;
+        napi_create_double(env, v, &n);
+        napi_set_named_property(env, obj, name, n);
+    };
+    setNumber("tick",    st.tick);
+    setNumber("bytes",   (double)st.bytes);
+    setNumber("stateMs", st.stateMs);
+    setNumber("fileMs",  st.fileMs);
+    return obj;
+}
+
+// writeHandoff(path, app) -> { tick, bytes, stateMs, fileMs }. Call between
+// ticks; `app` is an opaque string handed to the successor.
+static napi_value NapiWriteHandoff(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (!g_engine || argc < 1) {
+        napi_throw_error(env, nullptr, "writeHandoff(path, app) needs an engine");
+        return nullptr;
+    }
+    char path[1024] = {};
+    size_t len = 0;
+    napi_get_value_string_utf8(env, args[0], path, sizeof(path), &len);
+
+    std::string app;
+    if (argc >= 2) {
+        size_t appLen = 0;
+        if (napi_get_value_string_utf8(env, args[1], nullptr, 0, &appLen) == napi_ok) {
+            app.resize(appLen + 1);
+            napi_get_value_string_utf8(env, args[1], &app[0], app.size(), &appLen);
+            app.resize(appLen);
+        }
+    }
+
+    HandoffStats st;
+    std::string error;
+    if (!writeHandoff(*g_engine, path, app, st, error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+    return HandoffResult(env, st);
+}
+
+// loadHandoff(path) -> null when there is nothing to resume, else { tick,
+// bytes, stateMs, fileMs, app }. The file is consumed either way; throws
+// if it was unusable (the engine is then left as it was).
+static napi_value NapiLoadHandoff(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    napi_value result;
+    napi_get_null(env, &result);
+    if (!g_engine || argc < 1) return result;
+
+    char path[1024] = {};
+    size_t len = 0;
+    napi_get_value_string_utf8(env, args[0], path, sizeof(path), &len);
+
+    HandoffStats st;
+    std::string app, error;
+    if (!readHandoff(*g_engine, path, app, st, error)) {
+        if (error.empty()) return result;
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+    result = HandoffResult(env, st);
+    napi_value appStr;
+    napi_create_string_utf8(env, app.data(), app.size(), &appStr);
+    napi_set_named_property(env, result, "app", appStr);
+    return result;
+}
+
+static napi_value HibernateResult(napi_env env, const HibernateStats& st) {
+    napi_value obj;
+    napi_create_object(env, &obj);
+    auto setNumber = [&](const char* name, double v) {
+        napi_value n;
+        napi_create_double(env, v, &n);
+        napi_set_named_property(env, obj, name, n);
+    };
+    setNumber("tick",     st.tick);
+    setNumber("rawBytes", (double)st.rawBytes);
+    setNumber("bytes",    (double)st.bytes);
+    setNumber("stateMs",  st.stateMs);
+    setNumber("fileMs",   st.fileMs);
+    return obj;
+}
+
+// benchKernels(rounds?) -> [{ effects, nsPerBoid }] per boid kernel variant,
+// timed on the current world (which is left as it was). See tools/bench.js.
+static napi_value NapiBenchKernels(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (!g_engine) {
+        napi_throw_error(env, nullptr, "benchKernels() needs an engine");
+        return nullptr;
+    }
+    int32_t rounds = 20;
+    if (argc >= 1) napi_get_value_int32(env, args[0], &rounds);
+
+    double nsPerBoid[BOID_KERNEL_VARIANTS];
+    g_engine->benchmarkKernels(std::max(rounds, 1), nsPerBoid);
+
+    napi_value result;
+    napi_create_array_with_length(env, BOID_KERNEL_VARIANTS, &result);
+    for (uint32_t v = 0; v < (uint32_t)BOID_KERNEL_VARIANTS; ++v) {
+        napi_value entry, effects, ns;
+        napi_create_object(env, &entry);
+        napi_create_uint32(env, v, &effects);
+        napi_create_double(env, nsPerBoid[v], &ns);
+        napi_set_named_property(env, entry, "effects", effects);
+        napi_set_named_property(env, entry, "nsPerBoid", ns);
+        napi_set_element(env, result, v, entry);
+    }
+    return result;
+}
+
+// hibernate(path) -> { tick, rawBytes, bytes, stateMs, fileMs }. Writes the room to an
+// image and frees the engine (recording stops); every engine call is then
+// a no-op until wake(). Not available with the native transport.
+static napi_value NapiHibernate(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (!g_engine || g_native || argc < 1) {
+        napi_throw_error(env, nullptr, "hibernate(path) needs an engine and no native server");
+        return nullptr;
+    }
+    char path[1024] = {};
+    size_t len = 0;
+    napi_get_value_string_utf8(env, args[0], path, sizeof(path), &len);
+
+    HibernateStats st;
+    std::string error;
+    if (!hibernateEngine(*g_engine, path, st, error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+    g_hibernated = new HibernatedRoom{path, g_engine->compressionEnabled(),
+                                      g_engine->spectatorEnabled(), g_engine->checksumInterval(),
+                                      g_engine->capacity()};
+    delete g_engine;
+    g_engine = nullptr;
+    releaseFreedMemory();
+    return HibernateResult(env, st);
+}
+
+// wake() -> { tick, rawBytes, bytes, stateMs, fileMs }. Restores the hibernated room
+// with its compression / spectator / checksum / capacity settings and deletes the
+// image; throws if nothing is hibernated or the image is unusable.
+static napi_value NapiWake(napi_env env, napi_callback_info info) {
+    if (!g_hibernated) {
+        napi_throw_error(env, nullptr, "no hibernated room");
+        return nullptr;
+    }
+    HibernateStats st;
+    std::string error;
+    std::unique_ptr<GameEngine> engine = wakeEngine(g_hibernated->path, g_hibernated->capacity, st, error);
+    if (!engine) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+    if (g_hibernated->compression) engine->setCompression(true);   // re-encodes the keyframe
+    engine->setSpectatorEnabled(g_hibernated->spectator);
+    engine->setChecksumInterval(g_hibernated->checksumInterval);
+    delete g_hibernated;
+    g_hibernated = nullptr;
+    g_engine = engine.release();
+    return HibernateResult(env, st);
+}
+
+// differential({ seed, ticks, tolerance, commands: [[tick, type, slot, x,
+// y, flag, seq], ...] }) -> { diverged, tick, subsystem, detail, maxError,
+// engineMs, referenceMs }. Runs GameEngine against ReferenceEngine on
+// private instances; type is a recorder RecordType, slot a join index.
+static napi_value NapiDifferential(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    DiffScenario sc;
+    if (argc >= 1) {
+        napi_value v;
+        double d = 0.0;
+        if (napi_get_named_property(env, args[0], "seed", &v) == napi_ok) sc.seed = GetSeed(env, v);
+        if (napi_get_named_property(env, args[0], "ticks", &v) == napi_ok
+            && napi_get_value_double(env, v, &d) == napi_ok) sc.ticks = (uint32_t)d;
+        if (napi_get_named_property(env, args[0], "tolerance", &v) == napi_ok
+            && napi_get_value_double(env, v, &d) == napi_ok) sc.tolerance = (float)d;
+
+        napi_value list;
+        uint32_t count = 0;
+        if (napi_get_named_property(env, args[0], "commands", &list) == napi_ok
+            && napi_get_array_length(env, list, &count) == napi_ok) {
+            sc.commands.reserve(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                napi_value entry;
+                uint32_t n = 0;
+                napi_get_element(env, list, i, &entry);
+                if (napi_get_array_length(env, entry, &n) != napi_ok || n < 3) continue;
+                double f[7] = {};
+                for (uint32_t k = 0; k < n && k < 7; ++k) {
+                    napi_value e;
+                    napi_get_element(env, entry, k, &e);
+                    napi_get_value_double(env, e, &f[k]);
+                }
+                DiffCommand c;
+                c.tick = (uint32_t)f[0];
+                c.type = (uint8_t)f[1];
+                c.slot = (uint32_t)f[2];
+                c.x    = (float)f[3];
+                c.y    = (float)f[4];
+                c.flag = (uint8_t)f[5];
+                c.seq  = (uint16_t)f[6];
+                sc.commands.push_back(c);
+            }
+            std::stable_sort(sc.commands.begin(), sc.commands.end(),
+                [](const DiffCommand& a, const DiffCommand& b) { return a.tick < b.tick; });
+        }
+    }
+
+    DiffResult r;
+    std::string error;
+    if (!runDifferential(sc, r, error)) {
+        napi_throw_error(env, nullptr, error.c_str());
+        return nullptr;
+    }
+
+    napi_value obj, diverged;
+    napi_create_object(env, &obj);
+    auto setNumber = [&](const char* name, double v) {
+        napi_value n;
+        napi_create_double(env, v, &n);
+        napi_set_named_property(env, obj, name, n);
+    };
+    napi_get_boolean(env, r.diverged, &diverged);
+    napi_set_named_property(env, obj, "diverged", diverged);
+    if (r.diverged) {
+        napi_value subsystem, detail;
+        napi_create_string_utf8(env, CHECKSUM_PART_NAMES[r.part], NAPI_AUTO_LENGTH, &subsystem);
+        napi_create_string_utf8(env, r.detail.c_str(), r.detail.size(), &detail);
+        setNumber("tick", r.tick);
+        napi_set_named_property(env, obj, "subsystem", subsystem);
+        napi_set_named_property(env, obj, "detail", detail);
+    }
+    setNumber("maxError",    r.maxError);
+    setNumber("engineMs",    r.engineMs);
+    setNumber("referenceMs", r.referenceMs);
+    return obj;
+}
+
+// getSeed() -> BigInt seed of the current engine (pass it back to
+// createEngine to reproduce the run)
+static napi_value NapiGetSeed(napi_env env, napi_callback_info info) {
+    napi_value result;
+    napi_create_bigint_uint64(env, g_engine ? g_engine->seed() : 0, &result);
+    return result;
+}
+
+// getTick() -> number of completed ticks
+static napi_value NapiGetTick(napi_env env, napi_callback_info info) {
+    napi_value result;
+    napi_create_uint32(env, g_engine ? g_engine->currentTick() : 0, &result);
+    return result;
 }
 
 // getMapSize() -> { width, height }
@@ -857,8 +3385,9 @@ static napi_value NapiGetMapSize(napi_env env, napi_callback_info info) {
     napi_create_object(env, &obj);
 
     napi_value w, h;
-    napi_create_double(env, MAP_WIDTH, &w);
-    napi_create_double(env, MAP_HEIGHT, &h);
+    const GameModeInfo& mode = g_engine ? g_engine->modeInfo() : gameModeInfo(GameMode::Classic);
+    napi_create_double(env, mode.mapWidth, &w);
+    napi_create_double(env, mode.mapHeight, &h);
     napi_set_named_property(env, obj, "width", w);
     napi_set_named_property(env, obj, "height", h);
 
@@ -873,7 +3402,41 @@ static napi_value Init(napi_env env, napi_value exports) {
         {"removePlayer",   nullptr, NapiRemovePlayer,  nullptr, nullptr, nullptr, napi_default, nullptr},
         {"setPlayerCursor",nullptr, NapiSetCursor,     nullptr, nullptr, nullptr, napi_default, nullptr},
         {"setPlayerBoost", nullptr, NapiSetBoost,      nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"submitInputs",   nullptr, NapiSubmitInputs,  nullptr, nullptr, nullptr, napi_default, nullptr},
         {"tick",           nullptr, NapiTick,          nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getState",       nullptr, NapiGetState,      nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getStateFor",    nullptr, NapiGetStateFor,   nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getMinimap",     nullptr, NapiGetMinimap,    nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getKeyframe",    nullptr, NapiGetKeyframe,   nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setSpectator",   nullptr, NapiSetSpectator,  nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"pollSpectator",  nullptr, NapiPollSpectator, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getSpectatorFrame",nullptr, NapiGetSpectatorFrame,nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setCompression", nullptr, NapiSetCompression,nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getStats",       nullptr, NapiGetStats,      nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getChanges",     nullptr, NapiGetChanges,    nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"startNativeServer",nullptr, NapiStartNativeServer,nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"pumpNative",     nullptr, NapiPumpNative,    nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"broadcastState", nullptr, NapiBroadcastState,nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"broadcastMinimap",nullptr, NapiBroadcastMinimap,nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"broadcastSpectator",nullptr, NapiBroadcastSpectator,nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getTick",        nullptr, NapiGetTick,       nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getSeed",        nullptr, NapiGetSeed,       nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"saveState",      nullptr, NapiSaveState,     nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"loadState",      nullptr, NapiLoadState,     nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"startRecording", nullptr, NapiStartRecording,nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"stopRecording",  nullptr, NapiStopRecording, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"replay",         nullptr, NapiReplay,        nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setChecksumInterval",nullptr, NapiSetChecksumInterval,nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getChecksum",    nullptr, NapiGetChecksum,   nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"differential",   nullptr, NapiDifferential,  nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"writeHandoff",   nullptr, NapiWriteHandoff,  nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"loadHandoff",    nullptr, NapiLoadHandoff,   nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"hibernate",      nullptr, NapiHibernate,     nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"wake",           nullptr, NapiWake,          nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"benchKernels",   nullptr, NapiBenchKernels,  nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"openReplay",     nullptr, NapiOpenReplay,    nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"seekReplay",     nullptr, NapiSeekReplay,    nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"closeReplay",    nullptr, NapiCloseReplay,   nullptr, nullptr, nullptr, napi_default, nullptr},
         {"getMapSize",     nullptr, NapiGetMapSize,    nullptr, nullptr, nullptr, napi_default, nullptr},
     };
 
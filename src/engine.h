@@ -8,6 +8,16 @@
 #include <algorithm>
 #include <random>
 #include <memory>
+#include <mutex>
+#include <atomic>
+
+#include "rng.h"
+#include "arena.h"
+#include "entities.h"
+#include "checksum.h"
+#include "spectator.h"
+
+class InputRecorder;
 
 // ============================================================
 // Constants
@@ -60,6 +70,125 @@ static constexpr int   MINE_KILL_COUNT        = 4;
 static constexpr int   QUADTREE_MAX_OBJECTS   = 8;
 static constexpr int   QUADTREE_MAX_LEVELS    = 6;
 
+// Interest management: swarms outside a viewer's area are sent as impostors
+static constexpr float VIEW_HALF_WIDTH        = 1000.0f;  // ~1080p viewport / 2
+static constexpr float VIEW_HALF_HEIGHT       = 600.0f;
+static constexpr float VIEW_MARGIN            = 300.0f;   // "near view" band
+static constexpr int   SWARM_SUMMARY_CLUSTERS = 4;
+
+// Minimap occupancy grid (built during the post-movement broadphase)
+static constexpr int   MINIMAP_GRID_SIZE      = 64;
+static constexpr int   MINIMAP_MAX_DENSITY    = 15;
+
+// Snapshot player row: id, score, alive, boosting, fuel, 4 mutations,
+// 3 effect timers, input ack (seq + client time)
+static constexpr int   PLAYER_ROW_BYTES       = 4 + 2 + 1 + 1 + 4 + 4 * 4 + 3 + 6;
+
+// Cached full snapshot handed to joining / reconnecting clients
+static constexpr int   KEYFRAME_INTERVAL      = 20;   // ticks between refreshes (1s)
+
+// Spectator stream: compressed full snapshots, lower rate, delayed
+static constexpr int   SPECTATOR_INTERVAL     = 4;    // ticks between frames (5 Hz)
+static constexpr int   SPECTATOR_DELAY        = 60;   // ticks behind live play (3s)
+
+// ============================================================
+// Game Modes (GameConfig policies)
+// ============================================================
+// The tuning constants above are the classic mode. A mode is a config type
+// carrying the same names as static constexpr members (derive from
+// ClassicConfig and shadow what differs). The simulation steps are member
+// templates instantiated once per mode, and tick() switches on the room's
+// mode once, so each mode runs with its constants folded into the hot
+// loops. View, minimap, keyframe and spectator settings are protocol-level
+// and stay global.
+
+struct ClassicConfig {
+    static constexpr float MAP_WIDTH               = ::MAP_WIDTH;
+    static constexpr float MAP_HEIGHT              = ::MAP_HEIGHT;
+    static constexpr int   MAX_BOIDS_PER_PLAYER    = ::MAX_BOIDS_PER_PLAYER;
+    static constexpr int   INITIAL_BOIDS           = ::INITIAL_BOIDS;
+    static constexpr float BOID_BASE_SPEED         = ::BOID_BASE_SPEED;
+    static constexpr float BOID_BASE_AGGRESSION    = ::BOID_BASE_AGGRESSION;
+    static constexpr float BOID_BASE_COLLECT_RANGE = ::BOID_BASE_COLLECT_RANGE;
+    static constexpr float SEPARATION_RADIUS       = ::SEPARATION_RADIUS;
+    static constexpr float ALIGNMENT_RADIUS        = ::ALIGNMENT_RADIUS;
+    static constexpr float COHESION_RADIUS         = ::COHESION_RADIUS;
+    static constexpr float SEPARATION_WEIGHT       = ::SEPARATION_WEIGHT;
+    static constexpr float ALIGNMENT_WEIGHT        = ::ALIGNMENT_WEIGHT;
+    static constexpr float COHESION_WEIGHT         = ::COHESION_WEIGHT;
+    static constexpr float CURSOR_WEIGHT           = ::CURSOR_WEIGHT;
+    static constexpr int   MAX_RESOURCES           = ::MAX_RESOURCES;
+    static constexpr float RESOURCE_SPAWN_RATE     = ::RESOURCE_SPAWN_RATE;
+    static constexpr int   RESOURCE_VALUE_MIN      = ::RESOURCE_VALUE_MIN;
+    static constexpr int   RESOURCE_VALUE_MAX      = ::RESOURCE_VALUE_MAX;
+    static constexpr float COMBAT_ABSORB_RADIUS    = ::COMBAT_ABSORB_RADIUS;
+    static constexpr float BOOST_SPEED_MULT        = ::BOOST_SPEED_MULT;
+    static constexpr float BOOST_DRAIN_RATE        = ::BOOST_DRAIN_RATE;
+    static constexpr float BOOST_RECHARGE_RATE     = ::BOOST_RECHARGE_RATE;
+    static constexpr float BOOST_MIN_FUEL          = ::BOOST_MIN_FUEL;
+    static constexpr int   MAX_PICKUPS             = ::MAX_PICKUPS;
+    static constexpr float PICKUP_SPAWN_INTERVAL   = ::PICKUP_SPAWN_INTERVAL;
+    static constexpr float PICKUP_COLLECT_RADIUS   = ::PICKUP_COLLECT_RADIUS;
+    static constexpr int   SHIELD_DURATION         = ::SHIELD_DURATION;
+    static constexpr int   SPEED_BURST_DURATION    = ::SPEED_BURST_DURATION;
+    static constexpr int   SLOW_DURATION           = ::SLOW_DURATION;
+    static constexpr float SPEED_BURST_MULT        = ::SPEED_BURST_MULT;
+    static constexpr float SLOW_MULT               = ::SLOW_MULT;
+    static constexpr float SCATTER_FORCE           = ::SCATTER_FORCE;
+    static constexpr int   MINE_KILL_COUNT         = ::MINE_KILL_COUNT;
+    static constexpr int   QUADTREE_MAX_OBJECTS    = ::QUADTREE_MAX_OBJECTS;
+    static constexpr int   QUADTREE_MAX_LEVELS     = ::QUADTREE_MAX_LEVELS;
+};
+
+// Small map, fast rounds: a quarter of the area, quicker pickups and boost
+struct BlitzConfig : ClassicConfig {
+    static constexpr float MAP_WIDTH             = 2000.0f;
+    static constexpr float MAP_HEIGHT            = 2000.0f;
+    static constexpr int   MAX_RESOURCES         = 120;
+    static constexpr float BOOST_RECHARGE_RATE   = 0.02f;
+    static constexpr float PICKUP_SPAWN_INTERVAL = 30.0f;
+    static constexpr int   QUADTREE_MAX_LEVELS   = 5;
+};
+
+// 16k mega-map: classic densities over 16x the area, deeper quadtree
+struct MegaConfig : ClassicConfig {
+    static constexpr float MAP_WIDTH             = 16000.0f;
+    static constexpr float MAP_HEIGHT            = 16000.0f;
+    static constexpr int   MAX_RESOURCES         = 4800;
+    static constexpr float RESOURCE_SPAWN_RATE   = 8.0f;
+    static constexpr int   MAX_PICKUPS           = 320;
+    static constexpr float PICKUP_SPAWN_INTERVAL = 4.0f;
+    static constexpr int   QUADTREE_MAX_LEVELS   = 8;
+};
+
+// 1000-boid swarms on the classic map
+struct HordeConfig : ClassicConfig {
+    static constexpr int   MAX_BOIDS_PER_PLAYER  = 1000;
+    static constexpr int   INITIAL_BOIDS         = 50;
+    static constexpr int   QUADTREE_MAX_OBJECTS  = 16;
+    static constexpr int   QUADTREE_MAX_LEVELS   = 7;
+};
+
+enum class GameMode : uint8_t { Classic = 0, Blitz = 1, Mega = 2, Horde = 3 };
+static constexpr int GAME_MODE_COUNT = 4;
+
+// A mode's sizes as runtime values, for code outside the simulation
+// (serialization, capacity planning, the host)
+struct GameModeInfo {
+    const char* name;
+    float mapWidth;
+    float mapHeight;
+    int   maxBoidsPerPlayer;
+    int   maxResources;
+    int   maxPickups;
+    int   quadTreeMaxObjects;
+    int   quadTreeMaxLevels;
+};
+
+const GameModeInfo& gameModeInfo(GameMode mode);
+// "classic", "blitz", "mega", "horde"; false for anything else
+bool parseGameMode(const std::string& name, GameMode& mode);
+
 // ============================================================
 // Vector2
 // ============================================================
@@ -143,6 +272,9 @@ struct Mutations {
 struct Player {
     uint32_t id;
     Vec2 cursor;
+    bool hasInput = false;
+    uint16_t lastInputSeq = 0;         // acknowledged back in every snapshot
+    uint32_t lastInputClientTime = 0;  // echoed so clients can measure latency
     Mutations mutations;
     int score = 0;
     bool alive = true;
@@ -155,6 +287,163 @@ struct Player {
     int slowTicks      = 0;
 };
 
+// ============================================================
+// Hot/Cold Entity Storage
+// ============================================================
+// Boid and Player above are the full records (checkpoints, ReferenceEngine,
+// differential checks). GameEngine stores them split by access pattern:
+// what the per-boid loops read every tick sits in dense arrays, the rest in
+// parallel side tables. Players are addressed by slot, their position in
+// the id-sorted player list; a boid names its owner by slot, so the hot
+// loops index an array instead of hashing a player id.
+
+struct BoidHot {
+    Vec2 pos;
+    Vec2 vel;
+    uint32_t slot;   // owner's player slot
+};
+
+struct PlayerHot {
+    Vec2 cursor;
+    Mutations mutations;
+    float boostFuel = 1.0f;
+    int shieldTicks     = 0;
+    int speedBurstTicks = 0;
+    int slowTicks       = 0;
+    bool boosting = false;
+};
+
+struct PlayerCold {
+    int score = 0;
+    bool alive = true;
+    bool hasInput = false;
+    uint16_t lastInputSeq = 0;
+    uint32_t lastInputClientTime = 0;
+};
+
+// ============================================================
+// SwarmSummary (per-player aggregate, recomputed every tick)
+// ============================================================
+// Used to encode far-away swarms as impostors instead of per-boid data.
+// Clusters are the centroids of the four quadrants around the swarm centroid.
+
+struct SwarmSummary {
+    uint32_t playerId;
+    int  count = 0;
+    Vec2 centroid;
+    Vec2 meanVel;
+    float covXX = 0.0f, covXY = 0.0f, covYY = 0.0f;
+    Vec2 minPos, maxPos;
+    int  numClusters = 0;
+    Vec2 clusters[SWARM_SUMMARY_CLUSTERS];
+    int  clusterCounts[SWARM_SUMMARY_CLUSTERS] = {};
+    uint32_t firstBoid = 0;  // offset into swarmBoidOrder_
+};
+
+// ============================================================
+// MinimapCell
+// ============================================================
+// Owner is the majority player in the cell (Boyer-Moore vote), 0 = empty.
+
+struct MinimapCell {
+    uint16_t count = 0;
+    uint16_t votes = 0;
+    uint32_t owner = 0;
+};
+
+// ============================================================
+// InputFrame (client -> server, fixed size; format next to serializeState)
+// ============================================================
+
+static constexpr size_t  INPUT_FRAME_SIZE   = 12;
+static constexpr size_t  INPUT_RECORD_SIZE  = 4 + INPUT_FRAME_SIZE;  // [u32 playerId] + frame (bulk API)
+static constexpr uint8_t INPUT_FLAG_BOOST   = 0x01;
+static constexpr uint8_t INPUT_FLAGS_KNOWN  = INPUT_FLAG_BOOST;
+
+// A validated, dequantized input frame waiting for the next tick
+struct InputCommand {
+    uint32_t playerId = 0;
+    uint16_t seq = 0;
+    float    x = 0.0f, y = 0.0f;
+    bool     boost = false;
+    uint32_t clientTime = 0;   // ms, client clock (wrapping)
+};
+
+struct InputStats {
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;   // malformed frames
+    uint64_t stale    = 0;   // arrived after a newer sequence number
+};
+
+// ============================================================
+// Boid Kernels
+// ============================================================
+// applyBoidRules() steps each run of same-owner boids with a kernel
+// specialized on the owner's active speed effects (bit set below), so the
+// effect tests are resolved at compile time. Stats count runs and boids
+// per variant.
+
+static constexpr uint32_t BOID_FX_BOOST = 0x1;   // boosting with fuel left
+static constexpr uint32_t BOID_FX_BURST = 0x2;   // speed burst pickup
+static constexpr uint32_t BOID_FX_SLOW  = 0x4;   // slow trap
+static constexpr int      BOID_KERNEL_VARIANTS = 8;
+
+struct BoidKernelStats {
+    uint64_t runs[BOID_KERNEL_VARIANTS]  = {};
+    uint64_t boids[BOID_KERNEL_VARIANTS] = {};
+};
+
+// ============================================================
+// SerializerStats
+// ============================================================
+
+struct SerializerStats {
+    uint64_t payloads     = 0;
+    uint64_t rawBytes     = 0;
+    uint64_t encodedBytes = 0;
+    uint64_t encodeNanos  = 0;   // time spent in the compression stage
+    // Snapshot player rows: re-encoded after a change vs. copied from cache
+    uint64_t playerRowsEncoded = 0;
+    uint64_t playerRowsReused  = 0;
+};
+
+// ============================================================
+// TickAllocStats
+// ============================================================
+// Heap allocations made on the tick thread during tick(). Per-tick
+// temporaries come from the tick arena and persistent containers keep
+// their capacity, so a warm room reports zero per tick; recording and
+// checksums (which hand buffers to the log writer) are the exception.
+
+struct TickAllocStats {
+    uint64_t lastTick        = 0;   // allocations during the last tick
+    uint64_t total           = 0;
+    uint64_t allocatingTicks = 0;   // ticks with at least one allocation
+    uint64_t quietStreak     = 0;   // consecutive ticks without any
+};
+
+// ============================================================
+// RoomCapacity
+// ============================================================
+// With maxPlayers > 0 the room reserves all of its storage for that many
+// players when it is built (boids: MAX_BOIDS_PER_PLAYER each, resources,
+// pickups, snapshot buffers, tick arena, quadtree pool) and never grows
+// the entity containers: addPlayer() refuses joins beyond the cap. That
+// makes a room's memory known up front. hugePages advises the kernel to
+// back the large reservations with transparent huge pages.
+
+struct RoomCapacity {
+    uint32_t maxPlayers = 0;    // 0 = unbounded, containers grow on demand
+    bool     hugePages  = false;
+};
+
+struct CapacityStats {
+    size_t   reservedBytes = 0;   // storage reserved up front
+    size_t   hugePageBytes = 0;   // of which advised for huge pages
+    uint64_t rejectedJoins = 0;
+    uint64_t regrowths     = 0;   // reserved buffers that still had to grow
+};
+
 // ============================================================
 // Resource
 // ============================================================
@@ -167,6 +456,12 @@ struct Resource {
     bool active = true;
 };
 
+// Engine storage: a position column plus this one (active = alive row)
+struct ResourceYield {
+    int32_t value;
+    uint8_t type;
+};
+
 // ============================================================
 // Pickup (powerups & traps on the map)
 // ============================================================
@@ -187,6 +482,53 @@ struct Pickup {
     bool active = true;
 };
 
+// Engine storage: a position column plus this one (active = alive row)
+struct PickupKind {
+    uint8_t type;
+};
+
+// Entity archetypes (entities.h). Boids keep their steering record whole:
+// the kernels read pos, vel and slot together.
+using BoidStore     = EntityStore<BoidHot>;
+using ResourceStore = EntityStore<Vec2, ResourceYield>;
+using PickupStore   = EntityStore<Vec2, PickupKind>;
+
+// ============================================================
+// Change Tracking
+// ============================================================
+// Mutating stages stamp what they touch with the change epoch: the number
+// of the tick in progress (currentTick() + 1, so changes made between
+// ticks belong to the next one). "Changed since tick T" is epoch > T.
+// Players carry one epoch per component below; entity stores stamp rows on
+// create / touch and log removals (entities.h). Boid motion is not tracked
+// (every boid moves every tick); boid rows are stamped when created or
+// scattered. Removals are kept for CHANGE_HISTORY_TICKS.
+
+enum PlayerComponent : uint32_t {
+    PLAYER_INPUT     = 1u << 0,   // cursor, last input seq / client time
+    PLAYER_MUTATIONS = 1u << 1,
+    PLAYER_SCORE     = 1u << 2,
+    PLAYER_BOOST     = 1u << 3,   // fuel, boosting
+    PLAYER_EFFECTS   = 1u << 4,   // shield / speed burst / slow timers
+    PLAYER_ALIVE     = 1u << 5,
+};
+static constexpr int      PLAYER_COMPONENT_COUNT = 6;
+static constexpr uint32_t PLAYER_ALL_COMPONENTS  = (1u << PLAYER_COMPONENT_COUNT) - 1;
+static constexpr uint32_t CHANGE_HISTORY_TICKS   = 200;   // 10s of removals
+
+struct PlayerChanges {
+    uint32_t epoch[PLAYER_COMPONENT_COUNT] = {};
+
+    // Mask of the components changed after `since`
+    uint32_t since(uint32_t tick) const {
+        uint32_t mask = 0;
+        for (int c = 0; c < PLAYER_COMPONENT_COUNT; ++c) {
+            if (epoch[c] > tick) mask |= 1u << c;
+        }
+        return mask;
+    }
+};
+
 // ============================================================
 // QuadTree
 // ============================================================
@@ -196,22 +538,42 @@ struct QTEntry {
     float x, y;
 };
 
+// Nodes live in a pool owned by the tree: clear() only rewinds it, so each
+// rebuild reuses the previous one's nodes and their object storage.
 class QuadTree {
 public:
-    QuadTree(Rect bounds, int level = 0);
+    // nodeObjects: object storage reserved per pool node
+    explicit QuadTree(Rect bounds, int nodeObjects = QUADTREE_MAX_OBJECTS);
 
     void clear();
-    void insert(const QTEntry& entry);
-    void query(const Rect& range, std::vector<QTEntry>& found) const;
+    // Split limits are the mode's (compile-time) quadtree constants
+    template <int MaxObjects, int MaxLevels>
+    void insert(const QTEntry& entry) { insert<MaxObjects, MaxLevels>(0, entry); }
+    void query(const Rect& range, ArenaVector<QTEntry>& found) const { query(0, range, found); }
+
+    size_t nodeCount() const    { return used_; }
+    size_t nodeCapacity() const { return nodes_.size(); }
+    // Pre-builds pool nodes (with object storage) up to `nodes`
+    void reserve(size_t nodes);
 
 private:
-    void subdivide();
+    struct Node {
+        Rect bounds;
+        int level = 0;
+        uint32_t firstChild = 0;   // 0 = leaf (the root is never a child)
+        std::vector<QTEntry> objects;
+    };
+
+    uint32_t makeNode(Rect bounds, int level);
+    void subdivide(uint32_t node);
+    template <int MaxObjects, int MaxLevels>
+    void insert(uint32_t node, const QTEntry& entry);
+    void query(uint32_t node, const Rect& range, ArenaVector<QTEntry>& found) const;
 
     Rect bounds_;
-    int level_;
-    std::vector<QTEntry> objects_;
-    std::unique_ptr<QuadTree> children_[4];
-    bool divided_ = false;
+    int  nodeObjects_;
+    std::vector<Node> nodes_;
+    uint32_t used_ = 0;
 };
 
 // ============================================================
@@ -220,48 +582,253 @@ private:
 
 class GameEngine {
 public:
-    GameEngine();
-
+    // seed 0 picks a random seed; any other value makes every random
+    // stream (spawns, resources, pickups, effects) reproducible
+    explicit GameEngine(uint64_t seed = 0, const RoomCapacity& capacity = {},
+                        GameMode mode = GameMode::Classic);
+    ~GameEngine();
+    uint64_t seed() const { return seed_; }
+    GameMode mode() const { return mode_; }
+    const GameModeInfo& modeInfo() const { return gameModeInfo(mode_); }
+
+    // Returns 0 (and counts a rejected join) when a capped room is full
     uint32_t addPlayer();
     void     removePlayer(uint32_t playerId);
     void     setPlayerCursor(uint32_t playerId, float x, float y);
     void     setPlayerBoost(uint32_t playerId, bool active);
 
+    // Binary input frames; thread-safe, applied at the start of the next tick.
+    // submitInputFrame() returns false if the frame fails validation.
+    bool     submitInputFrame(uint32_t playerId, const uint8_t* frame);
+    size_t   submitInputBatch(const uint8_t* records, size_t len);
+    InputStats getInputStats() const;
+    // Replay: queue an already-validated command for the next tick
+    void     injectInput(const InputCommand& cmd);
+
+    // Replay archive (format in recorder.h): an opening keyframe, then
+    // every command plus a keyframe each ARCHIVE_KEYFRAME_INTERVAL ticks
+    bool startRecording(const std::string& path, std::string& error);
+    void stopRecording();
+    const InputRecorder* recorder() const { return recorder_.get(); }
+
+    // Full world checkpoint (format next to saveState in engine.cpp).
+    // loadState() validates the whole buffer before touching the engine and
+    // leaves it unchanged on failure. The engine takes the checkpoint's mode.
+    // Archive keyframes leave out queued inputs: the log replays them.
+    std::vector<uint8_t> saveState(bool includeQueuedInputs = true) const;
+    bool loadState(const uint8_t* data, size_t len, std::string& error);
+    // New engine straight from a checkpoint (nullptr and error on failure)
+    static std::unique_ptr<GameEngine> restore(const uint8_t* data, size_t len, std::string& error,
+                                               const RoomCapacity& capacity = {});
+
+    // Determinism check (see checksum.h). With an interval N > 0 the engine
+    // hashes itself every N ticks and embeds the result in the recording.
+    StateChecksum checksum() const;
+    void setChecksumInterval(int ticks) { checksumInterval_ = std::max(ticks, 0); }
+    int  checksumInterval() const { return checksumInterval_; }
+    const StateChecksum& lastChecksum() const { return lastChecksum_; }
+
     void tick();
+    uint32_t currentTick() const { return tick_; }
     std::vector<uint8_t> serializeState() const;
-
-    const std::vector<Boid>&     getBoids()     const { return boids_; }
-    const std::vector<Resource>& getResources() const { return resources_; }
-    const std::unordered_map<uint32_t, Player>& getPlayers() const { return players_; }
+    // Encodes into an engine-owned buffer, overwritten by the next call
+    const std::vector<uint8_t>& serializeStateFor(uint32_t viewerId) const;
+    std::vector<uint8_t> serializeMinimap() const;
+
+    // Optional LZ stage applied to every outbound payload:
+    //   [uint32] rawSize, followed by an LZ block (see lz.h)
+    void setCompression(bool enabled) { compression_ = enabled; refreshKeyframe(); }
+    bool compressionEnabled() const   { return compression_; }
+    const SerializerStats& getSerializerStats() const { return serializerStats_; }
+
+    // Latest full snapshot (same format as serializeState), re-encoded every
+    // KEYFRAME_INTERVAL ticks so joins never force an encode of their own
+    // (it may predate joins and leaves since; the next broadcast has them)
+    const std::vector<uint8_t>& getKeyframe() const { return keyframe_; }
+    uint32_t keyframeTick() const { return keyframeTick_; }
+
+    // Spectator stream, always LZ-compressed regardless of setCompression()
+    void setSpectatorEnabled(bool enabled);
+    bool spectatorEnabled() const { return spectatorEnabled_; }
+    SpectatorStream& spectator() { return spectator_; }
+
+    // Full records assembled from the columns and entity stores (copies; for checks
+    // and tools, not per-tick use)
+    std::vector<Boid> getBoids() const;
+    std::unordered_map<uint32_t, Player> getPlayers() const;
+    size_t playerCount() const { return playerOrder_.size(); }
+    std::vector<Resource> getResources() const;
+    std::vector<Pickup>   getPickups() const;
+    const BoidStore&     boidStore()     const { return boids_; }
+    const ResourceStore& resourceStore() const { return resources_; }
+    const PickupStore&   pickupStore()   const { return pickups_; }
+
+    // Change tracking (see Change Tracking above)
+    uint32_t changeEpoch() const { return tick_ + 1; }
+    // Oldest T for which changes since T are complete (removals older than
+    // that were dropped, or predate the last loadState)
+    uint32_t changeHistoryStart() const;
+    // f(playerId, components) for players with a component changed after `since`
+    template <typename F>
+    void forEachPlayerChange(uint32_t since, F&& f) const {
+        for (uint32_t slot = 0; slot < (uint32_t)playerOrder_.size(); ++slot) {
+            uint32_t mask = playerChanges_[slot].since(since);
+            if (mask) f(playerOrder_[slot], mask);
+        }
+    }
+    const RemovalLog& removedPlayers() const { return removedPlayers_; }
+    const std::vector<SwarmSummary>& getSwarmSummaries() const { return swarms_; }
+
+    const TickAllocStats& getAllocStats() const { return allocStats_; }
+    const BoidKernelStats& getKernelStats() const { return kernelStats_; }
+    // Times every kernel variant on the current world (ns per boid)
+    void benchmarkKernels(int rounds, double nsPerBoid[BOID_KERNEL_VARIANTS]);
+    const RoomCapacity& capacity() const        { return capacity_; }
+    const CapacityStats& getCapacityStats() const { return capacityStats_; }
+    const TickArena& tickArena() const          { return arena_; }
+    const QuadTree& quadTree() const            { return *quadTree_; }
 
 private:
-    void spawnBoidsForPlayer(uint32_t playerId, int count);
-    void spawnResources();
-    void spawnPickups();
-    void buildQuadTree();
-    void applyBoidRules();
-    void collectResources();
-    void collectPickups();
-    void handleCombat();
-    void clampPositions();
+    GameEngine(uint64_t seed, const RoomCapacity& capacity, GameMode mode, bool prespawn);
+    // Calls f(C{}) with the config type of the room's mode
+    template <typename F> void withConfig(F&& f);
+    void reserveRoom();
+    void checkReservations();
+
+    // Simulation steps, one instantiation per mode config C
+    template <typename C> void simulate();
+    template <typename C> void spawnBoidsForPlayer(uint32_t slot, int count);
+    template <typename C> void spawnResources();
+    template <typename C> void spawnPickups();
+    template <typename C> void buildQuadTree(bool updateMinimap = false);
+    template <typename C> void applyBoidRules();
+    template <typename C, uint32_t Effects>
+    void steerBoids(uint32_t begin, uint32_t end, ArenaVector<QTEntry>& nearby);
+    using BoidKernel = void (GameEngine::*)(uint32_t, uint32_t, ArenaVector<QTEntry>&);
+    template <typename C> static BoidKernel boidKernel(uint32_t effects);
+    template <typename C> void collectResources();
+    template <typename C> void collectPickups();
+    template <typename C> void handleCombat();
+    template <typename C> void clampPositions();
     void tickPlayerEffects();
+    void computeSwarmSummaries();
+    const std::vector<uint32_t>& sortedPlayerIds() const { return playerOrder_; }
+    int  slotOf(uint32_t playerId) const;   // -1 if not in the room
+    Player playerRecord(uint32_t slot) const;
+    void spawnBoid(uint32_t slot, Vec2 pos, Vec2 vel) {
+        boids_.create(nextBoidId_++, BoidHot{pos, vel, slot});
+    }
+    // Stamps the components with the change epoch and stales the row's
+    // cached snapshot encoding
+    void markPlayer(uint32_t slot, uint32_t components);
+    void syncChangeEpoch();
+    void resetChangeTracking();   // everything changed now (new world)
+    void applyQueuedInputs();
+    void refreshKeyframe();
+    void pushSpectatorFrame();
+
+    // fullDetail: one flag per swarm. The in-place forms reuse out's capacity.
+    std::vector<uint8_t> encodeSnapshot(const std::vector<uint8_t>& fullDetail) const;
+    void encodeSnapshot(const uint8_t* fullDetail, std::vector<uint8_t>& out) const;
+    std::vector<uint8_t> packPayload(std::vector<uint8_t> raw) const;
+    std::vector<uint8_t> packPayload(std::vector<uint8_t> raw, bool compress) const;
+    void compressPayload(const std::vector<uint8_t>& raw, std::vector<uint8_t>& out) const;
+    void encodePlayerRow(uint32_t slot, uint8_t* out) const;
+    void refreshPlayerBlock() const;
+
+    template <typename C> Vec2 randomPosition(RngStream& rng);
+
+    // Players by slot: ids ascending, then the hot and cold columns
+    std::vector<uint32_t>   playerOrder_;
+    std::vector<PlayerHot>  playerHot_;
+    std::vector<PlayerCold> playerCold_;
+    std::vector<PlayerChanges> playerChanges_;
+    RemovalLog              removedPlayers_;
+    uint32_t                changeHistoryFloor_ = 0;   // tick of the last reset
+    // Entities. A stage that destroys rows sweeps them before it returns
+    BoidStore     boids_;
+    ResourceStore resources_;
+    PickupStore   pickups_;
 
-    Vec2 randomPosition() const;
+    std::unique_ptr<QuadTree> quadTree_;
 
-    std::unordered_map<uint32_t, Player> players_;
-    std::vector<Boid>     boids_;
-    std::vector<Resource> resources_;
-    std::vector<Pickup>   pickups_;
+    // Per-tick temporaries; reset at the end of every tick
+    TickArena arena_;
+    TickAllocStats allocStats_;
+    BoidKernelStats kernelStats_;
 
-    std::unique_ptr<QuadTree> quadTree_;
+    GameMode      mode_;
+    RoomCapacity  capacity_;
+    CapacityStats capacityStats_;
+    size_t reservedBoids_ = 0, reservedSnapshot_ = 0, reservedArena_ = 0, reservedNodes_ = 0;
 
+    // Swarm summaries, rebuilt at the end of every tick
+    std::vector<SwarmSummary> swarms_;
+    std::vector<uint32_t>     swarmBoidOrder_;   // boid indices grouped by swarm
+
+    std::vector<MinimapCell>  minimap_;          // MINIMAP_GRID_SIZE^2, row-major
+
+    uint32_t tick_           = 0;   // number of completed ticks
     uint32_t nextPlayerId_   = 1;
     uint32_t nextBoidId_     = 1;
     uint32_t nextResourceId_ = 1;
     uint32_t nextPickupId_   = 1;
 
+    mutable std::mutex inputMutex_;
+    std::vector<InputCommand> inputQueue_;
+    // Map extents for dequantizing input frames on network threads; kept
+    // under inputMutex_ since loadState may switch the mode
+    Vec2 inputExtent_;
+    std::vector<InputCommand> inputScratch_;
+    std::atomic<uint64_t> inputsAccepted_{0};
+    std::atomic<uint64_t> inputsRejected_{0};
+    std::atomic<uint64_t> inputsStale_{0};
+
+    bool compression_ = false;
+    mutable SerializerStats serializerStats_;
+    // Snapshot player block (PLAYER_ROW_BYTES per slot) and its per-slot
+    // stale flags, set by markPlayer; any join or leave rebuilds it whole
+    mutable std::vector<uint8_t> playerBlock_;
+    mutable std::vector<uint8_t> playerRowStale_;
+
+    std::vector<uint8_t> keyframe_;
+    uint32_t keyframeTick_ = 0;
+    bool keyframeCurrent_ = false;   // false once a join, leave or boost edits the tick's state
+    std::vector<uint8_t> encodeScratch_;   // uncompressed keyframe / spectator frame
+    // Per-viewer snapshots: detail mask, uncompressed encoding, payload
+    mutable std::vector<uint8_t> viewerDetail_;
+    mutable std::vector<uint8_t> viewerScratch_;
+    mutable std::vector<uint8_t> viewerPayload_;
+
+    bool spectatorEnabled_ = false;
+    SpectatorStream spectator_;
+
+    std::unique_ptr<InputRecorder> recorder_;
+
+    int checksumInterval_ = 0;
+    StateChecksum lastChecksum_;
+
     float resourceSpawnAccum_ = 0.0f;
     float pickupSpawnAccum_   = 0.0f;
 
-    mutable std::mt19937 rng_;
+    uint64_t  seed_;
+    RngStream rngSpawn_;
+    RngStream rngResource_;
+    RngStream rngPickup_;
+    RngStream rngEffect_;
 };
+
+// ============================================================
+// State Checksum
+// ============================================================
+// Canonical subsystem hashes behind GameEngine::checksum(), shared with
+// ReferenceEngine so both engines hash identical state identically.
+// nextIds = {player, boid, resource, pickup}; rngs = {spawn, resource,
+// pickup, effect}.
+
+uint64_t checksumWorld(uint32_t tick, const uint32_t nextIds[4],
+                       float resourceAccum, float pickupAccum, const RngStream* const rngs[4]);
+uint64_t checksumPlayers(const std::unordered_map<uint32_t, Player>& players);
+uint64_t checksumBoids(const std::vector<Boid>& boids);
+uint64_t checksumResources(const std::vector<Resource>& resources);
+uint64_t checksumPickups(const std::vector<Pickup>& pickups);
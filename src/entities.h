@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+// ============================================================
+// Removal Log
+// ============================================================
+// Ids of removed entities with the change epoch of their removal, oldest
+// first. Lets a consumer that last looked at tick T learn what went away
+// since, for as long as the owner keeps the entries (see trim()).
+
+struct EntityRemoval {
+    uint32_t id;
+    uint32_t epoch;
+};
+
+class RemovalLog {
+public:
+    void record(uint32_t id, uint32_t epoch) { entries_.push_back(EntityRemoval{id, epoch}); }
+
+    // Drops entries from epoch `upTo` and earlier (capacity is kept)
+    void trim(uint32_t upTo) {
+        auto it = std::upper_bound(entries_.begin(), entries_.end(), upTo,
+                                   [](uint32_t e, const EntityRemoval& r) { return e < r.epoch; });
+        entries_.erase(entries_.begin(), it);
+    }
+
+    void clear() { entries_.clear(); }
+    size_t size() const { return entries_.size(); }
+
+    // f(id, epoch) for removals after epoch `since`, oldest first
+    template <typename F>
+    void forEachSince(uint32_t since, F&& f) const {
+        auto it = std::upper_bound(entries_.begin(), entries_.end(), since,
+                                   [](uint32_t e, const EntityRemoval& r) { return e < r.epoch; });
+        for (; it != entries_.end(); ++it) f(it->id, it->epoch);
+    }
+
+private:
+    std::vector<EntityRemoval> entries_;
+};
+
+// ============================================================
+// Entity Store
+// ============================================================
+// Storage for one archetype: every entity of a kind has the same
+// components, kept as dense columns (one vector per component type, plus
+// the entity ids) indexed by row. Component types must be distinct.
+//
+// create() appends a row (O(1) amortized, no allocation once reserved).
+// destroy() only flags the row, O(1): the entity stays in place, reported
+// dead by alive(), until sweep() drops every flagged row in one pass per
+// column. Rows stay in creation order through a sweep (no swap-remove):
+// the simulation, checkpoints, checksums and the reference engine all walk
+// entities in that order, so it is part of the deterministic state.
+//
+// Structural changes are counted: version() moves on every create and
+// sweep, so a consumer holding a version knows whether rows came or went.
+//
+// Change epochs: the owner sets the current epoch (setEpoch); create() and
+// touch() stamp the row with it and sweep() logs each removed id with it,
+// so changedSince(row, T) and removals() answer "what changed after T"
+// without diffing. Component writes are not intercepted: a stage that
+// modifies a row in place calls touch().
+
+template <typename... Components>
+class EntityStore {
+public:
+    using Row = uint32_t;
+
+    size_t rows() const { return ids_.size(); }            // including flagged rows
+    size_t live() const { return ids_.size() - pending_; }  // O(1), no scan
+    size_t capacity() const { return ids_.capacity(); }
+    bool   alive(Row row) const { return !dead_[row]; }
+
+    Row create(uint32_t id, const Components&... components) {
+        Row row = (Row)ids_.size();
+        ids_.push_back(id);
+        dead_.push_back(0);
+        epochs_.push_back(epoch_);
+        (column<Components>().push_back(components), ...);
+        created_++;
+        version_++;
+        return row;
+    }
+
+    void destroy(Row row) {
+        if (dead_[row]) return;
+        dead_[row] = 1;
+        pending_++;
+    }
+
+    // Removes the destroyed rows, keeping the others in order; returns how
+    // many went. Row numbers past the first removed row change.
+    size_t sweep() {
+        if (pending_ == 0) return 0;
+        for (size_t i = 0; i < ids_.size(); ++i) {
+            if (dead_[i]) removals_.record(ids_[i], epoch_);
+        }
+        compact(epochs_);
+        compact(ids_);
+        (compact(column<Components>()), ...);
+        size_t removed = pending_;
+        dead_.assign(ids_.size(), 0);
+        destroyed_ += removed;
+        pending_ = 0;
+        version_++;
+        return removed;
+    }
+
+    void reserve(size_t n) {
+        ids_.reserve(n);
+        dead_.reserve(n);
+        epochs_.reserve(n);
+        (column<Components>().reserve(n), ...);
+    }
+
+    void clear() {
+        ids_.clear();
+        dead_.clear();
+        epochs_.clear();
+        removals_.clear();
+        (column<Components>().clear(), ...);
+        pending_ = 0;
+        version_++;
+    }
+
+    const std::vector<uint32_t>& ids() const { return ids_; }
+    uint32_t id(Row row) const { return ids_[row]; }
+
+    template <typename C> std::vector<C>&       column()       { return std::get<std::vector<C>>(columns_); }
+    template <typename C> const std::vector<C>& column() const { return std::get<std::vector<C>>(columns_); }
+    template <typename C> C&       get(Row row)       { return column<C>()[row]; }
+    template <typename C> const C& get(Row row) const { return column<C>()[row]; }
+
+    // f(row, Components&...) for every live row, in row order
+    template <typename F>
+    void forEach(F&& f) {
+        for (Row row = 0; row < (Row)ids_.size(); ++row) {
+            if (!dead_[row]) f(row, column<Components>()[row]...);
+        }
+    }
+    template <typename F>
+    void forEach(F&& f) const {
+        for (Row row = 0; row < (Row)ids_.size(); ++row) {
+            if (!dead_[row]) f(row, column<Components>()[row]...);
+        }
+    }
+
+    // Change epochs
+    void     setEpoch(uint32_t epoch) { epoch_ = epoch; }
+    uint32_t epoch() const { return epoch_; }
+    void     touch(Row row) { epochs_[row] = epoch_; }
+    uint32_t changedAt(Row row) const { return epochs_[row]; }
+    bool     changedSince(Row row, uint32_t since) const { return epochs_[row] > since; }
+    const RemovalLog& removals() const { return removals_; }
+    void     trimRemovals(uint32_t upTo) { removals_.trim(upTo); }
+
+    uint64_t version()   const { return version_; }
+    uint64_t created()   const { return created_; }     // rows ever created
+    uint64_t destroyed() const { return destroyed_; }   // rows ever swept
+
+private:
+    template <typename T>
+    void compact(std::vector<T>& v) {
+        size_t out = 0;
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (dead_[i]) continue;
+            if (out != i) v[out] = v[i];
+            out++;
+        }
+        v.resize(out);
+    }
+
+    std::vector<uint32_t> ids_;
+    std::vector<uint8_t>  dead_;
+    std::vector<uint32_t> epochs_;
+    std::tuple<std::vector<Components>...> columns_;
+    RemovalLog removals_;
+    uint32_t epoch_     = 0;
+    size_t   pending_   = 0;
+    uint64_t version_   = 0;
+    uint64_t created_   = 0;
+    uint64_t destroyed_ = 0;
+};
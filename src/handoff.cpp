@@ -0,0 +1,154 @@
+#include "handoff.h"
+#include "engine.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ============================================================
+// Write (old process)
+// ============================================================
+
+bool writeHandoff(const GameEngine& engine, const std::string& path, const std::string& app,
+                  HandoffStats& stats, std::string& error) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<uint8_t> state = engine.saveState();
+    stats.stateMs = msSince(t0);
+
+    auto t1 = std::chrono::steady_clock::now();
+    uint8_t header[HANDOFF_HEADER_SIZE] = {};
+    uint32_t magic = HANDOFF_MAGIC;
+    uint16_t version = HANDOFF_VERSION;
+    uint32_t tick = engine.currentTick();
+    uint32_t appSize = (uint32_t)app.size();
+    uint64_t stateSize = state.size();
+    memcpy(header, &magic, 4);
+    memcpy(header + 4, &version, 2);
+    memcpy(header + 8, &tick, 4);
+    memcpy(header + 12, &appSize, 4);
+    memcpy(header + 16, &stateSize, 8);
+
+    size_t total = HANDOFF_HEADER_SIZE + app.size() + state.size();
+    std::string tmp = path + ".tmp";
+
+#ifdef __linux__
+    int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0 || ftruncate(fd, (off_t)total) != 0) {
+        error = "handoff " + tmp + ": " + strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return false;
+    }
+    void* m = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) {
+        error = "handoff mmap: " + std::string(strerror(errno));
+        unlink(tmp.c_str());
+        return false;
+    }
+    uint8_t* out = (uint8_t*)m;
+    memcpy(out, header, HANDOFF_HEADER_SIZE);
+    memcpy(out + HANDOFF_HEADER_SIZE, app.data(), app.size());
+    memcpy(out + HANDOFF_HEADER_SIZE + app.size(), state.data(), state.size());
+    munmap(m, total);
+#else
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f.write((const char*)header, HANDOFF_HEADER_SIZE);
+        f.write(app.data(), (std::streamsize)app.size());
+        f.write((const char*)state.data(), (std::streamsize)state.size());
+        if (!f) {
+            error = "handoff " + tmp + ": write failed";
+            return false;
+        }
+    }
+#endif
+
+    // Atomic publish: the successor never sees a half-written file
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "handoff rename: " + std::string(strerror(errno));
+        std::remove(tmp.c_str());
+        return false;
+    }
+    stats.fileMs = msSince(t1);
+    stats.tick   = tick;
+    stats.bytes  = total;
+    return true;
+}
+
+// ============================================================
+// Read (successor)
+// ============================================================
+
+bool readHandoff(GameEngine& engine, const std::string& path, std::string& app,
+                 HandoffStats& stats, std::string& error) {
+    auto t0 = std::chrono::steady_clock::now();
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;   // nothing handed over
+    struct stat st;
+    void* m = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size = (size_t)st.st_size;
+        m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (m == MAP_FAILED) {
+        error = "handoff " + path + ": cannot map";
+        return false;
+    }
+    data = (const uint8_t*)m;
+#else
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    std::vector<uint8_t> owned((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    data = owned.data();
+    size = owned.size();
+#endif
+
+    bool ok = false;
+    uint32_t magic = 0, tick = 0, appSize = 0;
+    uint16_t version = 0;
+    uint64_t stateSize = 0;
+    if (size >= HANDOFF_HEADER_SIZE) {
+        memcpy(&magic, data, 4);
+        memcpy(&version, data + 4, 2);
+        memcpy(&tick, data + 8, 4);
+        memcpy(&appSize, data + 12, 4);
+        memcpy(&stateSize, data + 16, 8);
+    }
+    if (magic != HANDOFF_MAGIC || version != HANDOFF_VERSION
+        || HANDOFF_HEADER_SIZE + (uint64_t)appSize + stateSize != size) {
+        error = "handoff " + path + ": not a handoff file (or truncated)";
+    } else {
+        app.assign((const char*)data + HANDOFF_HEADER_SIZE, appSize);
+        auto t1 = std::chrono::steady_clock::now();
+        ok = engine.loadState(data + HANDOFF_HEADER_SIZE + appSize, (size_t)stateSize, error);
+        stats.stateMs = msSince(t1);
+    }
+
+#ifdef __linux__
+    munmap(m, size);
+#endif
+    // Consumed (or unusable): never resume the same room twice
+    std::remove(path.c_str());
+    stats.fileMs = msSince(t0) - stats.stateMs;
+    stats.tick   = tick;
+    stats.bytes  = size;
+    return ok;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class GameEngine;
+
+// ============================================================
+// Hot-Restart Handoff
+// ============================================================
+// Hands a running room to a successor process between two ticks. The old
+// process maps a file (tmpfs in practice, e.g. /dev/shm), copies a world
+// checkpoint (saveState, queued inputs included) and an opaque blob owned
+// by the host (server.js keeps its resume tokens there) into it, and
+// renames it into place. The successor maps it, loads the checkpoint and
+// deletes the file, so it resumes at the very next tick. Both sides are a
+// single memcpy of the checkpoint, well inside one tick at full rooms.
+//
+// File layout (little-endian):
+//   [uint32] magic 'SMHO'
+//   [uint16] version
+//   [uint16] reserved (0)
+//   [uint32] tick
+//   [uint32] app blob size
+//   [uint64] checkpoint size
+//   [bytes]  app blob
+//   [bytes]  checkpoint (format next to saveState in engine.cpp)
+
+static constexpr uint32_t HANDOFF_MAGIC       = 0x4F484D53;   // "SMHO" little-endian
+static constexpr uint16_t HANDOFF_VERSION     = 1;
+static constexpr size_t   HANDOFF_HEADER_SIZE = 24;
+
+struct HandoffStats {
+    uint32_t tick     = 0;
+    size_t   bytes    = 0;      // file size
+    double   stateMs  = 0.0;    // saveState / loadState
+    double   fileMs   = 0.0;    // map + copy + rename / map + unlink
+};
+
+bool writeHandoff(const GameEngine& engine, const std::string& path, const std::string& app,
+                  HandoffStats& stats, std::string& error);
+
+// Returns false with an empty error when there is no handoff file
+bool readHandoff(GameEngine& engine, const std::string& path, std::string& app,
+                 HandoffStats& stats, std::string& error);
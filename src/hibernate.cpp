@@ -0,0 +1,190 @@
+#include "hibernate.h"
+#include "engine.h"
+#include "lz.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+static double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ============================================================
+// Hibernate
+// ============================================================
+
+#ifdef __linux__
+// Writes and fsyncs the whole buffer; false with errno set on failure
+static bool writeDurable(const std::string& file, const std::vector<uint8_t>& data) {
+    int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    const uint8_t* p = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        p += n;
+        left -= (size_t)n;
+    }
+    bool ok = left == 0 && ::fsync(fd) == 0;
+    int saved = errno;
+    ::close(fd);
+    errno = saved;
+    return ok;
+}
+
+// Makes a rename in the file's directory durable
+static bool syncParentDir(const std::string& file) {
+    size_t slash = file.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : file.substr(0, slash);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+#endif
+
+bool hibernateEngine(const GameEngine& engine, const std::string& path,
+                     HibernateStats& stats, std::string& error) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<uint8_t> state = engine.saveState();
+
+    std::vector<uint8_t> image(HIBERNATE_HEADER_SIZE + lzCompressBound(state.size()));
+    uint32_t magic = HIBERNATE_MAGIC;
+    uint16_t version = HIBERNATE_VERSION;
+    uint32_t tick = engine.currentTick();
+    uint32_t rawSize = (uint32_t)state.size();
+    memcpy(image.data(), &magic, 4);
+    memcpy(image.data() + 4, &version, 2);
+    memcpy(image.data() + 8, &tick, 4);
+    memcpy(image.data() + 12, &rawSize, 4);
+    size_t n = lzCompress(state.data(), state.size(), image.data() + HIBERNATE_HEADER_SIZE);
+    image.resize(HIBERNATE_HEADER_SIZE + n);
+    stats.stateMs = msSince(t0);
+
+    auto t1 = std::chrono::steady_clock::now();
+    // The image becomes the room's only copy (the caller frees the engine
+    // next): never leave a partial one, and report success only once the
+    // data and the rename are on disk
+    std::string tmp = path + ".tmp";
+#ifdef __linux__
+    if (!writeDurable(tmp, image)) {
+        error = "hibernate " + tmp + ": " + std::string(strerror(errno));
+        std::remove(tmp.c_str());
+        return false;
+    }
+#else
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        f.write((const char*)image.data(), (std::streamsize)image.size());
+        f.flush();
+        if (!f) {
+            error = "hibernate " + tmp + ": write failed";
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+#endif
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        error = "hibernate rename: " + std::string(strerror(errno));
+        std::remove(tmp.c_str());
+        return false;
+    }
+#ifdef __linux__
+    if (!syncParentDir(path)) {
+        error = "hibernate sync " + path + ": " + std::string(strerror(errno));
+        return false;
+    }
+#endif
+
+    stats.fileMs   = msSince(t1);
+    stats.tick     = tick;
+    stats.rawBytes = state.size();
+    stats.bytes    = image.size();
+    return true;
+}
+
+// ============================================================
+// Wake
+// ============================================================
+
+std::unique_ptr<GameEngine> wakeEngine(const std::string& path, const RoomCapacity& capacity,
+                                       HibernateStats& stats, std::string& error) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<uint8_t> image;
+#ifdef __linux__
+    // One open/fstat/read: images are small and this is on the join path
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    bool readOk = fd >= 0 && fstat(fd, &st) == 0;
+    if (readOk) {
+        image.resize((size_t)st.st_size);
+        readOk = ::read(fd, image.data(), image.size()) == (ssize_t)image.size();
+    }
+    if (fd >= 0) ::close(fd);
+#else
+    std::ifstream f(path, std::ios::binary);
+    bool readOk = (bool)f;
+    if (readOk) image.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+#endif
+    if (!readOk) {
+        error = "wake " + path + ": no hibernation image";
+        return nullptr;
+    }
+
+    uint32_t magic = 0, tick = 0, rawSize = 0;
+    uint16_t version = 0;
+    if (image.size() >= HIBERNATE_HEADER_SIZE) {
+        memcpy(&magic, image.data(), 4);
+        memcpy(&version, image.data() + 4, 2);
+        memcpy(&tick, image.data() + 8, 4);
+        memcpy(&rawSize, image.data() + 12, 4);
+    }
+    if (magic != HIBERNATE_MAGIC || version != HIBERNATE_VERSION) {
+        error = "wake " + path + ": not a hibernation image";
+        return nullptr;
+    }
+
+    double fileMs = msSince(t0);
+
+    auto t1 = std::chrono::steady_clock::now();
+    std::vector<uint8_t> state(rawSize);
+    if (!lzDecompress(image.data() + HIBERNATE_HEADER_SIZE, image.size() - HIBERNATE_HEADER_SIZE,
+                      state.data(), state.size())) {
+        error = "wake " + path + ": corrupt image";
+        return nullptr;
+    }
+    std::unique_ptr<GameEngine> engine = GameEngine::restore(state.data(), state.size(), error, capacity);
+    if (!engine) return nullptr;
+    stats.stateMs = msSince(t1);
+
+    auto t2 = std::chrono::steady_clock::now();
+    std::remove(path.c_str());
+    stats.fileMs   = fileMs + msSince(t2);
+    stats.tick     = tick;
+    stats.rawBytes = state.size();
+    stats.bytes    = image.size();
+    return engine;
+}
+
+void releaseFreedMemory() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
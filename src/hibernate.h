@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class GameEngine;
+struct RoomCapacity;
+
+// ============================================================
+// Room Hibernation
+// ============================================================
+// An idle room is written to a compact on-disk image and its GameEngine is
+// destroyed, so the process gives the memory back; the next join wakes it
+// from the image. The image is an LZ-compressed world checkpoint: waking
+// skips the constructor's resource pre-spawn and keyframe encode, so it is
+// cheaper than a fresh GameEngine. Keep images on disk, not on tmpfs,
+// or hibernating saves nothing.
+//
+// Image layout (little-endian):
+//   [uint32] magic 'SMHI'
+//   [uint16] version
+//   [uint16] reserved (0)
+//   [uint32] tick
+//   [uint32] checkpoint size (uncompressed)
+//   [bytes]  LZ block of the checkpoint (format next to saveState in engine.cpp)
+
+static constexpr uint32_t HIBERNATE_MAGIC       = 0x49484D53;   // "SMHI" little-endian
+static constexpr uint16_t HIBERNATE_VERSION     = 1;
+static constexpr size_t   HIBERNATE_HEADER_SIZE = 16;
+
+struct HibernateStats {
+    uint32_t tick     = 0;
+    size_t   rawBytes = 0;      // checkpoint size
+    size_t   bytes    = 0;      // image size
+    double   stateMs  = 0.0;    // saveState + compress / decompress + restore
+    double   fileMs   = 0.0;    // write + rename / read + unlink
+};
+
+// Writes the image (via a temporary file and rename); the engine is untouched
+bool hibernateEngine(const GameEngine& engine, const std::string& path,
+                     HibernateStats& stats, std::string& error);
+
+// Restores the engine (with the room's capacity) and deletes the image.
+// On failure the image is kept.
+std::unique_ptr<GameEngine> wakeEngine(const std::string& path, const RoomCapacity& capacity,
+                                       HibernateStats& stats, std::string& error);
+
+// Hands freed heap pages back to the OS (glibc keeps them otherwise)
+void releaseFreedMemory();
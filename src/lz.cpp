@@ -0,0 +1,143 @@
+#include "lz.h"
+#include <cstring>
+
+static constexpr size_t LZ_MIN_MATCH     = 4;
+static constexpr size_t LZ_LAST_LITERALS = 5;   // block must end with literals
+static constexpr size_t LZ_MF_LIMIT      = 12;  // last match starts this far from the end
+static constexpr size_t LZ_MAX_OFFSET    = 65535;
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint32_t hashSeq(uint32_t v) {
+    return (v * 2654435761u) >> (32 - LZ_HASH_LOG);
+}
+
+static inline uint8_t* writeLength(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static uint8_t* writeSequence(uint8_t* op, const uint8_t* literals, size_t litLen,
+                              size_t offset, size_t matchLen, bool last) {
+    uint8_t* token = op++;
+    if (litLen >= 15) {
+        *token = 15 << 4;
+        op = writeLength(op, litLen - 15);
+    } else {
+        *token = (uint8_t)(litLen << 4);
+    }
+    memcpy(op, literals, litLen);
+    op += litLen;
+
+    if (last) return op;
+
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+
+    size_t ml = matchLen - LZ_MIN_MATCH;
+    if (ml >= 15) {
+        *token |= 15;
+        op = writeLength(op, ml - 15);
+    } else {
+        *token |= (uint8_t)ml;
+    }
+    return op;
+}
+
+size_t lzCompress(const uint8_t* src, size_t srcSize, uint8_t* dst) {
+    uint32_t table[1 << LZ_HASH_LOG] = {};
+
+    const uint8_t* ip     = src;
+    const uint8_t* anchor = src;
+    const uint8_t* end    = src + srcSize;
+    uint8_t* op = dst;
+
+    if (srcSize > LZ_MF_LIMIT) {
+        const uint8_t* matchLimit = end - LZ_LAST_LITERALS;
+        const uint8_t* ipLimit    = end - LZ_MF_LIMIT;
+
+        while (ip < ipLimit) {
+            uint32_t seq = read32(ip);
+            uint32_t h = hashSeq(seq);
+            const uint8_t* ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+
+            if (ref >= ip || (size_t)(ip - ref) > LZ_MAX_OFFSET || read32(ref) != seq) {
+                ip++;
+                continue;
+            }
+
+            const uint8_t* mp = ip + LZ_MIN_MATCH;
+            const uint8_t* rp = ref + LZ_MIN_MATCH;
+            while (mp < matchLimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+
+            op = writeSequence(op, anchor, (size_t)(ip - anchor),
+                               (size_t)(ip - ref), (size_t)(mp - ip), false);
+            ip = mp;
+            anchor = ip;
+        }
+    }
+
+    op = writeSequence(op, anchor, (size_t)(end - anchor), 0, 0, true);
+    return (size_t)(op - dst);
+}
+
+bool lzDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+    const uint8_t* ip   = src;
+    const uint8_t* iend = src + srcSize;
+    uint8_t* op   = dst;
+    uint8_t* oend = dst + dstSize;
+
+    auto readLength = [&](size_t len) -> size_t {
+        if (len != 15) return len;
+        uint8_t b;
+        do {
+            if (ip >= iend) return SIZE_MAX;
+            b = *ip++;
+            len += b;
+        } while (b == 255);
+        return len;
+    };
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t litLen = readLength(token >> 4);
+        if (litLen == SIZE_MAX || litLen > (size_t)(iend - ip) || litLen > (size_t)(oend - op)) {
+            return false;
+        }
+        memcpy(op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+
+        if (ip >= iend) break;  // last sequence has no match
+
+        if (iend - ip < 2) return false;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return false;
+
+        size_t matchLen = readLength(token & 15);
+        if (matchLen == SIZE_MAX) return false;
+        matchLen += LZ_MIN_MATCH;
+        if (matchLen > (size_t)(oend - op)) return false;
+
+        // Byte copy: matches may overlap their own output
+        const uint8_t* ref = op - offset;
+        for (size_t i = 0; i < matchLen; ++i) op[i] = ref[i];
+        op += matchLen;
+    }
+
+    return op == oend;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================
+// LZ block codec
+// ============================================================
+// Byte-compatible with the LZ4 block format (token / literals / 16-bit
+// offset / match length), single-pass greedy matcher with a 4K-entry hash
+// table. Small and fast enough to run once per shared payload on the tick
+// thread; the decoder is mirrored in public/app.js.
+
+static constexpr int LZ_HASH_LOG = 12;
+
+// Worst-case compressed size for srcSize input bytes
+inline size_t lzCompressBound(size_t srcSize) {
+    return srcSize + srcSize / 255 + 16;
+}
+
+// Compresses src into dst (which must hold lzCompressBound(srcSize) bytes).
+// Returns the number of bytes written.
+size_t lzCompress(const uint8_t* src, size_t srcSize, uint8_t* dst);
+
+// Decompresses exactly dstSize bytes. Returns false on malformed input.
+bool lzDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
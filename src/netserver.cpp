@@ -0,0 +1,492 @@
+#include "netserver.h"
+#include "engine.h"
+#include <cstring>
+#include <cctype>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+// ============================================================
+// SHA-1 / Base64 (handshake only)
+// ============================================================
+
+static void sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    std::vector<uint8_t> msg(data, data + len);
+    uint64_t bitLen = (uint64_t)len * 8;
+    msg.push_back(0x80);
+    while (msg.size() % 64 != 56) msg.push_back(0);
+    for (int shift = 56; shift >= 0; shift -= 8) msg.push_back((uint8_t)(bitLen >> shift));
+
+    auto rol = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const uint8_t* p = &msg[chunk + i * 4];
+            w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+        }
+        for (int i = 16; i < 80; ++i) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        out[i * 4 + 0] = (uint8_t)(h[i] >> 24);
+        out[i * 4 + 1] = (uint8_t)(h[i] >> 16);
+        out[i * 4 + 2] = (uint8_t)(h[i] >> 8);
+        out[i * 4 + 3] = (uint8_t)(h[i]);
+    }
+}
+
+static std::string base64(const uint8_t* data, size_t len) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) v |= data[i + 2];
+        out += alphabet[(v >> 18) & 63];
+        out += alphabet[(v >> 12) & 63];
+        out += (i + 1 < len) ? alphabet[(v >> 6) & 63] : '=';
+        out += (i + 2 < len) ? alphabet[v & 63] : '=';
+    }
+    return out;
+}
+
+std::string wsAcceptKey(const std::string& clientKey) {
+    std::string s = clientKey + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t digest[20];
+    sha1((const uint8_t*)s.data(), s.size(), digest);
+    return base64(digest, 20);
+}
+
+static WsFrame rawBytes(const std::string& s) {
+    return std::make_shared<std::vector<uint8_t>>(s.begin(), s.end());
+}
+
+// Case-insensitive header lookup in a raw HTTP request
+static std::string headerValue(const std::string& req, const char* name) {
+    size_t nameLen = strlen(name);
+    size_t pos = req.find("\r\n");
+    while (pos != std::string::npos && pos + 2 < req.size()) {
+        size_t lineStart = pos + 2;
+        size_t lineEnd = req.find("\r\n", lineStart);
+        if (lineEnd == std::string::npos) break;
+        if (lineEnd - lineStart > nameLen && req[lineStart + nameLen] == ':') {
+            bool match = true;
+            for (size_t i = 0; i < nameLen; ++i) {
+                if (tolower((unsigned char)req[lineStart + i]) != tolower((unsigned char)name[i])) {
+                    match = false;
+                    break;
+                }
+            }
+            if (match) {
+                size_t v = lineStart + nameLen + 1;
+                while (v < lineEnd && (req[v] == ' ' || req[v] == '\t')) v++;
+                size_t e = lineEnd;
+                while (e > v && (req[e - 1] == ' ' || req[e - 1] == '\t')) e--;
+                return req.substr(v, e - v);
+            }
+        }
+        pos = lineEnd;
+    }
+    return "";
+}
+
+static bool containsToken(std::string value, const char* token) {
+    for (auto& ch : value) ch = (char)tolower((unsigned char)ch);
+    return value.find(token) != std::string::npos;
+}
+
+// ============================================================
+// NativeServer Implementation
+// ============================================================
+
+static constexpr uint64_t LISTEN_TAG = UINT64_MAX;
+static constexpr uint64_t WAKE_TAG   = UINT64_MAX - 1;
+
+NativeServer::NativeServer(GameEngine* engine, SenderPool* sender, const NativeServerConfig& config)
+    : engine_(engine), sender_(sender), config_(config) {}
+
+NativeServer::~NativeServer() {
+    stop();
+}
+
+#ifdef __linux__
+
+bool NativeServer::start(std::string& error) {
+    listenFd_ = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        error = std::string("socket: ") + strerror(errno);
+        return false;
+    }
+    int one = 1, zero = 0;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(listenFd_, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+
+    sockaddr_in6 addr{};
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(config_.port);
+    if (bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd_, 512) < 0) {
+        error = std::string("bind/listen: ") + strerror(errno);
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = LISTEN_TAG;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &ev);
+    ev.data.u64 = WAKE_TAG;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+
+    running_ = true;
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void NativeServer::stop() {
+    if (!running_) return;
+    running_ = false;
+    uint64_t one = 1;
+    (void)!write(wakeFd_, &one, sizeof(one));
+    if (thread_.joinable()) thread_.join();
+
+    for (auto& [id, c] : conns_) sender_->removeConnection(id);
+    conns_.clear();
+    close(listenFd_);
+    close(wakeFd_);
+    close(epollFd_);
+    listenFd_ = epollFd_ = wakeFd_ = -1;
+}
+
+void NativeServer::run() {
+    epoll_event events[128];
+    while (running_) {
+        int n = epoll_wait(epollFd_, events, 128, -1);
+        if (n < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < n; ++i) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == LISTEN_TAG) {
+                acceptAll();
+            } else if (tag == WAKE_TAG) {
+                uint64_t v;
+                (void)!read(wakeFd_, &v, sizeof(v));
+            } else {
+                auto it = conns_.find((uint32_t)tag);
+                if (it == conns_.end()) continue;
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    closeConnection(it->first);
+                } else {
+                    onReadable(it->second);
+                }
+            }
+        }
+    }
+}
+
+void NativeServer::acceptAll() {
+    while (true) {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        Connection c;
+        c.fd = fd;
+        c.id = nextConnId_++;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = c.id;
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev);
+
+        // The sender pool owns the fd from here on (and closes it)
+        sender_->addConnection(c.id, fd);
+        conns_[c.id] = std::move(c);
+    }
+}
+
+void NativeServer::onReadable(Connection& c) {
+    uint8_t buf[4096];
+    while (true) {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            c.inbuf.insert(c.inbuf.end(), buf, buf + n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0 && errno == EINTR) continue;
+        closeConnection(c.id);   // EOF or hard error
+        return;
+    }
+
+    bool ok = (c.state == ConnState::Handshake) ? handleHandshake(c) : true;
+    if (ok && c.state == ConnState::Open) ok = handleFrames(c);
+    if (!ok) closeConnection(c.id);
+}
+
+bool NativeServer::handleHandshake(Connection& c) {
+    static const uint8_t terminator[] = {'\r', '\n', '\r', '\n'};
+    auto end = std::search(c.inbuf.begin(), c.inbuf.end(), terminator, terminator + 4);
+    if (end == c.inbuf.end()) return c.inbuf.size() <= NATIVE_MAX_HANDSHAKE;
+
+    std::string req(c.inbuf.begin(), end + 2);
+    c.inbuf.erase(c.inbuf.begin(), end + 4);
+
+    std::string key = headerValue(req, "Sec-WebSocket-Key");
+    bool valid = req.compare(0, 4, "GET ") == 0
+        && containsToken(headerValue(req, "Upgrade"), "websocket")
+        && containsToken(headerValue(req, "Connection"), "upgrade")
+        && headerValue(req, "Sec-WebSocket-Version") == "13"
+        && !key.empty();
+
+    if (!valid) {
+        sender_->send(c.id, rawBytes("HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n"));
+        return false;
+    }
+
+    sender_->send(c.id, rawBytes(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: " + wsAcceptKey(key) + "\r\n\r\n"));
+
+    // GET /spectate joins the delayed spectator stream instead of the game
+    size_t pathEnd = req.find_first_of(" ?", 4);
+    bool spectate = req.compare(4, pathEnd - 4, "/spectate") == 0;
+
+    c.state = ConnState::Open;
+    openConnections_++;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.push_back({spectate ? EventType::Spectate : EventType::Join, c.id});
+    }
+    return true;
+}
+
+bool NativeServer::handleFrames(Connection& c) {
+    size_t pos = 0;
+    bool ok = true;
+
+    while (ok) {
+        size_t avail = c.inbuf.size() - pos;
+        if (avail < 2) break;
+        const uint8_t* p = c.inbuf.data() + pos;
+
+        bool fin = (p[0] & 0x80) != 0;
+        uint8_t opcode = p[0] & 0x0F;
+        bool masked = (p[1] & 0x80) != 0;
+        uint64_t len = p[1] & 0x7F;
+        size_t hdr = 2;
+
+        if (!masked) { ok = false; break; }   // clients must mask (RFC 6455 5.1)
+        if (len == 126) {
+            if (avail < 4) break;
+            len = ((uint64_t)p[2] << 8) | p[3];
+            hdr = 4;
+        } else if (len == 127) {
+            if (avail < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; ++i) len = (len << 8) | p[2 + i];
+            hdr = 10;
+        }
+        if (len > NATIVE_MAX_MESSAGE) { ok = false; break; }
+        if (avail < hdr + 4 + len) break;
+
+        const uint8_t* mask = p + hdr;
+        uint8_t* payload = c.inbuf.data() + pos + hdr + 4;
+        for (size_t i = 0; i < len; ++i) payload[i] ^= mask[i & 3];
+        pos += hdr + 4 + len;
+
+        if (opcode >= 0x8) {
+            // Control frames are never fragmented and may interleave
+            ok = handleMessage(c, opcode, payload, (size_t)len);
+            continue;
+        }
+
+        if (opcode != WS_OP_CONTINUATION) {
+            c.message.clear();
+            c.messageOpcode = opcode;
+        }
+        if (c.message.size() + len > NATIVE_MAX_MESSAGE) { ok = false; break; }
+        if (fin && c.message.empty()) {
+            ok = handleMessage(c, c.messageOpcode, payload, (size_t)len);
+        } else {
+            c.message.insert(c.message.end(), payload, payload + len);
+            if (fin) {
+                ok = handleMessage(c, c.messageOpcode, c.message.data(), c.message.size());
+                c.message.clear();
+            }
+        }
+    }
+
+    c.inbuf.erase(c.inbuf.begin(), c.inbuf.begin() + std::min(pos, c.inbuf.size()));
+    return ok;
+}
+
+bool NativeServer::handleMessage(Connection& c, uint8_t opcode, const uint8_t* data, size_t len) {
+    switch (opcode) {
+        case WS_OP_CLOSE:
+            sender_->send(c.id, buildWsFrame(WS_OP_CLOSE, data, std::min<size_t>(len, 2)));
+            return false;
+        case WS_OP_PING:
+            sender_->send(c.id, buildWsFrame(WS_OP_PONG, data, len));
+            return true;
+        case WS_OP_PONG:
+        case WS_OP_TEXT:
+            return true;
+        case WS_OP_BINARY:
+            break;
+        default:
+            return false;
+    }
+
+    if (len == 0 || len % INPUT_FRAME_SIZE != 0) return true;
+    uint32_t pid = playerOf(c.id);
+    if (pid == 0) return true;   // join not applied yet
+
+    for (size_t off = 0; off < len; off += INPUT_FRAME_SIZE) {
+        engine_->submitInputFrame(pid, data + off);
+    }
+    return true;
+}
+
+void NativeServer::closeConnection(uint32_t connId) {
+    auto it = conns_.find(connId);
+    if (it == conns_.end()) return;
+
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    if (it->second.state == ConnState::Open) {
+        openConnections_--;
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.push_back({EventType::Leave, connId});
+    }
+    sender_->removeConnection(connId);
+    conns_.erase(it);
+}
+
+#else  // !__linux__
+
+bool NativeServer::start(std::string& error) {
+    error = "native server requires Linux (epoll)";
+    return false;
+}
+void NativeServer::stop() {}
+void NativeServer::run() {}
+void NativeServer::acceptAll() {}
+void NativeServer::onReadable(Connection&) {}
+bool NativeServer::handleHandshake(Connection&) { return false; }
+bool NativeServer::handleFrames(Connection&) { return false; }
+bool NativeServer::handleMessage(Connection&, uint8_t, const uint8_t*, size_t) { return false; }
+void NativeServer::closeConnection(uint32_t) {}
+
+#endif
+
+uint32_t NativeServer::playerOf(uint32_t connId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = connPlayer_.find(connId);
+    return it != connPlayer_.end() ? it->second : 0;
+}
+
+void NativeServer::pump() {
+    std::vector<ConnEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events.swap(events_);
+    }
+
+    for (auto& ev : events) {
+        if (ev.type == EventType::Join) {
+            uint32_t pid = engine_->addPlayer();
+            if (pid == 0) {
+                // Capped room is full: tell the client, never map or subscribe
+                // it, and close once both frames are out (as socket.io's
+                // disconnect does). 1013 = try again later.
+                static const std::string full = "{\"type\":\"full\"}";
+                static const uint8_t tryAgainLater[2] = {0x03, 0xF5};
+                sender_->send(ev.connId, buildWsFrame(WS_OP_TEXT, (const uint8_t*)full.data(), full.size()));
+                sender_->send(ev.connId, buildWsFrame(WS_OP_CLOSE, tryAgainLater, 2));
+                sender_->closeAfterFlush(ev.connId);
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                connPlayer_[ev.connId] = pid;
+            }
+            std::string init =
+                "{\"type\":\"init\",\"playerId\":" + std::to_string(pid) +
+                ",\"mapWidth\":" + std::to_string((int)engine_->modeInfo().mapWidth) +
+                ",\"mapHeight\":" + std::to_string((int)engine_->modeInfo().mapHeight) +
+                ",\"tickRate\":" + std::to_string(config_.tickRate) +
+                ",\"compressed\":" + (engine_->compressionEnabled() ? "true" : "false") + "}";
+            sender_->send(ev.connId, buildWsFrame(WS_OP_TEXT, (const uint8_t*)init.data(), init.size()));
+
+            // Cached keyframe so the client renders before the next broadcast
+            sender_->send(ev.connId, channelFrame(NATIVE_CH_STATE, engine_->getKeyframe()));
+            sender_->subscribe(ev.connId, SENDER_GROUP_PLAYERS);
+        } else if (ev.type == EventType::Spectate) {
+            // No player: spectators only ever receive the shared spectator frame
+            std::string init =
+                "{\"type\":\"init\",\"playerId\":0,\"spectator\":true"
+                ",\"mapWidth\":" + std::to_string((int)engine_->modeInfo().mapWidth) +
+                ",\"mapHeight\":" + std::to_string((int)engine_->modeInfo().mapHeight) +
+                ",\"tickRate\":" + std::to_string(std::max(1, config_.tickRate / SPECTATOR_INTERVAL)) +
+                ",\"compressed\":true}";
+            sender_->send(ev.connId, buildWsFrame(WS_OP_TEXT, (const uint8_t*)init.data(), init.size()));
+
+            const std::vector<uint8_t>& latest = engine_->spectator().latest();
+            if (!latest.empty()) sender_->send(ev.connId, channelFrame(NATIVE_CH_STATE, latest));
+            sender_->subscribe(ev.connId, SENDER_GROUP_SPECTATORS);
+        } else {
+            uint32_t pid = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = connPlayer_.find(ev.connId);
+                if (it != connPlayer_.end()) {
+                    pid = it->second;
+                    connPlayer_.erase(it);
+                }
+            }
+            if (pid) engine_->removePlayer(pid);
+        }
+    }
+}
+
+void NativeServer::broadcast(uint8_t channel, const std::vector<uint8_t>& payload, uint8_t group) {
+    sender_->broadcast(channelFrame(channel, payload), group);
+}
+
+WsFrame NativeServer::channelFrame(uint8_t channel, const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> msg(payload.size() + 1);
+    msg[0] = channel;
+    memcpy(msg.data() + 1, payload.data(), payload.size());
+    return buildWsFrame(WS_OP_BINARY, msg.data(), msg.size());
+}
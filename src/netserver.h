@@ -0,0 +1,116 @@
+#pragma once
+
+#include "broadcast.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+
+class GameEngine;
+
+// ============================================================
+// NativeServer
+// ============================================================
+// Optional epoll front end that replaces express + socket.io on the hot
+// path. One network thread accepts connections, performs the HTTP upgrade
+// and decodes client frames; cursor/boost inputs go straight into the
+// engine's input queue. Outbound traffic goes through the SenderPool.
+//
+// Joins and leaves touch engine state, so they are only queued here and
+// applied by pump(), which must run on the engine (JS) thread.
+//
+// Wire protocol (after the RFC 6455 upgrade):
+//   server -> client text:   {"type":"init", playerId, mapWidth, mapHeight, tickRate, compressed}
+//                            (spectators: playerId 0, "spectator":true, always compressed)
+//   server -> client binary: [uint8 channel] + payload (NATIVE_CH_STATE / NATIVE_CH_MINIMAP)
+//   client -> server binary: one or more input frames (INPUT_FRAME_SIZE each,
+//                            format documented next to serializeState)
+//
+// Connections that upgrade on GET /spectate become spectators: no player,
+// inputs ignored, subscribed to SENDER_GROUP_SPECTATORS.
+
+static constexpr uint8_t NATIVE_CH_STATE   = 1;
+static constexpr uint8_t NATIVE_CH_MINIMAP = 2;
+
+static constexpr size_t NATIVE_MAX_HANDSHAKE = 8192;  // bytes of HTTP request headers
+static constexpr size_t NATIVE_MAX_MESSAGE   = 4096;  // bytes per client message
+
+struct NativeServerConfig {
+    uint16_t port       = 3002;
+    int      sendThreads = 2;
+    int      tickRate    = 20;
+};
+
+class NativeServer {
+public:
+    NativeServer(GameEngine* engine, SenderPool* sender, const NativeServerConfig& config);
+    ~NativeServer();
+
+    bool start(std::string& error);
+    void stop();
+
+    // Engine thread: apply pending joins/leaves, send init messages
+    void pump();
+
+    // Engine thread: one frame, shared by every connection in the group
+    void broadcast(uint8_t channel, const std::vector<uint8_t>& payload,
+                   uint8_t group = SENDER_GROUP_PLAYERS);
+
+    uint32_t connectionCount() const { return openConnections_.load(); }
+
+private:
+    enum class ConnState : uint8_t { Handshake, Open, Closing };
+
+    struct Connection {
+        int fd = -1;
+        uint32_t id = 0;
+        ConnState state = ConnState::Handshake;
+        std::vector<uint8_t> inbuf;
+        std::vector<uint8_t> message;   // reassembly of fragmented messages
+        uint8_t messageOpcode = 0;
+    };
+
+    enum class EventType : uint8_t { Join, Spectate, Leave };
+    struct ConnEvent {
+        EventType type;
+        uint32_t connId;
+    };
+
+    void run();
+    void acceptAll();
+    void onReadable(Connection& c);
+    bool handleHandshake(Connection& c);
+    bool handleFrames(Connection& c);
+    bool handleMessage(Connection& c, uint8_t opcode, const uint8_t* data, size_t len);
+    void closeConnection(uint32_t connId);
+
+    uint32_t playerOf(uint32_t connId);
+    static WsFrame channelFrame(uint8_t channel, const std::vector<uint8_t>& payload);
+
+    GameEngine* engine_;
+    SenderPool* sender_;
+    NativeServerConfig config_;
+
+    int listenFd_ = -1;
+    int epollFd_  = -1;
+    int wakeFd_   = -1;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    // Network thread only
+    std::unordered_map<uint32_t, Connection> conns_;
+    uint32_t nextConnId_ = 1;
+
+    // Shared with the engine thread
+    std::mutex mutex_;
+    std::vector<ConnEvent> events_;
+    std::unordered_map<uint32_t, uint32_t> connPlayer_;  // connId -> playerId
+
+    std::atomic<uint32_t> openConnections_{0};
+};
+
+// Sec-WebSocket-Accept value for a client's Sec-WebSocket-Key
+std::string wsAcceptKey(const std::string& clientKey);
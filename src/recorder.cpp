@@ -0,0 +1,215 @@
+#include "recorder.h"
+#include "lz.h"
+#include <cerrno>
+#include <cstring>
+
+// ============================================================
+// InputRecorder
+// ============================================================
+
+InputRecorder::~InputRecorder() {
+    if (file_) close(lastTick_);
+}
+
+bool InputRecorder::open(const std::string& path, uint64_t seed, std::string& error) {
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        error = "input log " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    uint8_t header[REC_HEADER_SIZE] = {};
+    uint32_t magic = REC_MAGIC;
+    uint16_t version = REC_VERSION;
+    memcpy(header, &magic, 4);
+    memcpy(header + 4, &version, 2);
+    memcpy(header + 8, &seed, 8);
+    active_.assign(header, header + REC_HEADER_SIZE);
+
+    lastTick_ = 0;
+    fileOffset_ = 0;
+    index_.clear();
+    stop_ = false;
+    thread_ = std::thread(&InputRecorder::run, this);
+    return true;
+}
+
+void InputRecorder::close(uint32_t endTick) {
+    if (!file_) return;
+
+    uint8_t type = REC_END;
+    putBytes(&type, 1);
+    putBytes(&endTick, 4);
+    activeRecords_++;
+    commit();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+
+    // Writer is gone: the index and offsets are ours now
+    uint64_t indexOffset = fileOffset_;
+    for (const IndexEntry& e : index_) {
+        fwrite(&e.tick, 4, 1, file_);
+        fwrite(&e.offset, 8, 1, file_);
+    }
+    uint32_t count = (uint32_t)index_.size();
+    uint32_t magic = REC_INDEX_MAGIC;
+    fwrite(&indexOffset, 8, 1, file_);
+    fwrite(&count, 4, 1, file_);
+    fwrite(&firstTick_, 4, 1, file_);
+    fwrite(&endTick, 4, 1, file_);
+    fwrite(&magic, 4, 1, file_);
+
+    fclose(file_);
+    file_ = nullptr;
+}
+
+void InputRecorder::begin(uint32_t tick, RecordType type) {
+    if (tick != lastTick_) {
+        uint8_t t = REC_TICK;
+        putBytes(&t, 1);
+        putVarint(tick - lastTick_);
+        lastTick_ = tick;
+    }
+    uint8_t t = type;
+    putBytes(&t, 1);
+    activeRecords_++;
+}
+
+void InputRecorder::putVarint(uint32_t v) {
+    while (v >= 0x80) {
+        active_.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    active_.push_back((uint8_t)v);
+}
+
+void InputRecorder::putBytes(const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    active_.insert(active_.end(), p, p + len);
+}
+
+void InputRecorder::join(uint32_t tick, uint32_t playerId) {
+    begin(tick, REC_JOIN);
+    putVarint(playerId);
+}
+
+void InputRecorder::leave(uint32_t tick, uint32_t playerId) {
+    begin(tick, REC_LEAVE);
+    putVarint(playerId);
+}
+
+void InputRecorder::cursor(uint32_t tick, uint32_t playerId, float x, float y) {
+    begin(tick, REC_CURSOR);
+    putVarint(playerId);
+    putBytes(&x, 4);
+    putBytes(&y, 4);
+}
+
+void InputRecorder::boost(uint32_t tick, uint32_t playerId, bool active) {
+    begin(tick, REC_BOOST);
+    putVarint(playerId);
+    uint8_t a = active ? 1 : 0;
+    putBytes(&a, 1);
+}
+
+void InputRecorder::input(uint32_t tick, const InputCommand& cmd) {
+    begin(tick, REC_INPUT);
+    putVarint(cmd.playerId);
+    putBytes(&cmd.seq, 2);
+    putBytes(&cmd.x, 4);
+    putBytes(&cmd.y, 4);
+    uint8_t b = cmd.boost ? 1 : 0;
+    putBytes(&b, 1);
+    putBytes(&cmd.clientTime, 4);
+}
+
+void InputRecorder::checksum(const StateChecksum& sum) {
+    begin(sum.tick, REC_CHECKSUM);
+    putBytes(sum.part, sizeof(sum.part));
+}
+
+void InputRecorder::keyframe(uint32_t tick, std::vector<uint8_t> state) {
+    // Records so far precede the keyframe in the file
+    commit();
+
+    if (stats().keyframes == 0) firstTick_ = tick;
+    lastTick_ = tick;   // REC_TICK deltas restart from the keyframe
+
+    Chunk c;
+    c.data = std::move(state);
+    c.keyframe = true;
+    c.tick = tick;
+    c.records = 1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.keyframes++;
+        pending_.push_back(std::move(c));
+    }
+    cv_.notify_one();
+}
+
+void InputRecorder::commit() {
+    if (!file_ || active_.empty()) return;
+
+    Chunk c;
+    c.data.swap(active_);
+    c.records = activeRecords_;
+    activeRecords_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(c));
+    }
+    cv_.notify_one();
+}
+
+RecorderStats InputRecorder::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void InputRecorder::writeChunk(const Chunk& c) {
+    size_t written = 0;
+    if (!c.keyframe) {
+        written = fwrite(c.data.data(), 1, c.data.size(), file_);
+    } else {
+        index_.push_back({c.tick, fileOffset_});
+
+        // [type][tick][length] then the payload: [rawSize][LZ block]
+        std::vector<uint8_t> rec(13 + lzCompressBound(c.data.size()));
+        uint32_t rawSize = (uint32_t)c.data.size();
+        size_t n = lzCompress(c.data.data(), c.data.size(), rec.data() + 13);
+        uint32_t length = (uint32_t)(4 + n);
+        rec[0] = REC_KEYFRAME;
+        memcpy(rec.data() + 1, &c.tick, 4);
+        memcpy(rec.data() + 5, &length, 4);
+        memcpy(rec.data() + 9, &rawSize, 4);
+        rec.resize(13 + n);
+        written = fwrite(rec.data(), 1, rec.size(), file_);
+    }
+    fileOffset_ += written;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.records += c.records;
+    stats_.bytes   += written;
+    stats_.writes++;
+}
+
+void InputRecorder::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+        if (pending_.empty() && stop_) break;
+
+        writing_.swap(pending_);
+        lock.unlock();
+        for (const Chunk& c : writing_) writeChunk(c);
+        fflush(file_);
+        writing_.clear();
+        lock.lock();
+    }
+}
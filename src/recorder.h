@@ -0,0 +1,152 @@
+#pragma once
+
+#include "engine.h"
+#include <condition_variable>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ============================================================
+// Replay Archive Format
+// ============================================================
+// Periodic full-state keyframes interleaved with every state-changing
+// command, in the order the engine applied them, plus a trailing keyframe
+// index. Any tick can be rebuilt by loading the nearest keyframe at or
+// before it and re-simulating the commands that follow (see replay.h).
+//
+// Header (16 bytes):
+//   [uint32] magic 'SMRL'
+//   [uint16] version
+//   [uint16] reserved (0)
+//   [uint64] engine seed
+//
+// Records, each [uint8 type] + fields (varint = unsigned LEB128):
+//   REC_TICK     [varint ticks since the previous REC_TICK/REC_KEYFRAME]
+//                — commands that follow were applied before/at the start
+//                of that tick
+//   REC_JOIN     [varint playerId]
+//   REC_LEAVE    [varint playerId]
+//   REC_CURSOR   [varint playerId][float32 x][float32 y]
+//   REC_BOOST    [varint playerId][uint8 active]
+//   REC_INPUT    [varint playerId][uint16 seq][float32 x][float32 y]
+//                [uint8 boost][uint32 clientTime]  — drained input frame
+//   REC_END      [uint32 total ticks]  — written by a clean stop
+//   REC_KEYFRAME [uint32 tick][uint32 length][payload]  — world checkpoint
+//                (saveState without queued inputs) in the compressed
+//                payload layout: [uint32 rawSize][LZ block]
+//   REC_CHECKSUM [uint64 x CHK_PART_COUNT]  — StateChecksum of the state
+//                at the tagged tick (engine checksum interval; see
+//                checksum.h)
+//
+// The first record is always a keyframe, so recording can start at any
+// tick. A keyframe at tick T is the state after T ticks, before any
+// command tagged T.
+//
+// Trailing index (written by a clean stop, after REC_END):
+//   [uint32 tick][uint64 record offset] per keyframe
+//   footer (24 bytes): [uint64 index offset][uint32 keyframes]
+//                      [uint32 first tick][uint32 end tick][uint32 'SMRX']
+// A log without a footer (crash) is still readable by scanning.
+
+static constexpr uint32_t REC_MAGIC        = 0x4C524D53;   // "SMRL" little-endian
+static constexpr uint16_t REC_VERSION      = 3;   // 2 = no checksums
+static constexpr size_t   REC_HEADER_SIZE  = 16;
+static constexpr uint32_t REC_INDEX_MAGIC  = 0x58524D53;   // "SMRX"
+static constexpr size_t   REC_FOOTER_SIZE  = 24;
+static constexpr size_t   REC_INDEX_ENTRY  = 12;
+static constexpr uint32_t REC_KEYFRAME_MAX_RAW = 256u << 20;   // decoded checkpoint sanity cap
+
+static constexpr int ARCHIVE_KEYFRAME_INTERVAL = 200;   // ticks between keyframes (10s)
+
+enum RecordType : uint8_t {
+    REC_TICK     = 0,
+    REC_JOIN     = 1,
+    REC_LEAVE    = 2,
+    REC_CURSOR   = 3,
+    REC_BOOST    = 4,
+    REC_INPUT    = 5,
+    REC_END      = 6,
+    REC_KEYFRAME = 7,
+    REC_CHECKSUM = 8
+};
+
+struct RecorderStats {
+    uint64_t records   = 0;
+    uint64_t bytes     = 0;   // bytes written to the file
+    uint64_t writes    = 0;   // chunks written by the writer thread
+    uint32_t keyframes = 0;
+};
+
+// ============================================================
+// InputRecorder
+// ============================================================
+// The tick thread only appends to an in-memory buffer; commit() at the end
+// of each tick hands it to the writer thread, and keyframe() hands over a
+// raw checkpoint. Compression, file I/O and index bookkeeping all happen
+// on the writer thread. Nothing is dropped: if the disk is slow the
+// pending queue simply grows until the writer catches up.
+
+class InputRecorder {
+public:
+    InputRecorder() = default;
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    bool open(const std::string& path, uint64_t seed, std::string& error);
+    // Writes REC_END and the keyframe index, drains the writer, closes
+    void close(uint32_t endTick);
+
+    void join(uint32_t tick, uint32_t playerId);
+    void leave(uint32_t tick, uint32_t playerId);
+    void cursor(uint32_t tick, uint32_t playerId, float x, float y);
+    void boost(uint32_t tick, uint32_t playerId, bool active);
+    void input(uint32_t tick, const InputCommand& cmd);
+    void checksum(const StateChecksum& sum);
+
+    // Tick thread: checkpoint taken after `tick` ticks (uncompressed)
+    void keyframe(uint32_t tick, std::vector<uint8_t> state);
+
+    // Tick thread, once per tick: hand buffered records to the writer
+    void commit();
+
+    RecorderStats stats() const;
+
+private:
+    struct Chunk {
+        std::vector<uint8_t> data;
+        bool     keyframe = false;
+        uint32_t tick     = 0;
+        uint64_t records  = 0;
+    };
+    struct IndexEntry {
+        uint32_t tick;
+        uint64_t offset;
+    };
+
+    void begin(uint32_t tick, RecordType type);
+    void putVarint(uint32_t v);
+    void putBytes(const void* data, size_t len);
+    void run();
+    void writeChunk(const Chunk& c);
+
+    FILE* file_ = nullptr;
+    std::vector<uint8_t> active_;     // tick thread
+    uint64_t activeRecords_ = 0;
+    uint32_t lastTick_  = 0;
+    uint32_t firstTick_ = 0;
+
+    std::vector<Chunk> pending_;      // guarded by mutex_
+    std::vector<Chunk> writing_;      // writer thread
+    uint64_t fileOffset_ = 0;         // writer thread
+    std::vector<IndexEntry> index_;   // writer thread
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+
+    RecorderStats stats_;             // guarded by mutex_
+};
@@ -0,0 +1,589 @@
+#include "reference_engine.h"
+
+// ============================================================
+// Reference QuadTree
+// ============================================================
+// Same subdivision rules and query order as the original QuadTree; the
+// query order feeds float sums, so it is part of the reference behaviour.
+
+class ReferenceEngine::Tree {
+public:
+    Tree(Rect bounds, int level = 0) : bounds_(bounds), level_(level) {}
+
+    void clear() {
+        objects_.clear();
+        for (auto& c : children_) c.reset();
+        divided_ = false;
+    }
+
+    void insert(const QTEntry& entry) {
+        if (!bounds_.contains(entry.x, entry.y)) return;
+
+        if ((int)objects_.size() < QUADTREE_MAX_OBJECTS || level_ >= QUADTREE_MAX_LEVELS) {
+            objects_.push_back(entry);
+            return;
+        }
+
+        if (!divided_) {
+            float hw = bounds_.w * 0.5f;
+            float hh = bounds_.h * 0.5f;
+            float x  = bounds_.x;
+            float y  = bounds_.y;
+            children_[0] = std::make_unique<Tree>(Rect{x,      y,      hw, hh}, level_ + 1);
+            children_[1] = std::make_unique<Tree>(Rect{x + hw, y,      hw, hh}, level_ + 1);
+            children_[2] = std::make_unique<Tree>(Rect{x,      y + hh, hw, hh}, level_ + 1);
+            children_[3] = std::make_unique<Tree>(Rect{x + hw, y + hh, hw, hh}, level_ + 1);
+            divided_ = true;
+        }
+
+        for (auto& c : children_) c->insert(entry);
+    }
+
+    void query(const Rect& range, std::vector<QTEntry>& found) const {
+        if (!bounds_.intersects(range)) return;
+
+        for (auto& obj : objects_) {
+            if (range.contains(obj.x, obj.y)) found.push_back(obj);
+        }
+        if (divided_) {
+            for (auto& c : children_) c->query(range, found);
+        }
+    }
+
+private:
+    Rect bounds_;
+    int level_;
+    std::vector<QTEntry> objects_;
+    std::unique_ptr<Tree> children_[4];
+    bool divided_ = false;
+};
+
+// ============================================================
+// ReferenceEngine
+// ============================================================
+
+ReferenceEngine::ReferenceEngine(uint64_t seed)
+    : rngSpawn_(seed, RNG_STREAM_SPAWN),
+      rngResource_(seed, RNG_STREAM_RESOURCE),
+      rngPickup_(seed, RNG_STREAM_PICKUP),
+      rngEffect_(seed, RNG_STREAM_EFFECT) {
+    tree_ = std::make_unique<Tree>(Rect{0, 0, MAP_WIDTH, MAP_HEIGHT});
+
+    for (int i = 0; i < MAX_RESOURCES / 2; ++i) {
+        spawnResources();
+        resourceSpawnAccum_ = 0.0f;
+    }
+}
+
+ReferenceEngine::~ReferenceEngine() = default;
+
+Vec2 ReferenceEngine::randomPosition(RngStream& rng) {
+    float x = rng.uniform(100.0f, MAP_WIDTH - 100.0f);
+    float y = rng.uniform(100.0f, MAP_HEIGHT - 100.0f);
+    return {x, y};
+}
+
+uint32_t ReferenceEngine::addPlayer() {
+    uint32_t pid = nextPlayerId_++;
+    Player p;
+    p.id = pid;
+    p.cursor = {MAP_WIDTH * 0.5f, MAP_HEIGHT * 0.5f};
+    players_[pid] = p;
+    spawnBoidsForPlayer(pid, INITIAL_BOIDS);
+    return pid;
+}
+
+void ReferenceEngine::removePlayer(uint32_t playerId) {
+    players_.erase(playerId);
+    boids_.erase(
+        std::remove_if(boids_.begin(), boids_.end(),
+            [playerId](const Boid& b) { return b.playerId == playerId; }),
+        boids_.end()
+    );
+}
+
+void ReferenceEngine::setPlayerCursor(uint32_t playerId, float x, float y) {
+    auto it = players_.find(playerId);
+    if (it != players_.end()) it->second.cursor = {x, y};
+}
+
+void ReferenceEngine::setPlayerBoost(uint32_t playerId, bool active) {
+    auto it = players_.find(playerId);
+    if (it != players_.end()) it->second.boosting = active;
+}
+
+void ReferenceEngine::injectInput(const InputCommand& cmd) {
+    inputQueue_.push_back(cmd);
+}
+
+void ReferenceEngine::applyQueuedInputs() {
+    for (auto& cmd : inputQueue_) {
+        auto it = players_.find(cmd.playerId);
+        if (it == players_.end()) continue;
+        Player& player = it->second;
+
+        if (player.hasInput && (int16_t)(uint16_t)(cmd.seq - player.lastInputSeq) <= 0) continue;
+        player.hasInput = true;
+        player.lastInputSeq = cmd.seq;
+        player.lastInputClientTime = cmd.clientTime;
+        player.cursor = {cmd.x, cmd.y};
+        player.boosting = cmd.boost;
+    }
+    inputQueue_.clear();
+}
+
+void ReferenceEngine::spawnBoidsForPlayer(uint32_t playerId, int count) {
+    Vec2 center = randomPosition(rngSpawn_);
+
+    for (int i = 0; i < count; ++i) {
+        Boid b;
+        b.id = nextBoidId_++;
+        b.playerId = playerId;
+        float sx = rngSpawn_.uniform(-30.0f, 30.0f);
+        float sy = rngSpawn_.uniform(-30.0f, 30.0f);
+        b.pos = {center.x + sx, center.y + sy};
+        float vx = rngSpawn_.uniform(-1.0f, 1.0f);
+        float vy = rngSpawn_.uniform(-1.0f, 1.0f);
+        b.vel = {vx, vy};
+        boids_.push_back(b);
+    }
+}
+
+void ReferenceEngine::spawnResources() {
+    int activeCount = 0;
+    for (auto& r : resources_) {
+        if (r.active) activeCount++;
+    }
+    if (activeCount >= MAX_RESOURCES) return;
+
+    Resource r;
+    r.id = nextResourceId_++;
+    r.pos = randomPosition(rngResource_);
+    r.value = rngResource_.range(RESOURCE_VALUE_MIN, RESOURCE_VALUE_MAX);
+    r.type = (uint8_t)rngResource_.range(0, 3);
+    r.active = true;
+    resources_.push_back(r);
+}
+
+void ReferenceEngine::buildQuadTree() {
+    tree_->clear();
+    for (uint32_t i = 0; i < (uint32_t)boids_.size(); ++i) {
+        tree_->insert({i, boids_[i].pos.x, boids_[i].pos.y});
+    }
+}
+
+void ReferenceEngine::applyBoidRules() {
+    std::vector<QTEntry> nearby;
+
+    for (auto& boid : boids_) {
+        auto pit = players_.find(boid.playerId);
+        if (pit == players_.end()) continue;
+        const Player& player = pit->second;
+        const Mutations& mut = player.mutations;
+
+        float effectiveCohesionRadius = COHESION_RADIUS * mut.cohesion;
+        float queryR = std::max({SEPARATION_RADIUS, ALIGNMENT_RADIUS, effectiveCohesionRadius, BOID_BASE_AGGRESSION * mut.aggression});
+
+        Rect queryRect = {
+            boid.pos.x - queryR, boid.pos.y - queryR,
+            queryR * 2.0f, queryR * 2.0f
+        };
+
+        nearby.clear();
+        tree_->query(queryRect, nearby);
+
+        Vec2 separation = {0, 0};
+        Vec2 alignment  = {0, 0};
+        Vec2 cohesionCenter = {0, 0};
+        int  alignCount = 0;
+        int  cohesionCount = 0;
+
+        float closestEnemyDist = 1e9f;
+        int closestEnemyIdx = -1;
+
+        for (auto& ne : nearby) {
+            if (ne.boidIndex == (uint32_t)(&boid - &boids_[0])) continue;
+
+            const Boid& other = boids_[ne.boidIndex];
+            Vec2 diff = boid.pos - other.pos;
+            float dist = std::sqrt(diff.lengthSq());
+
+            if (other.playerId == boid.playerId) {
+                if (dist < SEPARATION_RADIUS && dist > 0.01f) {
+                    separation += diff * (1.0f / dist);
+                }
+                if (dist < ALIGNMENT_RADIUS) {
+                    alignment += other.vel;
+                    alignCount++;
+                }
+                if (dist < effectiveCohesionRadius) {
+                    cohesionCenter += other.pos;
+                    cohesionCount++;
+                }
+            } else {
+                float aggroRange = BOID_BASE_AGGRESSION * mut.aggression;
+                if (dist < aggroRange && dist < closestEnemyDist) {
+                    closestEnemyDist = dist;
+                    closestEnemyIdx = (int)ne.boidIndex;
+                }
+            }
+        }
+
+        Vec2 steer = {0, 0};
+        steer += separation * SEPARATION_WEIGHT;
+
+        if (alignCount > 0) {
+            alignment = alignment * (1.0f / (float)alignCount);
+            Vec2 alignSteer = alignment - boid.vel;
+            alignSteer.clampLength(0.5f);
+            steer += alignSteer * ALIGNMENT_WEIGHT;
+        }
+
+        if (cohesionCount > 0) {
+            cohesionCenter = cohesionCenter * (1.0f / (float)cohesionCount);
+            Vec2 toCenter = cohesionCenter - boid.pos;
+            toCenter.clampLength(0.5f);
+            steer += toCenter * (COHESION_WEIGHT * mut.cohesion);
+        }
+
+        Vec2 toCursor = player.cursor - boid.pos;
+        if (toCursor.length() > 5.0f) {
+            steer += toCursor.normalized() * CURSOR_WEIGHT;
+        }
+
+        if (closestEnemyIdx >= 0) {
+            Vec2 toEnemy = (boids_[closestEnemyIdx].pos - boid.pos).normalized();
+            steer += toEnemy * (1.5f * mut.aggression);
+        }
+
+        boid.vel += steer;
+
+        float maxSpeed = BOID_BASE_SPEED * mut.speed;
+        if (player.boosting && player.boostFuel > 0.0f) maxSpeed *= BOOST_SPEED_MULT;
+        if (player.speedBurstTicks > 0) maxSpeed *= SPEED_BURST_MULT;
+        if (player.slowTicks > 0)       maxSpeed *= SLOW_MULT;
+        boid.vel.clampLength(maxSpeed);
+
+        boid.pos += boid.vel;
+    }
+}
+
+void ReferenceEngine::collectResources() {
+    for (auto& res : resources_) {
+        if (!res.active) continue;
+
+        float maxRange = BOID_BASE_COLLECT_RANGE * 3.0f;
+        Rect queryRect = {
+            res.pos.x - maxRange, res.pos.y - maxRange,
+            maxRange * 2.0f, maxRange * 2.0f
+        };
+
+        std::vector<QTEntry> nearby;
+        tree_->query(queryRect, nearby);
+
+        for (auto& ne : nearby) {
+            const Boid& b = boids_[ne.boidIndex];
+            auto pit = players_.find(b.playerId);
+            if (pit == players_.end()) continue;
+
+            float collectRange = BOID_BASE_COLLECT_RANGE * pit->second.mutations.collectRange;
+            Vec2 diff = b.pos - res.pos;
+            if (diff.lengthSq() < collectRange * collectRange) {
+                res.active = false;
+                Player& player = pit->second;
+                player.score += res.value;
+
+                float boost = 0.02f * res.value;
+                switch (res.type) {
+                    case 0: player.mutations.speed        += boost; break;
+                    case 1: player.mutations.cohesion     += boost; break;
+                    case 2: player.mutations.aggression   += boost; break;
+                    case 3: player.mutations.collectRange += boost; break;
+                }
+
+                int boidCount = 0;
+                for (auto& bb : boids_) {
+                    if (bb.playerId == player.id) boidCount++;
+                }
+                if (boidCount < MAX_BOIDS_PER_PLAYER && player.score % 3 == 0) {
+                    Boid nb;
+                    nb.id = nextBoidId_++;
+                    nb.playerId = player.id;
+                    nb.pos = b.pos;
+                    nb.vel = {0, 0};
+                    boids_.push_back(nb);
+                }
+                break;
+            }
+        }
+    }
+
+    resources_.erase(
+        std::remove_if(resources_.begin(), resources_.end(),
+            [](const Resource& r) { return !r.active; }),
+        resources_.end()
+    );
+}
+
+void ReferenceEngine::handleCombat() {
+    std::vector<uint32_t> toRemove;
+
+    std::unordered_map<uint32_t, int> boidCounts;
+    for (auto& b : boids_) boidCounts[b.playerId]++;
+
+    float combatRadiusSq = COMBAT_ABSORB_RADIUS * COMBAT_ABSORB_RADIUS;
+
+    for (uint32_t i = 0; i < (uint32_t)boids_.size(); ++i) {
+        Rect queryRect = {
+            boids_[i].pos.x - COMBAT_ABSORB_RADIUS,
+            boids_[i].pos.y - COMBAT_ABSORB_RADIUS,
+            COMBAT_ABSORB_RADIUS * 2.0f,
+            COMBAT_ABSORB_RADIUS * 2.0f
+        };
+
+        std::vector<QTEntry> nearby;
+        tree_->query(queryRect, nearby);
+
+        for (auto& ne : nearby) {
+            if (ne.boidIndex == i) continue;
+            const Boid& other = boids_[ne.boidIndex];
+            if (other.playerId == boids_[i].playerId) continue;
+
+            Vec2 diff = boids_[i].pos - other.pos;
+            if (diff.lengthSq() < combatRadiusSq) {
+                int myCount    = boidCounts[boids_[i].playerId];
+                int otherCount = boidCounts[other.playerId];
+
+                auto myPlayer = players_.find(boids_[i].playerId);
+                auto otherPlayer = players_.find(other.playerId);
+                bool myShield = (myPlayer != players_.end() && myPlayer->second.shieldTicks > 0);
+                bool otherShield = (otherPlayer != players_.end() && otherPlayer->second.shieldTicks > 0);
+
+                if (myCount < otherCount && !myShield) {
+                    toRemove.push_back(i);
+                    boidCounts[boids_[i].playerId]--;
+                    break;
+                } else if (otherCount < myCount && !otherShield) {
+                    toRemove.push_back(ne.boidIndex);
+                    boidCounts[other.playerId]--;
+                }
+            }
+        }
+    }
+
+    std::sort(toRemove.begin(), toRemove.end());
+    toRemove.erase(std::unique(toRemove.begin(), toRemove.end()), toRemove.end());
+    for (int i = (int)toRemove.size() - 1; i >= 0; --i) {
+        if (toRemove[i] < boids_.size()) boids_.erase(boids_.begin() + toRemove[i]);
+    }
+}
+
+void ReferenceEngine::clampPositions() {
+    for (auto& b : boids_) {
+        if (b.pos.x < 0)          { b.pos.x = 0;          b.vel.x *= -0.5f; }
+        if (b.pos.x > MAP_WIDTH)  { b.pos.x = MAP_WIDTH;  b.vel.x *= -0.5f; }
+        if (b.pos.y < 0)          { b.pos.y = 0;          b.vel.y *= -0.5f; }
+        if (b.pos.y > MAP_HEIGHT) { b.pos.y = MAP_HEIGHT; b.vel.y *= -0.5f; }
+    }
+}
+
+void ReferenceEngine::spawnPickups() {
+    int activeCount = 0;
+    for (auto& p : pickups_) {
+        if (p.active) activeCount++;
+    }
+    if (activeCount >= MAX_PICKUPS) return;
+
+    pickupSpawnAccum_ += 1.0f;
+    if (pickupSpawnAccum_ < PICKUP_SPAWN_INTERVAL) return;
+    pickupSpawnAccum_ = 0.0f;
+
+    Pickup p;
+    p.id = nextPickupId_++;
+    p.pos = randomPosition(rngPickup_);
+    p.type = (uint8_t)rngPickup_.range(0, 7);
+    p.active = true;
+    pickups_.push_back(p);
+}
+
+// MINE rule: a mined boid is out of play at once (it can't collect the
+// rest of this step's pickups or be mined twice), but is only erased once
+// every pickup is resolved, preserving order, and combat then sees a
+// rebuilt index. Written by boid id rather than by index so it does not
+// share its bookkeeping with GameEngine's flag-and-sweep.
+static bool isMined(const std::vector<uint32_t>& minedIds, uint32_t boidId) {
+    return std::find(minedIds.begin(), minedIds.end(), boidId) != minedIds.end();
+}
+
+void ReferenceEngine::collectPickups() {
+    float radiusSq = PICKUP_COLLECT_RADIUS * PICKUP_COLLECT_RADIUS;
+    std::vector<uint32_t> minedIds;
+
+    for (auto& pickup : pickups_) {
+        if (!pickup.active) continue;
+
+        Rect queryRect = {
+            pickup.pos.x - PICKUP_COLLECT_RADIUS, pickup.pos.y - PICKUP_COLLECT_RADIUS,
+            PICKUP_COLLECT_RADIUS * 2.0f, PICKUP_COLLECT_RADIUS * 2.0f
+        };
+
+        std::vector<QTEntry> nearby;
+        tree_->query(queryRect, nearby);
+
+        for (auto& ne : nearby) {
+            const Boid& b = boids_[ne.boidIndex];
+            if (isMined(minedIds, b.id)) continue;
+            Vec2 diff = b.pos - pickup.pos;
+            if (diff.lengthSq() >= radiusSq) continue;
+
+            auto pit = players_.find(b.playerId);
+            if (pit == players_.end()) continue;
+            Player& player = pit->second;
+
+            pickup.active = false;
+
+            switch (pickup.type) {
+                case 0: // BOOST_REFILL
+                    player.boostFuel = 1.0f;
+                    break;
+                case 1: { // MASS_SPAWN
+                    int boidCount = 0;
+                    for (auto& bb : boids_) {
+                        if (bb.playerId == player.id) boidCount++;
+                    }
+                    int toSpawn = std::min(5, MAX_BOIDS_PER_PLAYER - boidCount);
+                    Vec2 origin = b.pos;
+                    for (int i = 0; i < toSpawn; ++i) {
+                        Boid nb;
+                        nb.id = nextBoidId_++;
+                        nb.playerId = player.id;
+                        float sx = rngEffect_.uniform(-20.0f, 20.0f);
+                        float sy = rngEffect_.uniform(-20.0f, 20.0f);
+                        nb.pos = {origin.x + sx, origin.y + sy};
+                        nb.vel = {0, 0};
+                        boids_.push_back(nb);
+                    }
+                    break;
+                }
+                case 2: // SHIELD
+                    player.shieldTicks = SHIELD_DURATION;
+                    break;
+                case 3: // SPEED_BURST
+                    player.speedBurstTicks = SPEED_BURST_DURATION;
+                    break;
+                case 4: // SLOW_TRAP
+                    player.slowTicks = SLOW_DURATION;
+                    break;
+                case 5: { // SCATTER_BOMB
+                    for (auto& bb : boids_) {
+                        if (bb.playerId != player.id) continue;
+                        Vec2 dir = bb.pos - pickup.pos;
+                        dir = dir.length() < 0.01f ? Vec2{1, 0} : dir.normalized();
+                        bb.vel = dir * SCATTER_FORCE;
+                    }
+                    break;
+                }
+                case 6: // DRAIN_TRAP
+                    player.boostFuel = 0.0f;
+                    player.boosting = false;
+                    break;
+                case 7: { // MINE — the player's newest boids still in play
+                    int killed = 0;
+                    for (auto it = boids_.rbegin(); it != boids_.rend() && killed < MINE_KILL_COUNT; ++it) {
+                        if (it->playerId != player.id || isMined(minedIds, it->id)) continue;
+                        minedIds.push_back(it->id);
+                        killed++;
+                    }
+                    break;
+                }
+            }
+            break;
+        }
+    }
+
+    pickups_.erase(
+        std::remove_if(pickups_.begin(), pickups_.end(),
+            [](const Pickup& p) { return !p.active; }),
+        pickups_.end()
+    );
+
+    if (!minedIds.empty()) {
+        boids_.erase(
+            std::remove_if(boids_.begin(), boids_.end(),
+                [&](const Boid& b) { return isMined(minedIds, b.id); }),
+            boids_.end()
+        );
+        buildQuadTree();
+    }
+}
+
+void ReferenceEngine::tickPlayerEffects() {
+    for (auto& [pid, player] : players_) {
+        if (player.shieldTicks > 0) player.shieldTicks--;
+        if (player.speedBurstTicks > 0) player.speedBurstTicks--;
+        if (player.slowTicks > 0) player.slowTicks--;
+    }
+}
+
+void ReferenceEngine::tick() {
+    applyQueuedInputs();
+
+    for (auto& [pid, player] : players_) {
+        if (player.boosting && player.boostFuel > 0.0f) {
+            player.boostFuel -= BOOST_DRAIN_RATE;
+            if (player.boostFuel <= 0.0f) {
+                player.boostFuel = 0.0f;
+                player.boosting = false;
+            }
+        } else if (!player.boosting && player.boostFuel < 1.0f) {
+            player.boostFuel += BOOST_RECHARGE_RATE;
+            if (player.boostFuel > 1.0f) player.boostFuel = 1.0f;
+        }
+        if (player.boosting && player.boostFuel < BOOST_MIN_FUEL) {
+            player.boosting = false;
+        }
+    }
+
+    tickPlayerEffects();
+
+    resourceSpawnAccum_ += RESOURCE_SPAWN_RATE;
+    while (resourceSpawnAccum_ >= 1.0f) {
+        spawnResources();
+        resourceSpawnAccum_ -= 1.0f;
+    }
+
+    spawnPickups();
+
+    buildQuadTree();
+    applyBoidRules();
+    clampPositions();
+    buildQuadTree();
+
+    collectResources();
+    collectPickups();
+    handleCombat();
+
+    for (auto& [pid, player] : players_) {
+        int count = 0;
+        for (auto& b : boids_) {
+            if (b.playerId == pid) count++;
+        }
+        if (count == 0 && player.alive) player.alive = false;
+    }
+
+    tick_++;
+}
+
+StateChecksum ReferenceEngine::checksum() const {
+    const uint32_t nextIds[4] = {nextPlayerId_, nextBoidId_, nextResourceId_, nextPickupId_};
+    const RngStream* const rngs[4] = {&rngSpawn_, &rngResource_, &rngPickup_, &rngEffect_};
+
+    StateChecksum sum;
+    sum.tick = tick_;
+    sum.part[CHK_WORLD]     = checksumWorld(tick_, nextIds, resourceSpawnAccum_, pickupSpawnAccum_, rngs);
+    sum.part[CHK_PLAYERS]   = checksumPlayers(players_);
+    sum.part[CHK_BOIDS]     = checksumBoids(boids_);
+    sum.part[CHK_RESOURCES] = checksumResources(resources_);
+    sum.part[CHK_PICKUPS]   = checksumPickups(pickups_);
+    return sum;
+}
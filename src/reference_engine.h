@@ -0,0 +1,73 @@
+#pragma once
+
+#include "engine.h"
+
+// ============================================================
+// ReferenceEngine
+// ============================================================
+// A frozen copy of the straightforward simulation (GameEngine::tick() as
+// of the replay/checksum work), with its own state and its own quadtree.
+// It exists only to be diffed against GameEngine (see differential.h):
+// optimized paths may restructure anything, but must reproduce this
+// engine's state, exactly or within a tolerance.
+//
+// Do not optimize this file. Change it only when gameplay is meant to
+// change, in the same commit as the engine.
+
+class ReferenceEngine {
+public:
+    explicit ReferenceEngine(uint64_t seed);
+    ~ReferenceEngine();
+
+    uint32_t addPlayer();
+    void     removePlayer(uint32_t playerId);
+    void     setPlayerCursor(uint32_t playerId, float x, float y);
+    void     setPlayerBoost(uint32_t playerId, bool active);
+    void     injectInput(const InputCommand& cmd);
+
+    void tick();
+    uint32_t currentTick() const { return tick_; }
+    StateChecksum checksum() const;
+
+    const std::unordered_map<uint32_t, Player>& players() const { return players_; }
+    const std::vector<Boid>&     boids()     const { return boids_; }
+    const std::vector<Resource>& resources() const { return resources_; }
+    const std::vector<Pickup>&   pickups()   const { return pickups_; }
+
+private:
+    class Tree;
+
+    Vec2 randomPosition(RngStream& rng);
+    void applyQueuedInputs();
+    void spawnBoidsForPlayer(uint32_t playerId, int count);
+    void spawnResources();
+    void buildQuadTree();
+    void applyBoidRules();
+    void collectResources();
+    void handleCombat();
+    void clampPositions();
+    void spawnPickups();
+    void collectPickups();
+    void tickPlayerEffects();
+
+    std::unordered_map<uint32_t, Player> players_;
+    std::vector<Boid>     boids_;
+    std::vector<Resource> resources_;
+    std::vector<Pickup>   pickups_;
+    std::vector<InputCommand> inputQueue_;
+    std::unique_ptr<Tree> tree_;
+
+    uint32_t tick_           = 0;
+    uint32_t nextPlayerId_   = 1;
+    uint32_t nextBoidId_     = 1;
+    uint32_t nextResourceId_ = 1;
+    uint32_t nextPickupId_   = 1;
+
+    float resourceSpawnAccum_ = 0.0f;
+    float pickupSpawnAccum_   = 0.0f;
+
+    RngStream rngSpawn_;
+    RngStream rngResource_;
+    RngStream rngPickup_;
+    RngStream rngEffect_;
+};
@@ -0,0 +1,449 @@
+#include "replay.h"
+#include "recorder.h"
+#include "lz.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// ============================================================
+// Record Parsing
+// ============================================================
+
+struct LogCursor {
+    const uint8_t* p;
+    const uint8_t* end;
+
+    bool varint(uint32_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (p >= end) return false;
+            uint8_t b = *p++;
+            v |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    bool read(T& v) {
+        if ((size_t)(end - p) < sizeof(T)) return false;
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    bool skip(size_t n) {
+        if ((size_t)(end - p) < n) return false;
+        p += n;
+        return true;
+    }
+};
+
+enum class ParseResult { Ok, Truncated, Corrupt };
+
+// Decodes one record at `pos`, advancing pos and the running tick. For
+// REC_KEYFRAME and REC_END, cmd.tick holds the record's own tick.
+template <typename Command>
+static ParseResult parseRecord(const uint8_t* data, size_t end, size_t& pos,
+                               uint32_t& tick, Command& cmd) {
+    LogCursor cur{data + pos, data + end};
+    if (cur.p >= cur.end) return ParseResult::Truncated;
+
+    cmd.type = *cur.p++;
+    bool ok = true;
+    switch (cmd.type) {
+        case REC_TICK: {
+            uint32_t delta;
+            ok = cur.varint(delta);
+            if (ok) tick += delta;
+            break;
+        }
+        case REC_JOIN:
+        case REC_LEAVE:
+            ok = cur.varint(cmd.playerId);
+            break;
+        case REC_CURSOR:
+            ok = cur.varint(cmd.playerId) && cur.read(cmd.x) && cur.read(cmd.y);
+            break;
+        case REC_BOOST:
+            ok = cur.varint(cmd.playerId) && cur.read(cmd.flag);
+            break;
+        case REC_INPUT:
+            ok = cur.varint(cmd.playerId) && cur.read(cmd.seq) && cur.read(cmd.x)
+                && cur.read(cmd.y) && cur.read(cmd.flag) && cur.read(cmd.clientTime);
+            break;
+        case REC_END: {
+            uint32_t endTick;
+            ok = cur.read(endTick);
+            if (ok) tick = endTick;
+            break;
+        }
+        case REC_CHECKSUM:
+            cmd.payload = cur.p;
+            ok = cur.skip(CHK_PART_COUNT * 8);
+            break;
+        case REC_KEYFRAME: {
+            uint32_t kfTick, length;
+            ok = cur.read(kfTick) && cur.read(length) && cur.skip(length);
+            if (ok) tick = kfTick;
+            break;
+        }
+        default:
+            return ParseResult::Corrupt;
+    }
+    if (!ok) return ParseResult::Truncated;
+
+    cmd.tick = tick;
+    pos = (size_t)(cur.p - data);
+    return ParseResult::Ok;
+}
+
+// ============================================================
+// ReplayArchive
+// ============================================================
+
+ReplayArchive::~ReplayArchive() {
+    close();
+}
+
+bool ReplayArchive::open(const std::string& path, std::string& error) {
+    close();
+
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) ::close(fd);
+        error = "cannot open replay archive " + path;
+        return false;
+    }
+    size_ = (size_t)st.st_size;
+    if (size_ > 0) {
+        void* m = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) {
+            data_ = (const uint8_t*)m;
+            mapped_ = true;
+        }
+    }
+    ::close(fd);
+#endif
+    if (!mapped_) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            error = "cannot open replay archive " + path;
+            return false;
+        }
+        owned_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = owned_.data();
+        size_ = owned_.size();
+    }
+
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    if (size_ < REC_HEADER_SIZE) {
+        error = "replay archive too short";
+        close();
+        return false;
+    }
+    memcpy(&magic, data_, 4);
+    memcpy(&version, data_ + 4, 2);
+    memcpy(&seed_, data_ + 8, 8);
+    if (magic != REC_MAGIC || version < 2 || version > REC_VERSION) {
+        error = "not a replay archive (or unsupported version)";
+        close();
+        return false;
+    }
+
+    if (!readIndex() && !scan(error)) {
+        close();
+        return false;
+    }
+    if (keyframes_.empty()) {
+        error = "replay archive has no keyframe";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ReplayArchive::close() {
+#ifdef __linux__
+    if (mapped_) munmap((void*)data_, size_);
+#endif
+    mapped_ = false;
+    owned_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    keyframes_.clear();
+    streamEnd_ = 0;
+    endTick_ = 0;
+    clean_ = false;
+    engine_ = nullptr;
+    havePending_ = false;
+    recordsApplied_ = 0;
+    joinsApplied_ = 0;
+    checksumsVerified_ = 0;
+    divergence_ = ReplayDivergence();
+}
+
+bool ReplayArchive::readIndex() {
+    if (size_ < REC_HEADER_SIZE + REC_FOOTER_SIZE) return false;
+
+    const uint8_t* f = data_ + size_ - REC_FOOTER_SIZE;
+    uint64_t indexOffset;
+    uint32_t count, firstTick, endTick, magic;
+    memcpy(&indexOffset, f, 8);
+    memcpy(&count, f + 8, 4);
+    memcpy(&firstTick, f + 12, 4);
+    memcpy(&endTick, f + 16, 4);
+    memcpy(&magic, f + 20, 4);
+    if (magic != REC_INDEX_MAGIC) return false;
+    if (indexOffset < REC_HEADER_SIZE
+        || indexOffset + (uint64_t)count * REC_INDEX_ENTRY + REC_FOOTER_SIZE != size_) return false;
+
+    keyframes_.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* e = data_ + indexOffset + (size_t)i * REC_INDEX_ENTRY;
+        memcpy(&keyframes_[i].tick, e, 4);
+        memcpy(&keyframes_[i].offset, e + 4, 8);
+        if (keyframes_[i].offset >= indexOffset) return false;
+    }
+    streamEnd_ = (size_t)indexOffset;
+    endTick_ = endTick;
+    clean_ = true;
+    return true;
+}
+
+bool ReplayArchive::scan(std::string& error) {
+    // No footer (crashed recorder): walk the records, stop at the last
+    // complete one
+    keyframes_.clear();
+    size_t pos = REC_HEADER_SIZE;
+    uint32_t tick = 0;
+    Command cmd{};
+    for (;;) {
+        size_t start = pos;
+        ParseResult r = parseRecord(data_, size_, pos, tick, cmd);
+        if (r == ParseResult::Corrupt) {
+            error = "corrupt replay archive at offset " + std::to_string(start);
+            return false;
+        }
+        if (r == ParseResult::Truncated) {
+            streamEnd_ = start;
+            break;
+        }
+        if (cmd.type == REC_KEYFRAME) keyframes_.push_back({cmd.tick, (uint64_t)start});
+        endTick_ = std::max(endTick_, tick);
+        if (cmd.type == REC_END) {
+            streamEnd_ = pos;
+            break;
+        }
+    }
+    return true;
+}
+
+// Index offsets are only known to lie before the index, so the record there
+// goes through the same parser as a scan: it must be a whole keyframe for
+// the indexed tick, inside the record stream
+bool ReplayArchive::loadKeyframe(GameEngine& engine, const Keyframe& kf, std::string& error) {
+    auto corrupt = [&]() {
+        error = "corrupt keyframe at tick " + std::to_string(kf.tick);
+        return false;
+    };
+    size_t pos = (size_t)kf.offset;
+    uint32_t tick = 0;
+    Command cmd{};
+    if (kf.offset < REC_HEADER_SIZE || kf.offset >= streamEnd_
+        || parseRecord(data_, streamEnd_, pos, tick, cmd) != ParseResult::Ok
+        || cmd.type != REC_KEYFRAME || cmd.tick != kf.tick) {
+        return corrupt();
+    }
+
+    const uint8_t* rec = data_ + kf.offset;
+    uint32_t length = 0, rawSize = 0;
+    memcpy(&length, rec + 5, 4);
+    if (length < 4) return corrupt();
+    memcpy(&rawSize, rec + 9, 4);
+    if (rawSize > REC_KEYFRAME_MAX_RAW) return corrupt();
+
+    std::vector<uint8_t> raw(rawSize);
+    if (!lzDecompress(rec + 13, length - 4, raw.data(), rawSize)) return corrupt();
+    if (!engine.loadState(raw.data(), raw.size(), error)) return false;
+
+    engine_ = &engine;
+    cursor_ = pos;   // just past the keyframe record
+    cursorTick_ = kf.tick;
+    havePending_ = false;
+    return true;
+}
+
+bool ReplayArchive::nextCommand(Command& cmd, std::string& error) {
+    for (;;) {
+        size_t start = cursor_;
+        ParseResult r = parseRecord(data_, streamEnd_, cursor_, cursorTick_, cmd);
+        if (r == ParseResult::Corrupt) {
+            error = "corrupt replay archive at offset " + std::to_string(start);
+            return false;
+        }
+        if (r == ParseResult::Truncated || cmd.type == REC_END) {
+            cursor_ = start;   // stay at the end
+            return false;
+        }
+        if (cmd.type != REC_TICK && cmd.type != REC_KEYFRAME) return true;
+    }
+}
+
+bool ReplayArchive::peek(std::string& error) {
+    if (!havePending_) havePending_ = nextCommand(pending_, error);
+    return havePending_;
+}
+
+bool ReplayArchive::apply(GameEngine& engine, const Command& cmd, std::string& error) {
+    switch (cmd.type) {
+        case REC_JOIN:
+            if (engine.addPlayer() != cmd.playerId) {
+                error = "replay diverged: player id mismatch at tick " + std::to_string(cmd.tick);
+                return false;
+            }
+            joinsApplied_++;
+            break;
+        case REC_LEAVE:
+            engine.removePlayer(cmd.playerId);
+            break;
+        case REC_CURSOR:
+            engine.setPlayerCursor(cmd.playerId, cmd.x, cmd.y);
+            break;
+        case REC_BOOST:
+            engine.setPlayerBoost(cmd.playerId, cmd.flag != 0);
+            break;
+        case REC_INPUT: {
+            InputCommand in;
+            in.playerId   = cmd.playerId;
+            in.seq        = cmd.seq;
+            in.x          = cmd.x;
+            in.y          = cmd.y;
+            in.boost      = cmd.flag != 0;
+            in.clientTime = cmd.clientTime;
+            engine.injectInput(in);
+            break;
+        }
+        case REC_CHECKSUM: {
+            StateChecksum recorded;
+            memcpy(recorded.part, cmd.payload, sizeof(recorded.part));
+            StateChecksum actual = engine.checksum();
+            int part = recorded.firstDifference(actual);
+            if (part >= 0 && !divergence_.found) {
+                divergence_.found    = true;
+                divergence_.tick     = cmd.tick;
+                divergence_.part     = part;
+                divergence_.expected = recorded.part[part];
+                divergence_.actual   = actual.part[part];
+            }
+            checksumsVerified_++;
+            break;
+        }
+    }
+    recordsApplied_++;
+    return true;
+}
+
+bool ReplayArchive::seek(GameEngine& engine, uint32_t tick, std::string& error) {
+    tick = std::clamp(tick, firstTick(), endTick_);
+
+    auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), tick,
+        [](uint32_t t, const Keyframe& kf) { return t < kf.tick; });
+    const Keyframe& kf = *(it - 1);
+
+    // Already between that keyframe and the target: just keep simulating
+    bool onTheWay = engine_ == &engine
+        && engine.currentTick() <= tick && engine.currentTick() >= kf.tick;
+    if (!onTheWay && !loadKeyframe(engine, kf, error)) return false;
+
+    return advance(engine, tick, error);
+}
+
+bool ReplayArchive::advance(GameEngine& engine, uint32_t tick, std::string& error,
+                            std::vector<double>* tickMs) {
+    if (engine_ != &engine) {
+        error = "engine is not positioned in this archive (seek first)";
+        return false;
+    }
+    tick = std::min(tick, endTick_);
+
+    while (engine.currentTick() < tick) {
+        // Commands tagged with the current tick run before it
+        for (;;) {
+            if (!peek(error)) {
+                if (!error.empty()) return false;
+                break;
+            }
+            if (pending_.tick > engine.currentTick()) break;
+            if (!apply(engine, pending_, error)) return false;
+            havePending_ = false;
+        }
+
+        if (tickMs) {
+            auto t0 = std::chrono::steady_clock::now();
+            engine.tick();
+            auto t1 = std::chrono::steady_clock::now();
+            tickMs->push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        } else {
+            engine.tick();
+        }
+    }
+
+    // The checksum of the tick we stopped at, if one was recorded
+    while (peek(error) && pending_.type == REC_CHECKSUM && pending_.tick == engine.currentTick()) {
+        apply(engine, pending_, error);
+        havePending_ = false;
+    }
+    return error.empty();
+}
+
+// ============================================================
+// Replay Driver
+// ============================================================
+
+bool replayLog(const std::string& path, ReplayResult& out, std::string& error) {
+    ReplayArchive archive;
+    if (!archive.open(path, error)) return false;
+
+    GameEngine engine(archive.seed());
+    if (!archive.seek(engine, archive.firstTick(), error)) return false;
+
+    std::vector<double> tickMs;
+    if (!archive.advance(engine, archive.endTick(), error, &tickMs)) return false;
+
+    out.seed      = archive.seed();
+    out.firstTick = archive.firstTick();
+    out.keyframes = (uint32_t)archive.keyframes().size();
+    out.clean     = archive.clean();
+    out.records   = archive.recordsApplied();
+    out.players   = archive.joinsApplied();
+    out.checksums = archive.checksumsVerified();
+    out.divergence = archive.divergence();
+    out.ticks     = (uint32_t)tickMs.size();
+    if (!tickMs.empty()) {
+        auto slowest = std::max_element(tickMs.begin(), tickMs.end());
+        out.maxMs   = *slowest;
+        out.maxTick = out.firstTick + (uint32_t)(slowest - tickMs.begin());
+        for (double ms : tickMs) out.totalMs += ms;
+        out.meanMs = out.totalMs / tickMs.size();
+
+        std::vector<double> sorted = tickMs;
+        std::sort(sorted.begin(), sorted.end());
+        out.p50Ms = sorted[sorted.size() / 2];
+        out.p99Ms = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+    }
+    out.finalState = engine.serializeState();
+    return true;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GameEngine;
+
+// First recorded checksum the re-simulation failed to reproduce
+struct ReplayDivergence {
+    bool     found = false;
+    uint32_t tick  = 0;
+    int      part  = -1;      // ChecksumPart of the first differing subsystem
+    uint64_t expected = 0;    // recorded hash of that part
+    uint64_t actual   = 0;    // re-simulated hash
+};
+
+// ============================================================
+// ReplayArchive
+// ============================================================
+// Read side of the replay archive (format in recorder.h). The file is
+// mapped read-only, so opening is O(index) and seeking only touches the
+// pages between the chosen keyframe and the target tick.
+//
+// seek() rebuilds the engine at a tick: it loads the nearest keyframe at
+// or before it, unless the engine is already on the way there, and
+// re-simulates forward. "At tick T" means after T ticks, before the
+// commands tagged T, which matches a live snapshot taken after tick T.
+// Recorded checksums met on the way are verified against the engine; the
+// first mismatch is kept in divergence().
+
+class ReplayArchive {
+public:
+    struct Keyframe {
+        uint32_t tick;
+        uint64_t offset;
+    };
+
+    ReplayArchive() = default;
+    ~ReplayArchive();
+
+    ReplayArchive(const ReplayArchive&) = delete;
+    ReplayArchive& operator=(const ReplayArchive&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    uint64_t seed()      const { return seed_; }
+    uint32_t firstTick() const { return keyframes_.empty() ? 0 : keyframes_.front().tick; }
+    uint32_t endTick()   const { return endTick_; }
+    bool     clean()     const { return clean_; }   // footer present
+    const std::vector<Keyframe>& keyframes() const { return keyframes_; }
+
+    bool seek(GameEngine& engine, uint32_t tick, std::string& error);
+
+    // Simulates from the engine's current tick to `tick` (clamped to the
+    // end), applying recorded commands; optionally times every tick
+    bool advance(GameEngine& engine, uint32_t tick, std::string& error,
+                 std::vector<double>* tickMs = nullptr);
+
+    uint64_t recordsApplied() const { return recordsApplied_; }
+    uint32_t joinsApplied()   const { return joinsApplied_; }
+    uint32_t checksumsVerified() const { return checksumsVerified_; }
+    const ReplayDivergence& divergence() const { return divergence_; }
+
+private:
+    // One decoded command; REC_TICK / REC_KEYFRAME are consumed internally
+    struct Command {
+        uint8_t  type;
+        uint32_t tick;
+        uint32_t playerId;
+        float    x, y;
+        uint8_t  flag;
+        uint16_t seq;
+        uint32_t clientTime;
+        const uint8_t* payload;   // REC_CHECKSUM: hashes in the archive
+    };
+
+    bool readIndex();
+    bool scan(std::string& error);
+    bool loadKeyframe(GameEngine& engine, const Keyframe& kf, std::string& error);
+    bool nextCommand(Command& cmd, std::string& error);
+    bool peek(std::string& error);
+    bool apply(GameEngine& engine, const Command& cmd, std::string& error);
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<uint8_t> owned_;   // non-mmap fallback
+    bool mapped_ = false;
+
+    uint64_t seed_ = 0;
+    uint32_t endTick_ = 0;
+    bool clean_ = false;
+    size_t streamEnd_ = 0;         // records end here (index start)
+    std::vector<Keyframe> keyframes_;
+
+    // Cursor into the record stream, valid while engine_ is the engine we
+    // last seeked (its tick must not be moved by anyone else)
+    const GameEngine* engine_ = nullptr;
+    size_t   cursor_ = 0;
+    uint32_t cursorTick_ = 0;
+    bool     havePending_ = false;
+    Command  pending_{};
+
+    uint64_t recordsApplied_ = 0;
+    uint32_t joinsApplied_ = 0;
+    uint32_t checksumsVerified_ = 0;
+    ReplayDivergence divergence_;
+};
+
+// ============================================================
+// Headless Replay
+// ============================================================
+// Re-simulates a whole archive on a fresh engine as fast as the CPU
+// allows, timing every tick. The result carries the final snapshot so two
+// runs (or a run and the live server) can be compared byte-for-byte.
+
+struct ReplayResult {
+    uint64_t seed    = 0;
+    uint32_t firstTick = 0;
+    uint32_t ticks   = 0;
+    uint64_t records = 0;
+    uint32_t players = 0;      // joins seen in the log
+    uint32_t keyframes = 0;
+    uint32_t checksums = 0;    // recorded checksums verified
+    ReplayDivergence divergence;
+
+    double totalMs = 0.0;      // simulation time only (log parsing excluded)
+    double meanMs  = 0.0;
+    double p50Ms   = 0.0;
+    double p99Ms   = 0.0;
+    double maxMs   = 0.0;
+    uint32_t maxTick = 0;      // tick index of the slowest tick
+
+    bool clean = false;        // log ended with a footer (not truncated)
+    std::vector<uint8_t> finalState;   // serializeState() after the last tick
+};
+
+bool replayLog(const std::string& path, ReplayResult& out, std::string& error);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+// ============================================================
+// Counter-based PRNG
+// ============================================================
+// Each draw is a pure function of (key, counter): the SplitMix64 finalizer
+// applied to key + counter * golden-ratio increment. A stream is just a
+// key and a counter, so streams are free to create, independent of each
+// other, and can be handed to parallel workers without sharing state.
+//
+// Keys are derived from the engine seed plus a stream id (and a worker
+// index for per-thread streams), so the same seed replays every stream
+// bit-for-bit regardless of how many other streams were consumed.
+
+static constexpr uint64_t RNG_GOLDEN = 0x9E3779B97F4A7C15ull;
+
+inline uint64_t rngMix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Subsystem streams; worker streams are RNG_STREAM_WORKER + worker index
+enum RngStreamId : uint32_t {
+    RNG_STREAM_SPAWN    = 1,   // boid spawn placement
+    RNG_STREAM_RESOURCE = 2,   // resource position / value / type
+    RNG_STREAM_PICKUP   = 3,   // pickup position / type
+    RNG_STREAM_EFFECT   = 4,   // pickup effects (mass spawn scatter, ...)
+    RNG_STREAM_WORKER   = 0x100
+};
+
+struct RngStream {
+    uint64_t key     = 0;
+    uint64_t counter = 0;
+
+    RngStream() = default;
+    RngStream(uint64_t seed, uint32_t stream, uint32_t worker = 0)
+        : key(rngMix64(seed ^ rngMix64(((uint64_t)stream << 32) | worker))) {}
+
+    uint64_t next() { return rngMix64(key + (++counter) * RNG_GOLDEN); }
+
+    // Random access without advancing the stream
+    uint64_t at(uint64_t n) const { return rngMix64(key + n * RNG_GOLDEN); }
+
+    uint32_t nextU32() { return (uint32_t)(next() >> 32); }
+
+    // [0, 1) with 24 bits of mantissa
+    float nextFloat() { return (float)(next() >> 40) * (1.0f / 16777216.0f); }
+
+    // [lo, hi)
+    float uniform(float lo, float hi) { return lo + (hi - lo) * nextFloat(); }
+
+    // [lo, hi] inclusive; multiply-shift instead of modulo (bias < 2^-32)
+    int range(int lo, int hi) {
+        uint64_t span = (uint64_t)(int64_t)(hi - lo) + 1;
+        return lo + (int)(((uint64_t)nextU32() * span) >> 32);
+    }
+};
@@ -0,0 +1,144 @@
+#include "spectator.h"
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// ============================================================
+// Delay Line
+// ============================================================
+
+SpectatorStream::~SpectatorStream() {
+    closeSink();
+}
+
+bool SpectatorStream::push(uint32_t tick, std::vector<uint8_t> payload, uint32_t delayTicks) {
+    pending_.push_back({tick, std::move(payload)});
+
+    size_t due = 0;
+    while (due < pending_.size() && tick - pending_[due].tick >= delayTicks) {
+        Frame& f = pending_[due++];
+        if (latest_.capacity() > 0) spare_.push_back(std::move(latest_));
+        latest_ = std::move(f.payload);
+        latestTick_ = f.tick;
+
+        stats_.frames++;
+        stats_.bytes += latest_.size();
+        writeSink(latestTick_, latest_);
+    }
+    pending_.erase(pending_.begin(), pending_.begin() + due);
+    if (due > 0) fresh_ = true;
+    return due > 0;
+}
+
+std::vector<uint8_t> SpectatorStream::recycle() {
+    if (spare_.empty()) return {};
+    std::vector<uint8_t> buf = std::move(spare_.back());
+    spare_.pop_back();
+    buf.clear();
+    return buf;
+}
+
+void SpectatorStream::clear() {
+    pending_.clear();
+    spare_.clear();
+    latest_.clear();
+    latestTick_ = 0;
+    fresh_ = false;
+}
+
+bool SpectatorStream::takeFresh() {
+    bool f = fresh_;
+    fresh_ = false;
+    return f;
+}
+
+SpectatorStats SpectatorStream::stats() const {
+    SpectatorStats s = stats_;
+    s.queued = (uint32_t)pending_.size();
+    return s;
+}
+
+// ============================================================
+// Relay Sink
+// ============================================================
+
+#ifdef __linux__
+
+bool SpectatorStream::openSink(const std::string& path, std::string& error) {
+    closeSink();
+    // O_NONBLOCK: a FIFO without a reader fails here (ENXIO) instead of
+    // blocking the tick thread, and a slow reader costs records, not ticks
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = "spectator sink " + path + ": " + strerror(errno);
+        return false;
+    }
+    sinkFd_ = fd;
+    return true;
+}
+
+void SpectatorStream::closeSink() {
+    if (sinkFd_ >= 0) close(sinkFd_);
+    sinkFd_ = -1;
+    sinkBacklog_.clear();
+}
+
+void SpectatorStream::flushSink() {
+    while (!sinkBacklog_.empty()) {
+        ssize_t n = write(sinkFd_, sinkBacklog_.data(), sinkBacklog_.size());
+        if (n > 0) {
+            stats_.sinkBytes += (uint64_t)n;
+            sinkBacklog_.erase(sinkBacklog_.begin(), sinkBacklog_.begin() + n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) closeSink();  // reader gone
+        return;
+    }
+}
+
+void SpectatorStream::writeSink(uint32_t tick, const std::vector<uint8_t>& payload) {
+    if (sinkFd_ < 0) return;
+
+    flushSink();
+    if (sinkFd_ < 0) return;
+    if (!sinkBacklog_.empty()) {
+        stats_.sinkDrops++;
+        return;
+    }
+
+    uint32_t len = (uint32_t)payload.size();
+    sinkBacklog_.resize(8 + payload.size());
+    memcpy(sinkBacklog_.data(), &tick, 4);
+    memcpy(sinkBacklog_.data() + 4, &len, 4);
+    memcpy(sinkBacklog_.data() + 8, payload.data(), payload.size());
+
+    // Nothing accepted at all: skip the record rather than start it late
+    ssize_t n = write(sinkFd_, sinkBacklog_.data(), sinkBacklog_.size());
+    if (n < 0) {
+        bool full = (errno == EAGAIN || errno == EWOULDBLOCK);
+        sinkBacklog_.clear();
+        if (full) stats_.sinkDrops++;
+        else closeSink();
+        return;
+    }
+    stats_.sinkBytes += (uint64_t)n;
+    sinkBacklog_.erase(sinkBacklog_.begin(), sinkBacklog_.begin() + n);
+}
+
+#else  // !__linux__ — relay sinks are Linux-only
+
+bool SpectatorStream::openSink(const std::string&, std::string& error) {
+    error = "spectator sink is only supported on Linux";
+    return false;
+}
+
+void SpectatorStream::closeSink() {}
+void SpectatorStream::flushSink() {}
+void SpectatorStream::writeSink(uint32_t, const std::vector<uint8_t>&) {}
+
+#endif
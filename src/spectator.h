@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================
+// SpectatorStream
+// ============================================================
+// Delay line for the spectator broadcast. The engine pushes one encoded
+// snapshot per spectator interval; a frame is released once it is older
+// than the configured delay, and the released frame is shared verbatim by
+// every spectator (native group broadcast, socket.io room, relay sink).
+//
+// Sink records (for relays reading a file or FIFO):
+//   [uint32] tick
+//   [uint32] payload length
+//   [bytes]  payload (same format as a state message)
+// The sink fd is non-blocking: a relay that stops reading loses whole
+// records, never the framing.
+
+struct SpectatorStats {
+    uint64_t frames    = 0;   // frames released
+    uint64_t bytes     = 0;   // payload bytes released
+    uint64_t sinkBytes = 0;   // bytes written to the sink
+    uint64_t sinkDrops = 0;   // records skipped because the sink was full
+    uint32_t queued    = 0;   // frames still inside the delay window
+};
+
+class SpectatorStream {
+public:
+    SpectatorStream() = default;
+    ~SpectatorStream();
+
+    SpectatorStream(const SpectatorStream&) = delete;
+    SpectatorStream& operator=(const SpectatorStream&) = delete;
+
+    // Appends to a file, or writes into an existing FIFO (which must
+    // already have a reader). Replaces any previously open sink.
+    bool openSink(const std::string& path, std::string& error);
+    void closeSink();
+
+    // Queues a frame encoded at `tick` and releases every frame that is at
+    // least delayTicks old. Returns true if a new frame was released.
+    bool push(uint32_t tick, std::vector<uint8_t> payload, uint32_t delayTicks);
+    void clear();
+
+    // An empty buffer for the next push(), reusing a released frame's
+    // storage once the delay line is full, so a warm stream never allocates
+    std::vector<uint8_t> recycle();
+
+    // Latest released frame (empty until the first release)
+    const std::vector<uint8_t>& latest() const { return latest_; }
+    uint32_t latestTick() const { return latestTick_; }
+
+    // True once per released frame; used by the single broadcasting consumer
+    bool takeFresh();
+
+    SpectatorStats stats() const;
+
+private:
+    struct Frame {
+        uint32_t tick;
+        std::vector<uint8_t> payload;
+    };
+
+    void writeSink(uint32_t tick, const std::vector<uint8_t>& payload);
+    void flushSink();
+
+    std::vector<Frame> pending_;            // oldest first; a few dozen frames at most
+    std::vector<std::vector<uint8_t>> spare_;
+    std::vector<uint8_t> latest_;
+    uint32_t latestTick_ = 0;
+    bool fresh_ = false;
+
+    int sinkFd_ = -1;
+    std::vector<uint8_t> sinkBacklog_;   // tail of a partially written record
+
+    SpectatorStats stats_;
+};
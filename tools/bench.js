@@ -0,0 +1,89 @@
+// ════════════════════════════════════════════════════════════
+// SwarmMind.io — Engine benchmark
+// ════════════════════════════════════════════════════════════
+//
+// Usage: node tools/bench.js [--players 100,500,1000] [--ticks 300]
+//                            [--warmup 100] [--rounds 20] [--seed 1]
+//                            [--mode classic|blitz|mega|horde]
+//
+// For each room size: joins the players, steers them with random cursors
+// (a third of them boosting) through --warmup ticks, then reports
+//   - whole ticks: ms per tick over --ticks ticks
+//   - boid kernels: ns per boid for every specialized applyBoidRules
+//     variant (boost / burst / slow combinations), timed on that world
+//   - which variants the simulated ticks actually dispatched to
+
+'use strict';
+
+const path = require('path');
+const engine = require(path.join(__dirname, '..', 'build', 'Release', 'swarmmind_engine.node'));
+
+function parseArgs(argv) {
+    const opts = { players: '100,500,1000', ticks: 300, warmup: 100, rounds: 20, seed: 1, mode: 'classic' };
+    for (let i = 2; i < argv.length; i += 2) {
+        const key = argv[i].replace(/^--/, '');
+        if (!(key in opts)) throw new Error(`unknown option --${key}`);
+        opts[key] = typeof opts[key] === 'string' ? argv[i + 1] : Number(argv[i + 1]);
+    }
+    return opts;
+}
+
+// mulberry32: small seedable PRNG for the steering
+function makeRng(seed) {
+    let a = seed >>> 0;
+    return () => {
+        a = (a + 0x6D2B79F5) >>> 0;
+        let t = a;
+        t = Math.imul(t ^ (t >>> 15), t | 1);
+        t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+}
+
+function effectName(effects) {
+    const parts = [];
+    if (effects & 1) parts.push('boost');
+    if (effects & 2) parts.push('burst');
+    if (effects & 4) parts.push('slow');
+    return parts.length ? parts.join('+') : 'plain';
+}
+
+function benchRoom(opts, players) {
+    const rnd = makeRng(opts.seed * 7919 + players);
+    engine.createEngine(BigInt(opts.seed), { mode: opts.mode });
+    const map = engine.getMapSize();
+    const ids = [];
+    for (let i = 0; i < players; i++) ids.push(engine.addPlayer());
+    const steer = () => {
+        for (const id of ids) {
+            if (rnd() < 0.05) engine.setPlayerCursor(id, rnd() * map.width, rnd() * map.height);
+            if (rnd() < 0.02) engine.setPlayerBoost(id, rnd() < 0.33);
+        }
+    };
+
+    for (let t = 0; t < opts.warmup; t++) { steer(); engine.tick(); }
+    const before = engine.getStats().kernels.map(k => k.boids);
+
+    let tickMs = 0;
+    for (let t = 0; t < opts.ticks; t++) {
+        steer();
+        const t0 = process.hrtime.bigint();
+        engine.tick();
+        tickMs += Number(process.hrtime.bigint() - t0) / 1e6;
+    }
+    const used = engine.getStats().kernels.map((k, i) => k.boids - before[i]);
+    const kernels = engine.benchKernels(opts.rounds);
+
+    console.log(`\n${players} players (${opts.mode}): ${(tickMs / opts.ticks).toFixed(3)} ms/tick over ${opts.ticks} ticks`);
+    console.log('  variant            ns/boid   boids stepped');
+    for (const k of kernels) {
+        console.log(`  ${effectName(k.effects).padEnd(18)} ${k.nsPerBoid.toFixed(1).padStart(7)}   ${String(used[k.effects]).padStart(13)}`);
+    }
+}
+
+function main() {
+    const opts = parseArgs(process.argv);
+    for (const players of String(opts.players).split(',').map(Number)) benchRoom(opts, players);
+}
+
+main();
@@ -0,0 +1,161 @@
+// ════════════════════════════════════════════════════════════
+// SwarmMind.io — Differential test: engine vs. reference engine
+// ════════════════════════════════════════════════════════════
+//
+// Usage: node tools/differential.js [--runs 20] [--seed 1] [--ticks 600]
+//                                   [--players 6] [--tolerance 0]
+//                                   [--scenario <file.json>]
+//                                   [--out differential-failure.json]
+//
+// Generates seeded random scenarios (joins, leaves, cursor moves, boosts,
+// input frames), runs each through GameEngine and the frozen
+// ReferenceEngine side by side and compares them after every tick:
+// bit-exact with --tolerance 0, otherwise floats within the tolerance.
+// On a divergence the scenario is shrunk (cut at the divergent tick, then
+// delta-debugged command by command) and written to --out; re-run it with
+// --scenario. Exit code 1 on any divergence.
+
+'use strict';
+
+const fs = require('fs');
+const path = require('path');
+const engine = require(path.join(__dirname, '..', 'build', 'Release', 'swarmmind_engine.node'));
+
+// Recorder RecordType values
+const TYPES = { join: 1, leave: 2, cursor: 3, boost: 4, input: 5 };
+const TYPE_NAMES = Object.fromEntries(Object.entries(TYPES).map(([k, v]) => [v, k]));
+
+function parseArgs(argv) {
+    const opts = { runs: 20, seed: 1, ticks: 600, players: 6, tolerance: 0, scenario: '', out: 'differential-failure.json' };
+    for (let i = 2; i < argv.length; i += 2) {
+        const key = argv[i].replace(/^--/, '');
+        if (!(key in opts)) throw new Error(`unknown option --${key}`);
+        opts[key] = typeof opts[key] === 'string' ? argv[i + 1] : Number(argv[i + 1]);
+    }
+    return opts;
+}
+
+// mulberry32: small seedable PRNG for scenario generation
+function makeRng(seed) {
+    let a = seed >>> 0;
+    return () => {
+        a = (a + 0x6D2B79F5) >>> 0;
+        let t = a;
+        t = Math.imul(t ^ (t >>> 15), t | 1);
+        t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+        return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+}
+
+// Cursors stay in the middle of the map so swarms meet, fight and collect
+function generate(opts, run) {
+    const rnd = makeRng(opts.seed * 7919 + run);
+    const commands = [];
+    const seqs = [];
+    const alive = [];
+    const join = (t) => { commands.push([t, TYPES.join, alive.length]); alive.push(true); seqs.push(0); };
+
+    join(0);
+    join(0);
+    for (let t = 0; t < opts.ticks; t++) {
+        if (alive.length < opts.players && rnd() < 0.01) join(t);
+        for (let slot = 0; slot < alive.length; slot++) {
+            if (!alive[slot]) continue;
+            const r = rnd();
+            const x = Math.fround(1200 + rnd() * 1600);
+            const y = Math.fround(1200 + rnd() * 1600);
+            if (r < 0.0015) {
+                commands.push([t, TYPES.leave, slot]);
+                alive[slot] = false;
+            } else if (r < 0.06) {
+                commands.push([t, TYPES.cursor, slot, x, y]);
+            } else if (r < 0.08) {
+                commands.push([t, TYPES.boost, slot, 0, 0, rnd() < 0.5 ? 1 : 0]);
+            } else if (r < 0.14) {
+                seqs[slot] = (seqs[slot] + 1 + (rnd() < 0.1 ? 40000 : 0)) & 0xffff;
+                commands.push([t, TYPES.input, slot, x, y, rnd() < 0.3 ? 1 : 0, seqs[slot]]);
+            }
+        }
+    }
+    return { seed: opts.seed * 1000003 + run + 1, ticks: opts.ticks, tolerance: opts.tolerance, commands };
+}
+
+function run(scenario) {
+    return engine.differential({ ...scenario, seed: BigInt(scenario.seed) });
+}
+
+// Cut at the divergent tick, then remove command chunks (halving) while
+// the engines still diverge
+function minimize(scenario, result) {
+    let best = { ...scenario, ticks: result.tick, commands: scenario.commands.filter(c => c[0] < result.tick) };
+    let bestResult = result;
+    let chunk = Math.max(1, best.commands.length >> 1);
+    let attempts = 0;
+
+    while (chunk >= 1 && best.commands.length > 0) {
+        let progress = false;
+        for (let i = 0; i < best.commands.length; ) {
+            const commands = best.commands.slice(0, i).concat(best.commands.slice(i + chunk));
+            const candidate = { ...best, commands };
+            const r = run(candidate);
+            attempts++;
+            if (r.diverged) {
+                best = { ...candidate, ticks: r.tick, commands: commands.filter(c => c[0] < r.tick) };
+                bestResult = r;
+                progress = true;
+            } else {
+                i += chunk;
+            }
+        }
+        if (!progress) chunk >>= 1;
+    }
+    return { scenario: best, result: bestResult, attempts };
+}
+
+// One command per line: [tick, "type", slot, x, y, flag, seq]
+function toJson(scenario) {
+    const commands = scenario.commands.map(([t, type, ...rest]) => '  ' + JSON.stringify([t, TYPE_NAMES[type], ...rest]));
+    return `{ "seed": ${scenario.seed}, "ticks": ${scenario.ticks}, "tolerance": ${scenario.tolerance},\n` +
+           ` "commands": [\n${commands.join(',\n')}\n ] }\n`;
+}
+
+function fromJson(json) {
+    return { ...json, commands: json.commands.map(([t, type, ...rest]) => [t, TYPES[type], ...rest]) };
+}
+
+function report(label, scenario, r) {
+    const speed = r.engineMs > 0 ? ` | engine ${r.engineMs.toFixed(1)} ms, reference ${r.referenceMs.toFixed(1)} ms` : '';
+    if (!r.diverged) {
+        console.log(`[${label}] seed ${scenario.seed}: ${scenario.ticks} ticks, ${scenario.commands.length} commands match` +
+                    (scenario.tolerance > 0 ? ` (max error ${r.maxError.toExponential(2)})` : '') + speed);
+    } else {
+        console.log(`[${label}] seed ${scenario.seed}: DIVERGED after tick ${r.tick} in ${r.subsystem}: ${r.detail}`);
+    }
+}
+
+function main() {
+    const opts = parseArgs(process.argv);
+
+    if (opts.scenario) {
+        const scenario = fromJson(JSON.parse(fs.readFileSync(opts.scenario, 'utf8')));
+        const r = run(scenario);
+        report('scenario', scenario, r);
+        process.exit(r.diverged ? 1 : 0);
+    }
+
+    for (let i = 0; i < opts.runs; i++) {
+        const scenario = generate(opts, i);
+        const r = run(scenario);
+        report(`run ${i + 1}/${opts.runs}`, scenario, r);
+        if (!r.diverged) continue;
+
+        const min = minimize(scenario, r);
+        fs.writeFileSync(opts.out, toJson(min.scenario));
+        report('minimized', min.scenario, min.result);
+        console.log(`  ${min.scenario.commands.length} commands, ${min.scenario.ticks} ticks after ${min.attempts} attempts -> ${opts.out}`);
+        console.log(`  re-run: node tools/differential.js --scenario ${opts.out}`);
+        process.exit(1);
+    }
+}
+
+main();
@@ -0,0 +1,185 @@
+// ════════════════════════════════════════════════════════════
+// SwarmMind.io — Headless client for the native WebSocket server
+// ════════════════════════════════════════════════════════════
+//
+// Usage: node tools/headless-client.js [--host localhost] [--port 3002]
+//                                      [--clients 1] [--seconds 10]
+//                                      [--spectate 0]
+//
+// Opens N raw WebSocket connections (no dependencies), steers each swarm
+// with random cursor/boost inputs and reports snapshot rate and bandwidth.
+// With --spectate 1 the connections attach to the spectator stream instead.
+
+'use strict';
+
+const net = require('net');
+const crypto = require('crypto');
+
+const NATIVE_CH_STATE = 1;
+const NATIVE_CH_MINIMAP = 2;
+const INPUT_FRAME_SIZE = 12;
+const INPUT_FLAG_BOOST = 0x01;
+
+function parseArgs(argv) {
+    const opts = { host: 'localhost', port: 3002, clients: 1, seconds: 10, spectate: 0 };
+    for (let i = 2; i < argv.length; i += 2) {
+        const key = argv[i].replace(/^--/, '');
+        if (!(key in opts)) throw new Error(`unknown option --${key}`);
+        opts[key] = key === 'host' ? argv[i + 1] : Number(argv[i + 1]);
+    }
+    return opts;
+}
+
+// Client frames must be masked (RFC 6455 5.3)
+function encodeFrame(opcode, payload) {
+    const len = payload.length;
+    const header = len < 126 ? Buffer.alloc(2) : Buffer.alloc(4);
+    header[0] = 0x80 | opcode;
+    if (len < 126) {
+        header[1] = 0x80 | len;
+    } else {
+        header[1] = 0x80 | 126;
+        header.writeUInt16BE(len, 2);
+    }
+    const mask = crypto.randomBytes(4);
+    const body = Buffer.alloc(len);
+    for (let i = 0; i < len; i++) body[i] = payload[i] ^ mask[i & 3];
+    return Buffer.concat([header, mask, body]);
+}
+
+class HeadlessClient {
+    constructor(opts, stats) {
+        this.opts = opts;
+        this.stats = stats;
+        this.buf = Buffer.alloc(0);
+        this.upgraded = false;
+        this.playerId = 0;
+        this.timer = null;
+        this.seq = 0;
+        this.boost = false;
+    }
+
+    connect() {
+        const key = crypto.randomBytes(16).toString('base64');
+        this.expectedAccept = crypto.createHash('sha1')
+            .update(key + '258EAFA5-E914-47DA-95CA-C5AB0DC85B11').digest('base64');
+
+        this.sock = net.connect(this.opts.port, this.opts.host, () => {
+            this.sock.write(
+                `GET ${this.opts.spectate ? '/spectate' : '/'} HTTP/1.1\r\nHost: ${this.opts.host}:${this.opts.port}\r\n` +
+                'Upgrade: websocket\r\nConnection: Upgrade\r\n' +
+                `Sec-WebSocket-Key: ${key}\r\nSec-WebSocket-Version: 13\r\n\r\n`);
+        });
+        this.sock.on('data', (d) => this.onData(d));
+        this.sock.on('error', (err) => { this.stats.errors++; console.error('[client]', err.message); });
+        this.sock.on('close', () => clearInterval(this.timer));
+    }
+
+    onData(data) {
+        this.buf = Buffer.concat([this.buf, data]);
+
+        if (!this.upgraded) {
+            const end = this.buf.indexOf('\r\n\r\n');
+            if (end < 0) return;
+            const head = this.buf.slice(0, end).toString();
+            this.buf = this.buf.slice(end + 4);
+            if (!head.startsWith('HTTP/1.1 101') || !head.includes(this.expectedAccept)) {
+                this.stats.errors++;
+                console.error('[client] handshake rejected:', head.split('\r\n')[0]);
+                this.sock.destroy();
+                return;
+            }
+            this.upgraded = true;
+        }
+
+        while (this.buf.length >= 2) {
+            const opcode = this.buf[0] & 0x0f;
+            let len = this.buf[1] & 0x7f;
+            let hdr = 2;
+            if (len === 126) {
+                if (this.buf.length < 4) return;
+                len = this.buf.readUInt16BE(2);
+                hdr = 4;
+            } else if (len === 127) {
+                if (this.buf.length < 10) return;
+                len = Number(this.buf.readBigUInt64BE(2));
+                hdr = 10;
+            }
+            if (this.buf.length < hdr + len) return;
+            const payload = this.buf.slice(hdr, hdr + len);
+            this.buf = this.buf.slice(hdr + len);
+            this.onMessage(opcode, payload);
+        }
+    }
+
+    onMessage(opcode, payload) {
+        this.stats.bytes += payload.length;
+        if (opcode === 0x1) {
+            const msg = JSON.parse(payload.toString());
+            if (msg.type === 'init') {
+                this.playerId = msg.playerId;
+                this.stats.joined++;
+                if (!msg.spectator) this.startInputs(msg.mapWidth, msg.mapHeight);
+            }
+        } else if (opcode === 0x2) {
+            if (payload[0] === NATIVE_CH_STATE) this.stats.states++;
+            else if (payload[0] === NATIVE_CH_MINIMAP) this.stats.minimaps++;
+        } else if (opcode === 0x9) {
+            this.sock.write(encodeFrame(0xA, payload));
+        }
+    }
+
+    startInputs(mapWidth, mapHeight) {
+        let tx = Math.random() * mapWidth;
+        let ty = Math.random() * mapHeight;
+        this.timer = setInterval(() => {
+            if (Math.random() < 0.05) {
+                tx = Math.random() * mapWidth;
+                ty = Math.random() * mapHeight;
+            }
+            if (Math.random() < 0.02) this.boost = !this.boost;
+
+            const frame = Buffer.alloc(INPUT_FRAME_SIZE);
+            this.seq = (this.seq + 1) & 0xffff;
+            frame.writeUInt16LE(this.seq, 0);
+            frame.writeUInt16LE(Math.round(tx / mapWidth * 65535), 2);
+            frame.writeUInt16LE(Math.round(ty / mapHeight * 65535), 4);
+            frame[6] = this.boost ? INPUT_FLAG_BOOST : 0;
+            frame.writeUInt32LE(Date.now() >>> 0, 8);
+            this.sock.write(encodeFrame(0x2, frame));
+            this.stats.inputs++;
+        }, 50);
+    }
+
+    close() {
+        clearInterval(this.timer);
+        if (this.sock.writable) this.sock.end(encodeFrame(0x8, Buffer.from([0x03, 0xe8])));
+    }
+}
+
+function main() {
+    const opts = parseArgs(process.argv);
+    const stats = { joined: 0, states: 0, minimaps: 0, inputs: 0, bytes: 0, errors: 0 };
+    const clients = [];
+    for (let i = 0; i < opts.clients; i++) {
+        const c = new HeadlessClient(opts, stats);
+        c.connect();
+        clients.push(c);
+    }
+
+    const start = Date.now();
+    setTimeout(() => {
+        const secs = (Date.now() - start) / 1000;
+        for (const c of clients) c.close();
+        console.log(`[headless] ${opts.clients} clients, ${secs.toFixed(1)}s`);
+        console.log(`  joined:    ${stats.joined}`);
+        console.log(`  snapshots: ${stats.states} (${(stats.states / secs / Math.max(1, stats.joined)).toFixed(1)}/s per client)`);
+        console.log(`  minimaps:  ${stats.minimaps}`);
+        console.log(`  inputs:    ${stats.inputs}`);
+        console.log(`  received:  ${(stats.bytes / secs / 1024).toFixed(1)} KiB/s total`);
+        console.log(`  errors:    ${stats.errors}`);
+        setTimeout(() => process.exit(stats.errors || stats.joined < opts.clients ? 1 : 0), 200);
+    }, opts.seconds * 1000);
+}
+
+main();
@@ -0,0 +1,77 @@
+// ════════════════════════════════════════════════════════════
+// SwarmMind.io — Offline replay of a recorded archive
+// ════════════════════════════════════════════════════════════
+//
+// Usage: node tools/replay.js <archive> [--repeat 1] [--seek <tick>] [--verify]
+//
+// Re-simulates an archive written with RECORD=<path> (see server.js)
+// headlessly at full speed and reports per-tick timings. Runs are
+// deterministic, so every repeat must end in the same state; wrap with
+// `node --cpu-prof` or `perf record` to profile a production incident
+// offline. --seek times random access to one tick through the keyframe
+// index instead.
+//
+// Archives recorded with CHECKSUM=<ticks> carry per-tick state hashes.
+// Every replay checks them; --verify makes it the point of the run: it
+// fails without checksums and exits 1 at a divergence, naming the first
+// tick and subsystem that differ (e.g. after rewriting the boid rules).
+
+'use strict';
+
+const path = require('path');
+const engine = require(path.join(__dirname, '..', 'build', 'Release', 'swarmmind_engine.node'));
+
+function main() {
+    const args = process.argv.slice(2);
+    const repeatIdx = args.indexOf('--repeat');
+    const repeat = repeatIdx >= 0 ? Number(args[repeatIdx + 1]) : 1;
+    const seekIdx = args.indexOf('--seek');
+    const verify = args.includes('--verify');
+    const values = new Set([repeatIdx, seekIdx].filter(i => i >= 0).map(i => i + 1));
+    const file = args.find((a, i) => !a.startsWith('--') && !values.has(i));
+    if (!file) {
+        console.error('usage: node tools/replay.js <archive> [--repeat N] [--seek TICK] [--verify]');
+        process.exit(2);
+    }
+
+    if (seekIdx >= 0) {
+        const target = Number(args[seekIdx + 1]);
+        const info = engine.openReplay(file);
+        console.log(`[seek] seed ${info.seed} | ticks ${info.firstTick}..${info.endTick}, ${info.keyframes.length} keyframes${info.clean ? '' : ' (truncated archive, scanned)'}`);
+        const t0 = process.hrtime.bigint();
+        const state = engine.seekReplay(target);
+        const ms = Number(process.hrtime.bigint() - t0) / 1e6;
+        console.log(`  tick ${target}: ${state.byteLength} byte snapshot in ${ms.toFixed(2)} ms`);
+        engine.closeReplay();
+        return;
+    }
+
+    let firstState = null;
+    for (let i = 0; i < repeat; i++) {
+        const r = engine.replay(file);
+        const state = Buffer.from(r.state);
+        const match = firstState === null || state.equals(firstState);
+        if (firstState === null) firstState = state;
+
+        console.log(`[replay ${i + 1}/${repeat}] seed ${r.seed} | ${r.ticks} ticks, ${r.records} records, ${r.players} joins, ${r.keyframes} keyframes${r.clean ? '' : ' (truncated archive)'}`);
+        console.log(`  total ${r.totalMs.toFixed(1)} ms | mean ${r.meanMs.toFixed(3)} | p50 ${r.p50Ms.toFixed(3)} | p99 ${r.p99Ms.toFixed(3)} | max ${r.maxMs.toFixed(3)} ms @ tick ${r.maxTick}`);
+        if (r.divergence) {
+            const d = r.divergence;
+            console.error(`  DIVERGED at tick ${d.tick} in ${d.subsystem} (recorded ${d.expected.toString(16)}, got ${d.actual.toString(16)}); ${r.checksums} checksums checked`);
+            process.exit(1);
+        }
+        if (verify) {
+            if (r.checksums === 0) {
+                console.error('  no checksums in this archive (record with CHECKSUM=<ticks>)');
+                process.exit(1);
+            }
+            console.log(`  ${r.checksums} checksums verified, no divergence`);
+        }
+        if (!match) {
+            console.error('  final state differs from the first run: replay is not deterministic');
+            process.exit(1);
+        }
+    }
+}
+
+main();